@@ -17,12 +17,21 @@ class Module {
 public:
   /// Create a module for some target
   Module(Target target=getTargetFromEnvironment())
-    : lib_handle(nullptr), moduleFromUserSource(false), target(target) {
+    : lib_handle(nullptr), jit_state(nullptr), moduleFromUserSource(false),
+      target(target) {
     setJITLibname();
     setJITTmpdir();
   }
 
-  /// Compile the source into a library, returning its full path
+  ~Module();
+
+  /// Compile the source into a library, returning its full path. If the
+  /// TACO_CACHE_DIR environment variable is set, libraries are published to
+  /// and reused from that directory across processes, keyed by a hash of the
+  /// generated source and compiler invocation. The cache is bounded by
+  /// TACO_CACHE_MAX_SIZE megabytes (1024 by default). If the target selects
+  /// an in-process backend and it succeeds, no library is written and the
+  /// empty string is returned.
   std::string compile();
   
   /// Compile the module into a source file located at the specified location
@@ -63,6 +72,20 @@ public:
     return callFuncPacked(name, args.data());
   }
   
+  /// Call a raw function in this module once for every set of arguments in
+  /// `argsBatch`, spreading the calls over the threads of one parallel region
+  /// rather than parallelizing each call. Returns 0 if every call returns 0,
+  /// and otherwise the result of a failed call.
+  int callFuncPackedBatchRaw(std::string name,
+                             const std::vector<void**>& argsBatch);
+
+  /// Call a function using the taco_tensor_t interface once for every set of
+  /// arguments in `argsBatch` (see `callFuncPackedBatchRaw`)
+  int callFuncPackedBatch(std::string name,
+                          const std::vector<void**>& argsBatch) {
+    return callFuncPackedBatchRaw("_shim_"+name, argsBatch);
+  }
+
   /// Set the source of the module
   void setSource(std::string source);
   
@@ -72,6 +95,8 @@ private:
   std::string libname;
   std::string tmpdir;
   void* lib_handle;
+  // state of the in-process compiler, if it compiled this module
+  void* jit_state;
   std::vector<Stmt> funcs;
   
   // true iff the module was created from user-provided source
@@ -82,6 +107,24 @@ private:
   void setJITLibname();
   void setJITTmpdir();
 
+  /// Generate the source and header of the module's functions in memory.
+  void generateSource();
+
+  /// Write the generated source and header to path/prefix.{.c|.cu, .h}.
+  void writeSource(std::string path, std::string prefix);
+
+  /// Compile the module in-process, returning false if the target's backend
+  /// is unavailable or fails to compile the generated code.
+  bool compileInProcess();
+
+  /// Release the compiled code held by this module, after releasing the
+  /// workspace arenas of the code.
+  void unload();
+
+  /// Call the arena function `name` (taco_arenaRetain or taco_arenaRelease)
+  /// of the loaded code, if the code defines it.
+  void callArenaFunction(const std::string& name);
+
   static std::string chars;
   static std::default_random_engine gen;
   static std::uniform_int_distribution<int> randint;
@@ -64,7 +64,12 @@ public:
   /// Gets the type of the idx array for level i
   Datatype getCoordinateTypeIdx(size_t level) const;
 
-  /// Sets the types of the coordinate arrays for each level
+  /// Sets the types of the coordinate arrays for each level. A compressed
+  /// level takes a position type and a coordinate type, e.g. {Int64, Int16}
+  /// for a level with more than 2^31 entries and fewer than 2^15 coordinates.
+  /// Compiled kernels read and assemble the arrays in these types, which may
+  /// be any signed or unsigned integer type of up to 64 bits. The bit vector
+  /// of a bitmap level is UInt64 and the crd array of a hashed level signed.
   void setLevelArrayTypes(std::vector<std::vector<Datatype>> levelArrayTypes);
 
 private:
@@ -87,12 +92,20 @@ public:
   static ModeFormat dense;       /// e.g., first mode in CSR
   static ModeFormat compressed;  /// e.g., second mode in CSR
   static ModeFormat singleton;   /// e.g., second mode in COO
+  static ModeFormat hashed;      /// e.g., sparse accumulator rows
+  static ModeFormat bitmap;      /// e.g., columns of a medium-density matrix
+  static ModeFormat diagonal;    /// e.g., columns of a banded matrix
+  static ModeFormat ell;         /// e.g., columns of a sliced ELLPACK matrix
 
   static ModeFormat sparse;      /// alias for compressed
   static ModeFormat Dense;       /// alias for dense
   static ModeFormat Compressed;  /// alias for compressed
   static ModeFormat Sparse;      /// alias for compressed
   static ModeFormat Singleton;   /// alias for singleton
+  static ModeFormat Hashed;      /// alias for hashed
+  static ModeFormat Bitmap;      /// alias for bitmap
+  static ModeFormat Diagonal;    /// alias for diagonal
+  static ModeFormat Ell;         /// alias for ell
 
   /// Properties of a mode format
   enum Property {
@@ -162,6 +175,7 @@ private:
 
   friend class ModePack;
   friend class Iterator;
+  friend class EllModeFormat;
 };
 
 
@@ -190,19 +204,46 @@ extern const ModeFormat Dense;
 extern const ModeFormat Compressed;
 extern const ModeFormat Sparse;
 extern const ModeFormat Singleton;
+extern const ModeFormat Hashed;
+extern const ModeFormat Bitmap;
+extern const ModeFormat Diagonal;
+extern const ModeFormat Ell;
 
 extern const ModeFormat dense;
 extern const ModeFormat compressed;
 extern const ModeFormat sparse;
 extern const ModeFormat singleton;
+extern const ModeFormat hashed;
+extern const ModeFormat bitmap;
+extern const ModeFormat diagonal;
+extern const ModeFormat ell;
 
 extern const Format CSR;
 extern const Format CSC;
 extern const Format DCSR;
 extern const Format DCSC;
 
+/// Blocked CSR: a compressed matrix of dense tiles, for order-4 tensors
+/// indexed (block row, block column, row in tile, column in tile) such as
+/// those returned by `Tensor::block`.
+extern const Format BCSR;
+
+/// Diagonal format: the rows of a matrix store the values of a set of
+/// diagonals.
+extern const Format DIA;
+
 const Format COO(int order, bool isUnique = true, bool isOrdered = true, 
                  bool isAoS = false, const std::vector<int>& modeOrdering = {});
+
+/// Blocked CSF: an order-`order` CSF tensor of dense tiles, stored as an
+/// order-2*`order` tensor whose first modes index the tiles and whose last
+/// modes index into them.
+const Format BCSF(int order);
+
+/// Sliced ELLPACK (SELL-C-sigma): the rows of a matrix are sorted by length
+/// within windows of `sortWindow` rows, grouped into slices of `sliceHeight`
+/// rows, and every slice is padded to its longest row and stored column-major.
+const Format SELL(int sliceHeight = 8, int sortWindow = 1);
 /// @}
 
 /// True if all modes are dense.
@@ -193,6 +193,9 @@ public:
 /// Check if two index expressions are isomorphic.
 bool isomorphic(IndexExpr, IndexExpr);
 
+/// Hash an index expression such that isomorphic expressions have equal hashes.
+size_t structuralHash(IndexExpr);
+
 /// Compare two index expressions by value.
 bool equals(IndexExpr, IndexExpr);
 
@@ -640,6 +643,10 @@ public:
   /// All other iterators are merged with the "two finger" strategy.
   /// The two finger strategy merges by advancing each iterator one at a time, 
   /// while the gallop strategy implements the exponential search algorithm.
+  /// The simd gallop strategy gallops over blocks of coordinates and compares
+  /// the coordinates of the last block at once, using AVX2 instructions when
+  /// the generated code is compiled for them. Its preconditions are those of
+  /// gallop.
   /// 
   /// Preconditions:
   /// This command applies to variables involving sparse iterators only;
@@ -778,6 +785,9 @@ public:
 /// Check if two index statements are isomorphic.
 bool isomorphic(IndexStmt, IndexStmt);
 
+/// Hash an index statement such that isomorphic statements have equal hashes.
+size_t structuralHash(IndexStmt);
+
 /// Compare two index statments by value.
 bool equals(IndexStmt, IndexStmt);
 
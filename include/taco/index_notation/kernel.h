@@ -54,6 +54,16 @@ public:
   }
   /// @}
 
+  /// Evaluate, assemble, or compute the kernel once for every set of tensor
+  /// storage arguments in `batch`. The batch elements are spread over the
+  /// threads of one parallel region and each of them is executed on a single
+  /// thread, which amortizes the cost of a call over many small tensors.
+  /// @{
+  bool evaluateBatch(const std::vector<std::vector<TensorStorage>>& batch) const;
+  bool assembleBatch(const std::vector<std::vector<TensorStorage>>& batch) const;
+  bool computeBatch(const std::vector<std::vector<TensorStorage>>& batch) const;
+  /// @}
+
   /// Check whether the kernel is defined.
   bool defined();
 
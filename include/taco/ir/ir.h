@@ -94,7 +94,7 @@ struct IRNode : private util::Uncopyable {
    */
   virtual IRNodeType type_info() const = 0;
 
-  mutable long ref = 0;
+  mutable std::atomic<long> ref{0};
   friend void acquire(const IRNode* node) {
     ++(node->ref);
   }
@@ -259,7 +259,6 @@ TypedComponentVal toTypedComponentVal(T val, Datatype type) {
     case Datatype::Complex64:
     case Datatype::Complex128:
     case Datatype::UInt128:
-    case Datatype::CppType:
     case Datatype::Undefined:
     case Datatype::Int128:
     default:
@@ -828,6 +827,10 @@ struct Break : public StmtNode<Break> {
   static const IRNodeType _type_info = IRNodeType::Break;
 };
 
+/** Sorts a list of distinct indices in ascending order. The args are the
+ * list, its size, the dimension that bounds the indices, and a bit vector
+ * with the bits of the listed indices set.
+ */
 struct Sort : public StmtNode<Sort> {
   std::vector<Expr> args;
   static Stmt make(std::vector<Expr> args);
@@ -860,7 +863,7 @@ struct GetProperty : public ExprNode<GetProperty> {
 
   static Expr make(Expr tensor, TensorProperty property, int mode=0);
   static Expr make(Expr tensor, TensorProperty property, int mode,
-                   int index, std::string name);
+                   int index, std::string name, Datatype type=Int32);
   
   static const IRNodeType _type_info = IRNodeType::GetProperty;
 };
@@ -8,8 +8,12 @@ namespace taco {
 /// ParallelUnit::GPUBlock must be used with GPUThread to create blocks of GPU threads
 /// ParallelUnit::GPUWarp can be optionally used to allow for GPU warp-level primitives
 /// ParallelUnit::GPUThread causes for every iteration to be executed on a separate GPU thread
+/// ParallelUnit::CPUThreadBalanced parallelizes over CPU threads like CPUThread, but gives every
+///   thread the same number of nonzeros of the sparse level below the loop, whose iterations are
+///   found by binary searches of its pos array (falls back to CPUThread otherwise). Rows that only
+///   accumulate are split between threads, and the partial rows are added up after the loop
 enum class ParallelUnit {
-  NotParallel, DefaultUnit, GPUBlock, GPUWarp, GPUThread, CPUThread, CPUVector, CPUThreadGroupReduction, GPUBlockReduction, GPUWarpReduction
+  NotParallel, DefaultUnit, GPUBlock, GPUWarp, GPUThread, CPUThread, CPUVector, CPUThreadGroupReduction, GPUBlockReduction, GPUWarpReduction, CPUThreadBalanced
 };
 extern const char *ParallelUnit_NAMES[];
 
@@ -18,8 +22,11 @@ extern const char *ParallelUnit_NAMES[];
 /// OutputRaceStrategy::Temporary uses a temporary array for outputs that is serially reduced
 /// OutputRaceStrategy::ParallelReduction uses reduction operations across a warp/vector
 /// OutputRaceStrategy::IgnoreRaces allows the user to specify that races can be safely ignored
+/// OutputRaceStrategy::Privatize gives every CPU thread a private copy of dense outputs that are
+///   reduced by the loop, which are combined with a parallel tree reduction after the loop and
+///   kept zeroed in buffers that are reused across calls of the kernel
 enum class OutputRaceStrategy {
-  IgnoreRaces, NoRaces, Atomics, Temporary, ParallelReduction
+  IgnoreRaces, NoRaces, Atomics, Temporary, ParallelReduction, Privatize
 };
 extern const char *OutputRaceStrategy_NAMES[];
 
@@ -35,8 +42,14 @@ extern const char *AssembleStrategy_NAMES[];
 
 /// MergeStrategy::TwoFinger merges iterators by incrementing one at a time
 /// MergeStrategy::Galloping merges iterators by exponential search (galloping)
+/// MergeStrategy::SimdGallop gallops over blocks of coordinates and compares
+///   the coordinates of the last block at once with vector instructions. The
+///   intersection of two sorted, unique levels with the same index type
+///   compares whole blocks of both against each other (AVX2 for 32 and 64-bit
+///   coordinates, SSE2 for 8, 16 and 32-bit ones) and only merges one
+///   coordinate at a time when there are no vector instructions for the type
 enum class MergeStrategy {
-  TwoFinger, Gallop
+  TwoFinger, Gallop, SimdGallop
 };
 extern const char *MergeStrategy_NAMES[];
 
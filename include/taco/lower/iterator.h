@@ -173,6 +173,11 @@ public:
   ir::Stmt getSeqInsertEdge(const ir::Expr& parentPos, 
       const std::vector<ir::Expr>& coords, 
       const std::vector<AttrQueryResult>& queries) const;
+  ir::Stmt getParInsertEdge(const ir::Expr& parentPos,
+      const std::vector<ir::Expr>& coords,
+      const std::vector<AttrQueryResult>& queries) const;
+  ir::Stmt getParFinalizeEdges(const ir::Expr& prevSize,
+      const std::vector<AttrQueryResult>& queries) const;
   ir::Stmt getInitCoords(const ir::Expr& prevSize, 
       const std::vector<AttrQueryResult>& queries) const;
   ir::Stmt getInitYieldPos(const ir::Expr& prevSize) const;
@@ -84,6 +84,53 @@ protected:
                                         std::set<Access> reducedAccesses,
                                         ir::Stmt recoveryStmt);
 
+  /// Lower a forall over a dimension that locates into bitmap levels, and
+  /// whose body only accumulates. The loop iterates over the set bits of
+  /// `wordMask`, a word-wise AND/OR of the bitmaps that is computed for every
+  /// word of the dimension (see `lowerBitmapWordMask`).
+  virtual ir::Stmt lowerForallBitmap(Forall forall,
+                                     std::vector<Iterator> locaters,
+                                     std::vector<Iterator> inserters,
+                                     std::vector<Iterator> appenders,
+                                     MergeLattice caseLattice,
+                                     std::set<Access> reducedAccesses,
+                                     ir::Stmt recoveryStmt,
+                                     ir::Expr word, ir::Expr wordMask);
+
+  /// Returns a 64-bit mask of the coordinates in `word` of the forall index
+  /// var's dimension where `expr` may be nonzero, built from the words of the
+  /// bitmap locators: products AND the masks of their operands and sums OR
+  /// them. Returns an undefined expression if `expr` may be nonzero anywhere.
+  ir::Expr lowerBitmapWordMask(IndexExpr expr, IndexVar indexVar,
+                               const std::vector<Iterator>& locators,
+                               ir::Expr word);
+
+  /// Lower a forall over the rows of a matrix whose columns are stored in an
+  /// ell level, and whose rows only accumulate over that level (see
+  /// `getAccumulatedRows`). The rows are lowered a slice at a time: a loop over
+  /// the k-th entries of the slice's rows encloses a loop over its lanes, so
+  /// consecutive lanes access adjacent positions of the ell level.
+  virtual ir::Stmt lowerForallEllSlices(Forall forall,
+                                        std::vector<Iterator> locaters,
+                                        std::vector<Iterator> inserters,
+                                        std::vector<Iterator> appenders,
+                                        MergeLattice caseLattice,
+                                        std::set<Access> reducedAccesses,
+                                        ir::Stmt recoveryStmt,
+                                        IndexStmt rows, IndexStmt initRows,
+                                        Iterator ellIterator);
+
+  /// Returns the body of `forall` as a forall over a single position iterator
+  /// below the forall's loop (`rowIterator`), whose body accumulates into
+  /// results that do not depend on its index variable, so that rows can be
+  /// lowered in pieces (see `lowerForallEllSlices` and `getBalancedRows`). A
+  /// scalar temporary that the forall body accumulates into through a where
+  /// statement is replaced by its consumer, and `initRows` is set to zero the
+  /// consumer's result if the consumer assigns to it. Returns an undefined
+  /// statement if the forall body does not have this form.
+  IndexStmt getAccumulatedRows(Forall forall, Iterator* rowIterator,
+                               IndexStmt* initRows);
+
   /// Lower a forall that iterates over all the coordinates in the forall index
   /// var's dimension, and locates tensor positions from the locate iterators.
   virtual ir::Stmt lowerForallDenseAcceleration(Forall forall,
@@ -128,6 +175,52 @@ protected:
   /// search for the start of the iteration of the loop (a separate kernel on GPUs)
   virtual ir::Stmt searchForFusedPositionStart(Forall forall, Iterator posIterator);
 
+  /// Returns the pos array of an operand level below the loop of `forall`
+  /// over `loopVar`, where the positions below iteration p start at pos[p], or
+  /// an undefined expression if there is no such level. The level is a child
+  /// of `loopIterator`, or of a dense top level if `loopIterator` is undefined
+  /// (the loop iterates over a dimension).
+  ir::Expr getBalancePosArray(Forall forall, Iterator loopIterator,
+                              ir::Expr loopVar);
+
+  /// Returns the rows of the balanced loop of `forall` over `loopVar` if they
+  /// only accumulate over the level with `posArray` (see `getAccumulatedRows`),
+  /// so that the rows can be split between threads, or an undefined statement
+  /// otherwise. If the rows are returned, the position loops over the level
+  /// are bounded by the positions of the thread until `lowerBalancedLoop`.
+  IndexStmt getBalancedRows(Forall forall, ir::Expr loopVar,
+                            ir::Expr posArray);
+
+  /// Lower a loop over [begin, end) that is parallelized over CPU threads such
+  /// that every thread gets the same number of positions of the level with
+  /// `posArray`. Every thread iterates over the iterations that start in its
+  /// positions, and the bounds of these ranges are found by binary searches of
+  /// the pos array. If `carriedRow` is defined (see `getBalancedRows`), then
+  /// the last row of a thread only iterates up to the thread's positions, and
+  /// every thread also runs `carriedRow` over the row that the previous thread
+  /// stopped in. The results of the carried rows are kept per thread and added
+  /// once the threads are done. Otherwise every thread iterates over its rows
+  /// to their end.
+  ir::Stmt lowerBalancedLoop(ir::Expr loopVar, ir::Expr begin, ir::Expr end,
+                             ir::Expr posArray, ir::Stmt body,
+                             ir::Stmt carriedRow = ir::Stmt());
+
+  /// Privatize the dense results of `resultAccesses` that the loops of
+  /// `forall` race on (the loop's index variable does not index them). Every
+  /// thread of the parallel loop in `loops` accumulates into its own zeroed
+  /// copy of the values, and the copies are then added into the values with a
+  /// parallel tree reduction that zeroes them again, so that the buffer they
+  /// are in can be reused by the next call without zeroing it.
+  ir::Stmt privatizeResults(Forall forall, std::vector<Access> resultAccesses,
+                            ir::Stmt loops);
+
+  /// Returns an array of `size` components of `type` from a new buffer of the
+  /// workspace arena of the generated code, which is kept across calls and
+  /// only reallocated (and zeroed) when it grows. Arrays from the arena are not
+  /// freed. If `zeroed` is true, then the array is cleared on every call, and
+  /// otherwise it holds what the previous call left in it.
+  ir::Expr getArenaBuffer(ir::Expr size, Datatype type, bool zeroed=false);
+
     /**
      * Lower the merge lattice to code that iterates over the sparse iteration
      * space of coordinates and computes the concrete index notation statement.
@@ -342,8 +435,11 @@ protected:
    */
   ir::Stmt initValues(ir::Expr tensor, ir::Expr initVal, ir::Expr begin, ir::Expr size);
 
-  /// Declare position variables and initialize them with a locate.
-  ir::Stmt declLocatePosVars(std::vector<Iterator> iterators);
+  /// Declare position variables and initialize them with a locate. If
+  /// `insert` is set the iterators are inserters, and levels that store
+  /// coordinates at inserted positions also get their coordinates stored.
+  ir::Stmt declLocatePosVars(std::vector<Iterator> iterators,
+                             bool insert=false);
 
   /// Emit loops to reduce duplicate coordinates.
   ir::Stmt reduceDuplicateCoordinates(ir::Expr coordinate, 
@@ -575,8 +671,25 @@ private:
 
   bool emitUnderivedGuards = true;
 
+  /// Offset from the start of a row at which ell position loops access a
+  /// single position instead of iterating, while lowering the lanes of ell
+  /// slices
+  ir::Expr ellSliceOffset;
+
+  /// The level whose position loops are bounded by [balancedPosBegin,
+  /// balancedPosEnd), the positions of a thread of a balanced loop whose rows
+  /// are split between threads
+  Iterator balancedIterator;
+  ir::Expr balancedPosBegin;
+  ir::Expr balancedPosEnd;
+
   int inParallelLoopDepth = 0;
 
+  /// Number of workspace arena buffers used by the lowered function for
+  /// workspaces and for privatized results
+  int numWorkspaceBuffers = 0;
+  int numPrivateBuffers = 0;
+
   std::map<ParallelUnit, ir::Expr> parallelUnitSizes;
   std::map<ParallelUnit, IndexVar> parallelUnitIndexVars;
 
@@ -2,8 +2,10 @@
 #define TACO_MODE_H
 
 #include <string>
+#include <vector>
 
 #include "taco/format.h"
+#include "taco/type.h"
 
 namespace taco {
 
@@ -22,7 +24,8 @@ public:
 
   /// Construct a tensor mode.
   Mode(ir::Expr tensor, Dimension size, int mode, ModeFormat modeFormat,
-       ModePack modePack, size_t packLoc, ModeFormat parentModeFormat);
+       ModePack modePack, size_t packLoc, ModeFormat parentModeFormat,
+       Datatype positionType=Int32);
 
   /// Retrieve the name of the tensor mode.
   std::string getName() const;
@@ -49,6 +52,10 @@ public:
   /// Retrieve the mode type of the parent mode in the mode hierarchy.
   ModeFormat getParentModeType() const;
 
+  /// Retrieve the type of the positions of the mode, which is wide enough to
+  /// hold every position of this mode and of the modes above it.
+  Datatype getPositionType() const;
+
   /// Store temporary variables that may be needed to access or modify a mode
   /// @{
   ir::Expr getVar(std::string varName) const;
@@ -74,12 +81,13 @@ class ModePack {
 public:
   ModePack();
   ModePack(size_t numModes, ModeFormat modeType, ir::Expr tensor, int mode, 
-           int level);
+           int level, std::vector<Datatype> arrayTypes={});
 
   /// Returns number of tensor modes belonging to mode pack.
   size_t getNumModes() const;
 
-  /// Returns arrays shared by tensor modes.
+  /// Returns arrays shared by tensor modes, or an undefined expression if the
+  /// mode format does not have array `i`.
   ir::Expr getArray(size_t i) const;
 
 private:
@@ -0,0 +1,52 @@
+#ifndef TACO_MODE_FORMAT_BITMAP_H
+#define TACO_MODE_FORMAT_BITMAP_H
+
+#include "taco/lower/mode_format_impl.h"
+
+namespace taco {
+
+/// A bitmap level stores the coordinates below each parent position as a bit
+/// vector of `ceil(dimension / 64)` 64-bit words, and stores the children of
+/// the set bits packed. The level has two arrays: a rank array with the
+/// position of the first set bit of every word (plus one trailing entry with
+/// the size of the level), and the bits array. Locating a coordinate computes
+/// its position as the rank of its word plus the population count of the
+/// lower bits of the word.
+///
+/// Position 0 of the level is reserved and holds the fill value (or a subtree
+/// of fill values), so coordinates whose bit is not set are located there and
+/// locate always succeeds. Loops over a bitmap level iterate over the
+/// dimension and locate into the level, but when the loop body only
+/// accumulates, the loop iterates over the set bits of the word-wise AND/OR of
+/// the bitmaps it coiterates instead. Bitmap levels must be the last level of
+/// a format, and they cannot be assembled into, so they can only be used for
+/// operands.
+class BitmapModeFormat : public ModeFormatImpl {
+public:
+  BitmapModeFormat();
+  BitmapModeFormat(bool isUnique);
+
+  ~BitmapModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction locate(ir::Expr parentPos, std::vector<ir::Expr> coords,
+                      Mode mode) const override;
+
+  ir::Expr getWidth(Mode mode) const override;
+
+  std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode,
+                                  int level) const override;
+
+  /// The number of coordinates stored in a word of the bits array.
+  static const int WORD_BITS = 64;
+
+protected:
+  ir::Expr getRankArray(ModePack pack) const;
+  ir::Expr getBitsArray(ModePack pack) const;
+  ir::Expr getSizeArray(ModePack pack) const;
+};
+
+}
+
+#endif
@@ -36,6 +36,10 @@ public:
   std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode, 
                                   int level) const override;
 
+  /// Dense levels whose size is fixed and smaller than this have a width that
+  /// is a compile-time constant.
+  static const int MAX_CONSTANT_WIDTH = 16;
+
 protected:
   ir::Expr getSizeArray(ModePack pack) const;
 };
@@ -0,0 +1,46 @@
+#ifndef TACO_MODE_FORMAT_DIAGONAL_H
+#define TACO_MODE_FORMAT_DIAGONAL_H
+
+#include "taco/lower/mode_format_impl.h"
+
+namespace taco {
+
+/// A diagonal level stores the columns of a matrix as a set of diagonals,
+/// each identified by its offset from the main diagonal (DIA). The level has
+/// two arrays: a one-element array holding the number of stored diagonals K,
+/// and the sorted offsets of the diagonals followed by a sentinel. Every row
+/// stores one value per diagonal, so the position of column `j` in row `i`
+/// is `i * K + k`, where `offsets[k] == j - i`; the values of diagonal
+/// entries that lie outside the matrix hold the fill value.
+///
+/// Iterating over a row visits the diagonals that intersect it, in order of
+/// their columns, and computes the column from the offset without loading a
+/// coordinate per value. A diagonal level must be the second level of a
+/// matrix format whose first level is dense (the `DIA` format), and it
+/// cannot be assembled into, so it can only be used for operands.
+class DiagonalModeFormat : public ModeFormatImpl {
+public:
+  DiagonalModeFormat();
+
+  ~DiagonalModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction posIterBounds(ir::Expr parentPos, Mode mode) const override;
+  ModeFunction posIterAccess(ir::Expr pos, std::vector<ir::Expr> coords,
+                             Mode mode) const override;
+
+  ir::Expr getWidth(Mode mode) const override;
+
+  std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode,
+                                  int level) const override;
+
+protected:
+  ir::Expr getNumArray(ModePack pack) const;
+  ir::Expr getOffsetsArray(ModePack pack) const;
+  ir::Expr getSizeArray(ModePack pack) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef TACO_MODE_FORMAT_ELL_H
+#define TACO_MODE_FORMAT_ELL_H
+
+#include "taco/lower/mode_format_impl.h"
+
+namespace taco {
+
+/// An ell level stores the columns of a matrix in the sliced ELLPACK layout
+/// (SELL-C-sigma). The rows are grouped into slices of C rows (the slice
+/// height), after the rows of every window of sigma rows (the sort window) are
+/// sorted by decreasing length. Every slice is padded to the length of its
+/// longest row and stored column-major, so the k-th entries of the C rows of a
+/// slice are adjacent and the entries of a row are C positions apart.
+///
+/// The level has two arrays: a pos array that starts with the slice height,
+/// followed by the first and the end position of every row and by the size of
+/// the level, and a crd array where padding holds -1 (and the values of
+/// padding hold the fill value). Iterating over a row steps through its
+/// positions with a stride of the slice height and never visits padding. Row
+/// loops whose rows only accumulate over the ell level are instead lowered a
+/// slice at a time, with a loop over the lanes (rows) of the slice innermost
+/// so that it reads adjacent positions. An
+/// ell level must be the second level of a matrix format whose first level is
+/// dense (the `SELL` formats), and it cannot be assembled into, so it can only
+/// be used for operands.
+class EllModeFormat : public ModeFormatImpl {
+public:
+  EllModeFormat();
+  EllModeFormat(int sliceHeight, int sortWindow);
+
+  ~EllModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction posIterBounds(ir::Expr parentPos, Mode mode) const override;
+  ModeFunction posIterAccess(ir::Expr pos, std::vector<ir::Expr> coords,
+                             Mode mode) const override;
+
+  std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode,
+                                  int level) const override;
+
+  /// Returns the slice height and the sort window that tensors stored in an
+  /// ell mode format are packed with.
+  static int getSliceHeight(const ModeFormat& modeFormat);
+  static int getSortWindow(const ModeFormat& modeFormat);
+
+  /// The slice height of `ModeFormat::Ell`, which makes a slice fill a 512-bit
+  /// vector of double precision values.
+  static const int DEFAULT_SLICE_HEIGHT = 8;
+
+protected:
+  bool equals(const ModeFormatImpl& other) const override;
+
+  ir::Expr getPosArray(ModePack pack) const;
+  ir::Expr getCoordArray(ModePack pack) const;
+
+  const int sliceHeight;
+  const int sortWindow;
+};
+
+}
+
+#endif
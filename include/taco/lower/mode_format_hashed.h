@@ -0,0 +1,77 @@
+#ifndef TACO_MODE_FORMAT_HASHED_H
+#define TACO_MODE_FORMAT_HASHED_H
+
+#include "taco/lower/mode_format_impl.h"
+
+namespace taco {
+
+/// A hashed level stores the coordinates below each parent position in an
+/// open-addressing hash table of `width` slots (a power of two) with linear
+/// probing. The level has two arrays: a one-element array holding the width,
+/// and a crd array of `width` slots per parent position where empty slots
+/// hold -1. The position of a coordinate is `parentPos * width + slot`, so
+/// the values of empty slots are stored too and hold the fill value.
+///
+/// Tensors are packed and results are assembled with the width of the mode
+/// format (`DEFAULT_HASH_WIDTH` for `ModeFormat::Hashed`), or the smallest
+/// power of two that is at least the dimension of the mode if that is smaller.
+/// The width must be larger than the number of coordinates below any parent
+/// position; kernels whose tables overflow fail, which the tensor API reports
+/// as an error. Coordinate lists packed with `taco::pack` get tables twice as
+/// wide as their largest segment instead. Iteration over a
+/// hashed level is unordered, and hashed result levels must not be below a
+/// level that is assembled by appending.
+class HashedModeFormat : public ModeFormatImpl {
+public:
+  using ModeFormatImpl::getInsertCoord;
+
+  HashedModeFormat();
+  HashedModeFormat(bool isUnique, bool isZeroless,
+                   long long width = DEFAULT_HASH_WIDTH);
+
+  ~HashedModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction posIterBounds(ir::Expr parentPos, Mode mode) const override;
+  ModeFunction posIterAccess(ir::Expr pos, std::vector<ir::Expr> coords,
+                             Mode mode) const override;
+
+  ModeFunction locate(ir::Expr parentPos, std::vector<ir::Expr> coords,
+                      Mode mode) const override;
+
+  ir::Stmt getInsertCoord(ir::Expr p, const std::vector<ir::Expr>& i,
+                          Mode mode) const override;
+  ir::Expr getWidth(Mode mode) const override;
+  ir::Stmt getInsertInitCoords(ir::Expr pBegin, ir::Expr pEnd,
+                               Mode mode) const override;
+  ir::Stmt getInsertInitLevel(ir::Expr szPrev, ir::Expr sz,
+                              Mode mode) const override;
+  ir::Stmt getInsertFinalizeLevel(ir::Expr szPrev, ir::Expr sz,
+                                  Mode mode) const override;
+
+  ir::Expr getAssembledSize(ir::Expr prevSize, Mode mode) const override;
+
+  std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode,
+                                  int level) const override;
+
+  /// The default number of slots per parent position of assembled results.
+  static const long long DEFAULT_HASH_WIDTH = 1 << 10;
+
+  /// Returns the slot that `coord` hashes to in a table of `width` slots, which
+  /// are the high bits of its multiplicative (Fibonacci) hash. The generated
+  /// code's `taco_hashLocate` helpers use the same function.
+  static int hash(int coord, int width);
+
+protected:
+  bool equals(const ModeFormatImpl& other) const override;
+
+  ir::Expr getWidthArray(ModePack pack) const;
+  ir::Expr getCoordArray(ModePack pack) const;
+
+  const long long width;
+};
+
+}
+
+#endif
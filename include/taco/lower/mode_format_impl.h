@@ -98,6 +98,12 @@ private:
 
 std::ostream& operator<<(std::ostream&, const ModeFunction&);
 
+/// The status of the running kernel call, an `int32_t` pointer.  Mode
+/// functions pass it to the helpers of the generated code that can fail (e.g.
+/// the probe of a hashed level), which store an error code in it from any
+/// thread of the call.  Kernels that use it declare it on entry.
+ir::Expr getKernelStatus();
+
 
 /// The abstract class to inherit from to add a new mode format to the system.
 /// The mode type implementation can then be passed to the `ModeType`
@@ -141,8 +147,10 @@ public:
 
 
   /// The position iteration capability's iterator function computes a range
-  /// [result[0], result[1]) of positions to iterate over.
-  /// `pos_iter_bounds(p_{k−1}) -> begin_{k}, end_{k}`
+  /// [result[0], result[1]) of positions to iterate over. Levels whose
+  /// positions are not consecutive return the stride between them as an
+  /// optional result[2].
+  /// `pos_iter_bounds(p_{k−1}) -> begin_{k}, end_{k}[, stride_{k}]`
   virtual ModeFunction posIterBounds(ir::Expr parentPos, Mode mode) const;
 
   /// The position iteration capability's access function maps a position
@@ -213,6 +221,19 @@ public:
   getSeqInsertEdge(ir::Expr parentPos, std::vector<ir::Expr> coords,
                    std::vector<AttrQueryResult> queries, Mode mode) const;
 
+  /// Parallel variant of the insert edge functions. `getParInsertEdge` stores
+  /// the edges of a parent position independently of all other parent
+  /// positions, and `getParFinalizeEdges` completes the edges once they have
+  /// been stored for all parent positions.  Levels that leave them undefined
+  /// are assembled with `getSeqInsertEdge`.
+  virtual ir::Stmt
+  getParInsertEdge(ir::Expr parentPos, std::vector<ir::Expr> coords,
+                   std::vector<AttrQueryResult> queries, Mode mode) const;
+
+  virtual ir::Stmt
+  getParFinalizeEdges(ir::Expr prevSize, std::vector<AttrQueryResult> queries,
+                      Mode mode) const;
+
   virtual ir::Stmt
   getInitCoords(ir::Expr prevSize, std::vector<AttrQueryResult> queries, 
                 Mode mode) const;
@@ -24,6 +24,11 @@ public:
   /// Construct an array of elements of the given type.
   Array(Datatype type, void* data, size_t size, Policy policy=Free);
 
+  /// Construct an array of elements of the given type over memory that is
+  /// owned by `owner`, such as a memory-mapped file. The array does not free
+  /// the data (like UserOwns), but keeps `owner` alive while it exists.
+  Array(Datatype type, void* data, size_t size, std::shared_ptr<void> owner);
+
   /// Returns the type of the array elements
   const Datatype& getType() const;
 
@@ -0,0 +1,29 @@
+/// The convert machinery converts a packed tensor from one storage format to
+/// another without re-sorting its components or packing them through the
+/// coordinate buffer. The index of the source is walked level by level, the
+/// components are brought into the order of the target levels with stable
+/// counting sorts over the modes whose order changes, and the target levels
+/// are assembled from the sorted coordinates, where the pos arrays of
+/// compressed levels are computed from histograms.
+
+#ifndef TACO_STORAGE_CONVERT_H
+#define TACO_STORAGE_CONVERT_H
+
+#include "taco/format.h"
+#include "taco/storage/storage.h"
+
+namespace taco {
+
+/// True if tensors stored in `source` can be converted to `target` by
+/// `convert`. Both formats must consist of dense, compressed, and singleton
+/// levels with 32-bit index arrays, one level per mode format pack, the
+/// source must be ordered and unique, and singleton target levels must be
+/// below non-unique levels (as in COO).
+bool isConvertible(const Format& source, const Format& target);
+
+/// Convert the components of `storage` into a storage in `format`, which must
+/// be initialized (see `TensorBase`) and convertible from the storage's format.
+TensorStorage convert(const TensorStorage& storage, const Format& format);
+
+}
+#endif
@@ -0,0 +1,47 @@
+/// Read and write tensors in taco's native binary format, which stores the
+/// packed tensor storage (format, dimensions, fill value, index arrays and
+/// value array) as-is.
+
+#ifndef TACO_FILE_IO_TACO_H
+#define TACO_FILE_IO_TACO_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "taco/format.h"
+
+namespace taco {
+class TensorBase;
+class Format;
+
+/// Read a binary tensor from a file. The file is memory-mapped and the index
+/// and value arrays of the returned tensor point into the mapping, so nothing
+/// is parsed or packed. If the file was stored in a different format, the
+/// tensor is repacked into the requested format.
+TensorBase readTACO(std::string filename, const ModeFormat& modetype,
+                    bool pack=true);
+
+/// Read a binary tensor from a file.
+TensorBase readTACO(std::string filename, const Format& format, bool pack=true);
+
+/// Read a binary tensor from a file in the format it was stored in.
+TensorBase readTACO(std::string filename);
+
+/// Read a binary tensor from a stream.
+TensorBase readTACO(std::istream& stream, const ModeFormat& modetype,
+                    bool pack=true);
+
+/// Read a binary tensor from a stream.
+TensorBase readTACO(std::istream& stream, const Format& format,
+                    bool pack=true);
+
+/// Write a packed tensor to a binary file.
+void writeTACO(std::string filename, const TensorBase& tensor);
+
+/// Write a packed tensor to a binary stream.
+void writeTACO(std::ostream& stream, const TensorBase& tensor);
+
+}
+
+#endif
@@ -23,6 +23,52 @@ namespace ir {
 class Stmt;
 }
 
+/// Sort buffered components into the lexicographic order of the storage mode
+/// ordering `permutation` and scatter them into one coordinate array per
+/// storage level (`coordinates[i]` holds the coordinates of mode
+/// `permutation[i]`) and a values array. Each buffered component consists of
+/// `order` int coordinates followed by a `csize`-byte value. The sort is
+/// stable, so duplicate coordinates keep their insertion order. When the
+/// product of the dimensions fits in 64 bits, the components are sorted by a
+/// parallel LSD radix sort on their linearized coordinates, with as many
+/// passes as the dimensions require; otherwise they are sorted by comparison.
+/// The sort is not in place: the radix sort needs two 64-bit keys and two
+/// 32-bit component indices, 24 bytes per component (32 bytes when there are
+/// more than 2^32 components), on top of the buffer and the output arrays.
+void sortCoordinates(const char* buffer, size_t numCoordinates, int csize,
+                     const std::vector<int>& dimensions,
+                     const std::vector<int>& permutation,
+                     std::vector<std::vector<int>>& coordinates,
+                     char* values);
+
+/// Merge two sets of components that are each sorted in the lexicographic
+/// order of the storage levels (as produced by `sortCoordinates`) into one
+/// sorted set. Components of the first set precede equal components of the
+/// second set, so duplicates stay adjacent and are summed when packed. The
+/// output arrays `coordinates` and `values` must not alias the inputs.
+void mergeCoordinates(const std::vector<std::vector<int>>& aCoordinates,
+                      const char* aValues,
+                      const std::vector<std::vector<int>>& bCoordinates,
+                      const char* bValues, int csize,
+                      std::vector<std::vector<int>>& coordinates,
+                      char* values);
+
+/// Returns true if components can be spliced into packed storage of the given
+/// format with `spliceCoordinates`, which requires every level to be dense or
+/// compressed (ordered and unique) with 32-bit index arrays.
+bool canSpliceCoordinates(const Format& format);
+
+/// Splice components that are sorted in the lexicographic order of the storage
+/// levels (as produced by `sortCoordinates`) into the pos and crd arrays of the
+/// packed `storage`, whose format `canSpliceCoordinates`. New components are
+/// added to the packed components with equal coordinates and to each other, so
+/// the result is the same as packing the two sets together, but the packed
+/// components are copied level by level instead of being extracted and
+/// packed again. Returns the number of values of the spliced storage.
+size_t spliceCoordinates(TensorStorage& storage,
+                         const std::vector<std::vector<int>>& coordinates,
+                         const char* values, size_t numCoordinates);
+
 TensorStorage pack(Datatype                             datatype,
                    const std::vector<int>&              dimensions,
                    const Format&                        format,
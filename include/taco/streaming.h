@@ -0,0 +1,74 @@
+#ifndef TACO_STREAMING_H
+#define TACO_STREAMING_H
+
+#include <string>
+#include <vector>
+
+#include "taco/format.h"
+#include "taco/type.h"
+
+namespace taco {
+class TensorBase;
+
+/// A sparse tensor that is stored on disk as a sequence of row chunks, so that
+/// it can be processed without ever holding the whole tensor in memory. Chunk
+/// `c` holds the rows (mode-0 coordinates) in [getChunkBegin(c),
+/// getChunkEnd(c)), with row coordinates relative to the start of the chunk,
+/// and is stored in the binary .taco format in the chunk directory.
+class ChunkedTensor {
+public:
+  /// Open a chunked tensor that was written by `writeChunked`.
+  explicit ChunkedTensor(std::string directory);
+
+  /// Returns the dimensions of the whole tensor.
+  const std::vector<int>& getDimensions() const;
+
+  /// Returns the order of the tensor.
+  int getOrder() const;
+
+  /// Returns the format of the chunks.
+  const Format& getFormat() const;
+
+  /// Returns the component type of the tensor.
+  Datatype getComponentType() const;
+
+  /// Returns the number of chunks.
+  int getNumChunks() const;
+
+  /// Returns the first row of a chunk.
+  int getChunkBegin(int chunk) const;
+
+  /// Returns one past the last row of a chunk.
+  int getChunkEnd(int chunk) const;
+
+  /// Load a chunk. The chunk's file is memory-mapped, and its pages are read
+  /// in before returning so that the chunk can be loaded ahead of its use.
+  TensorBase readChunk(int chunk) const;
+
+private:
+  std::string directory;
+  std::vector<int> dimensions;
+  std::vector<int> chunkBegins;
+  Format format;
+  Datatype componentType;
+};
+
+/// Split a packed tensor into chunks of at most `rowsPerChunk` rows and write
+/// them to `directory`, which must exist. The tensor must store its rows
+/// outermost (mode 0 first in its mode ordering). A tensor without rows is
+/// written as a single empty chunk.
+ChunkedTensor writeChunked(std::string directory, const TensorBase& tensor,
+                           int rowsPerChunk);
+
+/// Compute `result = A * B` by streaming the chunks of `A`, where the product
+/// contracts the last mode of `A` with the first mode of `B`. For a matrix
+/// `A` this is a sparse matrix-vector (B a vector) or matrix-matrix (B a
+/// matrix) product. The compute kernel is compiled once and called on every
+/// chunk, writing to a view of the chunk's rows of `result`, while the next
+/// chunk is loaded in the background. `result` must be all-dense with the
+/// default mode ordering, and is overwritten.
+void multiplyChunked(TensorBase& result, const ChunkedTensor& A,
+                     const TensorBase& B);
+
+}
+#endif
@@ -18,6 +18,12 @@ struct Target {
   std::string compiler_env = "TACO_CC";
 
   std::string compiler = "cc";
+
+  /// How generated C code is turned into executable code. SystemCompiler
+  /// invokes the compiler above and loads the resulting shared library, while
+  /// TCC compiles the code in-process with libtcc (if taco was built with TCC
+  /// support) and falls back to the system compiler when that fails.
+  enum Backend {SystemCompiler=0, TCC} backend = SystemCompiler;
   
   // As we support them, we'll stick in optional features into the target as
   // well, including things like parallelism model (e.g. openmp, cilk) for
@@ -38,7 +44,8 @@ struct Target {
 };
 
   /// Gets the target from the environment.  If this is not set in the
-  /// environment, it uses the default C99 backend with the current OS
+  /// environment, it uses the default C99 backend with the current OS. The
+  /// compile backend is selected by setting TACO_BACKEND to "cc" or "tcc".
   Target getTargetFromEnvironment();
 
 } // namespace taco
@@ -8,6 +8,7 @@
 #include <utility>
 #include <array>
 #include <mutex>
+#include <future>
 
 #include "taco/type.h"
 #include "taco/format.h"
@@ -39,6 +40,14 @@ struct AccessTensorNode;
 template <typename CType>
 struct ScalarAccess;
 
+/// Statistics of the cache of compiled compute kernels that tensors share.
+struct KernelCacheStats {
+  size_t hits = 0;
+  size_t misses = 0;
+  size_t evictions = 0;
+  size_t size = 0;
+};
+
 /// TensorBase is the super-class for all tensors. You can use it directly to
 /// avoid templates, or you can use the templated `Tensor<T>` that inherits from
 /// `TensorBase`.
@@ -130,6 +139,22 @@ public:
   /// Reserve space for `numCoordinates` additional coordinates.
   void reserve(size_t numCoordinates);
 
+  /// Insert a buffer of components in bulk. Each component is `getOrder()`
+  /// int coordinates immediately followed by one value of type `ctype`, which
+  /// must be the component type, so the buffer has the layout of the tensor's
+  /// insertion buffer. The buffer is adopted without copying if no other
+  /// components are waiting to be packed.
+  void insertComponents(Datatype ctype, std::vector<char>&& components);
+
+  /// Returns a copy of the tensor stored in `format`. Tensors whose formats
+  /// consist of dense, compressed, and singleton levels are converted directly
+  /// from their index without re-sorting or repacking their components (see
+  /// `taco/storage/convert.h`); other tensors are converted by inserting their
+  /// components into the new tensor and packing it. Pending computations of
+  /// the tensor are completed first.
+  TensorBase convert(const Format& format);
+  TensorBase convert(std::string name, const Format& format);
+
   /* --- Write Methods       --- */
 
   /// Insert a value into the tensor. The number of coordinates must match the
@@ -424,6 +449,16 @@ public:
 
   void compile(IndexStmt stmt, bool assembleWhileCompute=false);
 
+  /// Compile the tensor expression on a background thread. The returned future
+  /// is ready once the kernel is compiled. Calling `assemble` or `compute`
+  /// waits for it, so callers that only want to overlap the compilation of
+  /// several expressions can ignore the future. Compilation errors are
+  /// rethrown by the future and by the next call that waits for it.
+  std::shared_future<void> compileAsync();
+
+  std::shared_future<void> compileAsync(IndexStmt stmt,
+                                        bool assembleWhileCompute=false);
+
   /// Assemble the tensor storage, including index and value arrays.
   void assemble();
 
@@ -445,6 +480,10 @@ public:
   /// True if the Tensor needs to be computed.
   bool needsCompute();
 
+  /// Mark whether the Tensor needs to be computed, e.g. to rerun the compute
+  /// kernel when benchmarking.
+  void setNeedsCompute(bool needsCompute);
+
   /// Set to true to perform the assemble and compute stages simultaneously.
   void setAssembleWhileCompute(bool assembleWhileCompute);
 
@@ -456,6 +495,17 @@ public:
   /// then it will will be created it from the given expression.
   void compileSource(std::string source);
 
+  /// Get the hit, miss and eviction counts of the compute kernel cache.
+  static KernelCacheStats getComputeKernelCacheStats();
+
+  /// Bound the number of kernels kept in the compute kernel cache, evicting
+  /// the least recently used kernels first. A capacity of 0 (the default)
+  /// leaves the cache unbounded.
+  static void setComputeKernelCacheCapacity(size_t capacity);
+
+  /// Remove all kernels from the compute kernel cache and reset its counters.
+  static void clearComputeKernelCache();
+
   /// Print the IR loops that compute the tensor's expression.
   void printComputeIR(std::ostream& stream, bool color=false,
                       bool simplify=false) const;
@@ -498,6 +548,7 @@ public:
   friend std::ostream& operator<<(std::ostream&, TensorBase&);
 
   friend struct AccessTensorNode;
+  friend struct TACODecoder;
   std::vector<TensorBase> getDependentTensors();
 private:
   static std::shared_ptr<ir::Module> getHelperFunctions(
@@ -513,7 +564,6 @@ private:
   void setNeedsPack(bool needsPack);
   void setNeedsCompile(bool needsCompile);
   void setNeedsAssemble(bool needsAssemble);
-  void setNeedsCompute(bool needsCompute);
 
   void addDependentTensor(TensorBase& tensor);
   void removeDependentTensor(TensorBase& tensor);
@@ -535,11 +585,17 @@ protected:
 
 private:
   template <typename CType>
-  void reinsertPackedComponents();
+  void extractPackedComponents(std::vector<std::vector<int>>& coordinates,
+                               std::vector<char>& values);
 
   struct Content;
   std::shared_ptr<Content> content;
 
+  IndexStmt getScheduledAssignment();
+  static void compileKernel(std::shared_ptr<Content> content, IndexStmt stmt,
+                            bool assembleWhileCompute);
+  void waitForCompile() const;
+
   typedef std::vector<std::tuple<Format,
                                  Datatype,
                                  std::vector<int>,
@@ -547,10 +603,8 @@ private:
   static HelperFuncsCache helperFunctions;
   static std::mutex helperFunctionsMutex;
 
-  typedef std::vector<std::pair<IndexStmt, 
-                                std::shared_ptr<ir::Module>>> KernelsCache;
+  class KernelsCache;
   static KernelsCache computeKernels;
-  static std::mutex computeKernelsMutex;
 };
 
 /// A reference to a tensor. Tensor object copies copies the reference, and
@@ -610,6 +664,14 @@ public:
   Tensor<CType> transpose(std::vector<int> newModeOrdering, Format format) const;
   Tensor<CType> transpose(std::string name, std::vector<int> newModeOrdering, Format format) const;
 
+  /// Packs a blocked copy of the tensor, with tiles of the given dimensions.
+  /// The copy has twice the order: component (i,j) of a matrix is stored at
+  /// (i/bi, j/bj, i%bi, j%bj), so a matrix packed with the `BCSR` format
+  /// stores compressed tiles. Dimensions are rounded up to whole tiles.
+  Tensor<CType> block(std::vector<int> blockDimensions, Format format) const;
+  Tensor<CType> block(std::string name, std::vector<int> blockDimensions,
+                      Format format) const;
+
   /// Returns a copy of the tensor without explicit zeros.
   Tensor<CType> removeExplicitZeros(Format format) const;
   Tensor<CType> removeExplicitFillValues(Format format, int value) const;
@@ -727,7 +789,12 @@ enum class FileType {
   ttx,
 
   /// .rb  - The rutherford-boeing sparse matrix format.
-  rb
+  rb,
+
+  /// .taco - The native taco binary format. It stores a packed tensor as-is
+  ///         (format, dimensions, fill value, index arrays and values), so
+  ///         reading it memory-maps the file instead of parsing and packing.
+  taco
 };
 
 /// Read a tensor from a file. The file format is inferred from the filename
@@ -904,6 +971,7 @@ struct TensorBase::Content {
   ir::Stmt           computeFunc;
   bool               assembleWhileCompute;
   std::shared_ptr<ir::Module> module;
+  std::shared_future<void> compileFuture;
 
   size_t             coordinateBufferUsed;
   size_t             coordinateSize;
@@ -915,13 +983,14 @@ struct TensorBase::Content {
   bool               needsAssemble;
   bool               needsCompute;
   std::vector<std::weak_ptr<TensorBase::Content>> dependentTensors;
+  std::mutex         dependentTensorsMutex;  // guards dependentTensors
   unsigned int       uniqueId;
 
   Content(std::string name, Datatype dataType, const std::vector<int>& dimensions,
           Format format, Literal fill)
       : dataType(dataType), dimensions(dimensions),
         storage(TensorStorage(dataType, dimensions, format, fill)),
-        tensorVar(TensorVar(util::getUniqueId(), name, Type(dataType,convert(dimensions)),format, fill)) {
+        tensorVar(TensorVar(util::getUniqueId(), name, Type(dataType,taco::convert(dimensions)),format, fill)) {
           uniqueId = tensorVar.getId();
         }
 };
@@ -1000,16 +1069,47 @@ void TensorBase::insertUnchecked(
 }
 
 template <typename CType>
-void TensorBase::reinsertPackedComponents() {
+void TensorBase::extractPackedComponents(
+    std::vector<std::vector<int>>& coordinates, std::vector<char>& values) {
+  const std::vector<int>& permutation = getFormat().getModeOrdering();
+  const size_t order = getOrder();
+  coordinates.assign(order, std::vector<int>());
+  values.clear();
+
+  // Copy the packed components into one coordinate array per storage level,
+  // checking that they are iterated in sorted storage order.
+  bool sorted = (order > 0);
   auto begin = iteratorPacked<CType>().begin();
   auto end = iteratorPacked<CType>().end();
-  std::vector<int> coords(getOrder());
   for (auto& it = begin; it != end; ++it) {
-    for (size_t i = 0; i < (size_t)getOrder(); ++i) {
-      coords[i] = it->first[i];
+    bool equal = !coordinates.empty() && !coordinates[0].empty();
+    for (size_t level = 0; level < order; ++level) {
+      const int coord = it->first[permutation[level]];
+      if (equal && coord != coordinates[level].back()) {
+        sorted = sorted && (coord > coordinates[level].back());
+        equal = false;
+      }
+      coordinates[level].push_back(coord);
     }
-    insertUnsynced(coords, it->second);
+    const char* value = (const char*)&it->second;
+    values.insert(values.end(), value, value + sizeof(CType));
+  }
+  if (sorted) {
+    return;
   }
+
+  // Otherwise reinsert the packed components into the coordinate buffer so
+  // that they are sorted along with the unpacked components.
+  const size_t numComponents = values.size() / sizeof(CType);
+  std::vector<int> coords(order);
+  for (size_t i = 0; i < numComponents; ++i) {
+    for (size_t level = 0; level < order; ++level) {
+      coords[permutation[level]] = coordinates[level][i];
+    }
+    insertUnsynced(coords, ((const CType*)values.data())[i]);
+  }
+  coordinates.assign(order, std::vector<int>());
+  values.clear();
 }
 
 template <typename... IndexVars>
@@ -1252,6 +1352,38 @@ Tensor<CType> Tensor<CType>::transpose(std::string name, std::vector<int> newMod
   return newTensor;
 }
 
+template <typename CType>
+Tensor<CType> Tensor<CType>::block(std::vector<int> blockDimensions, Format format) const {
+  return block(util::uniqueName('A'), blockDimensions, format);
+}
+
+template <typename CType>
+Tensor<CType> Tensor<CType>::block(std::string name, std::vector<int> blockDimensions, Format format) const {
+  taco_uassert(blockDimensions.size() == (size_t)getOrder())
+      << "A tensor of order " << getOrder() << " must be blocked with "
+      << getOrder() << " block dimensions";
+  std::vector<int> newDimensions;
+  for (int mode = 0; mode < getOrder(); mode++) {
+    taco_uassert(blockDimensions[mode] > 0) << "Block dimensions must be positive";
+    newDimensions.push_back((getDimensions()[mode] + blockDimensions[mode] - 1) /
+                            blockDimensions[mode]);
+  }
+  newDimensions.insert(newDimensions.end(), blockDimensions.begin(),
+                       blockDimensions.end());
+
+  Tensor<CType> newTensor(name, newDimensions, format);
+  std::vector<int> newCoordinate(2 * getOrder());
+  for (auto& value : *this) {
+    for (int mode = 0; mode < getOrder(); mode++) {
+      newCoordinate[mode] = value.first[mode] / blockDimensions[mode];
+      newCoordinate[getOrder() + mode] = value.first[mode] % blockDimensions[mode];
+    }
+    newTensor.insert(newCoordinate, value.second);
+  }
+  newTensor.pack();
+  return newTensor;
+}
+
 template <typename CType>
 Tensor<CType> Tensor<CType>::removeExplicitZeros(Format format) const {
   return removeExplicitFillValues(format, 0);
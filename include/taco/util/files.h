@@ -4,6 +4,8 @@
 #include <string>
 #include <fstream>
 
+#include "taco/util/uncopyable.h"
+
 namespace taco {
 namespace util {
 
@@ -11,5 +13,29 @@ std::string sanitizePath(std::string path);
 
 void openStream(std::fstream& stream, std::string path, std::fstream::openmode mode);
 
+/// A memory mapping of a file. The mapping is read-only, and advised to be read
+/// sequentially, unless `copyOnWrite` is set, in which case writes are private
+/// to the process and never reach the file. The mapping is released when the
+/// MappedFile is destroyed. A file must not be truncated while it is mapped,
+/// so files that may be mapped are replaced by renaming a new file over them.
+class MappedFile : Uncopyable {
+public:
+  explicit MappedFile(std::string path, bool copyOnWrite=false);
+  ~MappedFile();
+
+  /// Returns the first byte of the file, or nullptr if the file is empty.
+  /// @{
+  const char* data() const {return bytes;}
+  char* data() {return bytes;}
+  /// @}
+
+  /// Returns the size of the file in bytes.
+  size_t size() const {return numBytes;}
+
+private:
+  char* bytes;
+  size_t numBytes;
+};
+
 }}
 #endif
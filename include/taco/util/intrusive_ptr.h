@@ -1,6 +1,7 @@
 #ifndef TACO_UTIL_INTRUSIVE_PTR_H
 #define TACO_UTIL_INTRUSIVE_PTR_H
 
+#include <atomic>
 #include <iostream>
 
 namespace taco {
@@ -130,12 +131,22 @@ public:
   }
 };
 
+/// The reference count is atomic so that index notation can be shared by
+/// threads, e.g. when kernels are compiled in the background.
 template <class Data>
 class Manageable {
+public:
+  Manageable() = default;
+
+  /// Copies are new objects and start out unreferenced.
+  Manageable(const Manageable&) {}
+  Manageable& operator=(const Manageable&) { return *this; }
+
+private:
   friend void acquire(const Data *data) { ++data->ref; }
   friend void release(const Data *data) { if (--data->ref == 0) delete data; }
 
-  mutable long ref = 0;
+  mutable std::atomic<long> ref{0};
 };
 
 }} // namespace simit::util
@@ -0,0 +1,62 @@
+#ifndef TACO_UTIL_THREAD_POOL_H
+#define TACO_UTIL_THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "taco/util/uncopyable.h"
+
+namespace taco {
+namespace util {
+
+/// A fixed-size pool of worker threads that run submitted tasks in FIFO order.
+class ThreadPool : private Uncopyable {
+public:
+  /// Create a pool with the given number of worker threads (at least one).
+  explicit ThreadPool(size_t numThreads);
+
+  /// Finish the queued tasks and join the worker threads.
+  ~ThreadPool();
+
+  /// Queue a task, returning a future that holds its result or the exception
+  /// it threw.
+  template <typename Task>
+  auto submit(Task task) -> std::future<decltype(task())> {
+    typedef decltype(task()) Result;
+    auto packagedTask =
+        std::make_shared<std::packaged_task<Result()>>(std::move(task));
+    std::future<Result> result = packagedTask->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.emplace_back([packagedTask]() { (*packagedTask)(); });
+    }
+    taskAvailable.notify_one();
+    return result;
+  }
+
+  /// Get the number of worker threads.
+  size_t getNumThreads() const;
+
+private:
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable taskAvailable;
+  bool stopping;
+
+  void work();
+};
+
+/// Get the process-wide pool that compiles kernels in the background. Its size
+/// is read from the TACO_COMPILE_THREADS environment variable and defaults to
+/// the number of hardware threads.
+ThreadPool& getCompilePool();
+
+}}
+#endif
@@ -1,4 +1,8 @@
+import asyncio
+import concurrent.futures
 import operator
+import os
+import threading
 import numpy as np
 from scipy.sparse import csr_matrix, csc_matrix
 from ..core import core_modules as _cm
@@ -19,6 +23,46 @@ _dtype_to_tensor = {_cm.bool:    _cm.TensorBool,
 
 _dtype_error = "Invalid datatype. Must be bool, float32/64, (u)int8, (u)int16, (u)int32 or (u)int64"
 
+# Tensors evaluated with evaluate_async run on these threads, which taco releases the GIL on while it compiles,
+# assembles and computes. The pool is created on first use.
+_evaluation_pool = None
+_evaluation_pool_lock = threading.Lock()
+
+
+def _get_evaluation_pool():
+    global _evaluation_pool
+    with _evaluation_pool_lock:
+        if _evaluation_pool is None:
+            _evaluation_pool = concurrent.futures.ThreadPoolExecutor(max_workers=os.cpu_count() or 1,
+                                                                     thread_name_prefix="pytaco")
+        return _evaluation_pool
+
+
+class _evaluation:
+    """ The pending evaluation of a tensor returned by :func:`tensor.evaluate_async`.
+
+        It can be awaited in a coroutine or waited for with :func:`result`, both of which return the evaluated tensor
+        or raise the error that taco raised while evaluating it.
+    """
+
+    def __init__(self, future):
+        self._future = future
+
+    def done(self):
+        """
+            Returns True if the evaluation has finished.
+        """
+        return self._future.done()
+
+    def result(self, timeout=None):
+        """
+            Waits at most timeout seconds (or forever if None) for the evaluation to finish and returns the tensor.
+        """
+        return self._future.result(timeout)
+
+    def __await__(self):
+        return asyncio.wrap_future(self._future).__await__()
+
 
 class tensor:
     """ A mathematical tensor.
@@ -304,6 +348,44 @@ class tensor:
         """
         self._tensor.evaluate()
 
+    def evaluate_async(self):
+        """
+            Compile, assemble and compute as needed on a background thread.
+
+            Taco does not hold the GIL while it evaluates a tensor, so several tensors evaluated asynchronously are
+            evaluated in parallel with each other and with the calling Python thread. The tensor and its operands
+            must not be modified until the evaluation has finished, and operands that are shared by evaluations that
+            run at the same time should be evaluated before them.
+
+            Returns
+            ---------
+            evaluation
+                An awaitable that returns this tensor once it is evaluated. Its result method waits for the evaluation
+                outside of coroutines.
+
+            Examples
+            -----------
+
+            >>> import pytaco as pt
+            >>> import asyncio
+            >>> a = pt.tensor([2, 2], pt.dense)
+            >>> b = pt.tensor([2, 2], pt.dense)
+            >>> a.insert([0, 0], 2)
+            >>> i, j = pt.get_index_vars(2)
+            >>> b[i, j] = a[i, j] * a[i, j]
+            >>> async def evaluate(t):
+            ...     return await t.evaluate_async()
+            >>> c = asyncio.run(evaluate(b))
+            >>> c[0, 0]
+            4.0
+
+        """
+        def evaluate():
+            self._tensor.evaluate()
+            return self
+
+        return _evaluation(_get_evaluation_pool().submit(evaluate))
+
     def compute(self):
         """
             Compute the given expression and put the values in the tensor storage.
@@ -393,16 +393,19 @@ static void declareTensor(py::module &m, const std::string typestr) {
 
           .def("format", &TensorBase::getFormat)
 
-          .def("pack", &typedTensor::pack)
+          // The compiler methods do not touch Python objects, so they release
+          // the GIL while they compile, assemble, and compute
+          .def("pack", &typedTensor::pack, py::call_guard<py::gil_scoped_release>())
 
           // only bind .compile(), not .compile(IndexStmt, bool)
-          .def("compile", [](typedTensor &self) { self.compile(); } )
+          .def("compile", [](typedTensor &self) { self.compile(); },
+               py::call_guard<py::gil_scoped_release>())
 
-          .def("assemble", &typedTensor::assemble)
+          .def("assemble", &typedTensor::assemble, py::call_guard<py::gil_scoped_release>())
 
-          .def("evaluate", &typedTensor::evaluate)
+          .def("evaluate", &typedTensor::evaluate, py::call_guard<py::gil_scoped_release>())
 
-          .def("compute", &typedTensor::compute)
+          .def("compute", &typedTensor::compute, py::call_guard<py::gil_scoped_release>())
 
           .def("insert", &insert<CType>)
 
@@ -1,6 +1,6 @@
 import sys
 sys.path.insert(1, "@CMAKE_LIBRARY_OUTPUT_DIRECTORY@")
-import unittest, os, shutil, tempfile
+import asyncio, unittest, os, shutil, tempfile
 import pytaco as pt
 import numpy as np
 from scipy.sparse import csc_matrix, csr_matrix
@@ -261,6 +261,33 @@ class TestIndexFuncs(unittest.TestCase):
         t = pt.from_array(arr)
         self.assertEqual(-t, -arr)
 
+class TestAsyncEvaluation(unittest.TestCase):
+
+    def setUp(self):
+        self.arr = np.arange(1, 5).reshape([2, 2])
+        self.t = pt.from_array(self.arr)
+
+    def make_square(self):
+        res = pt.tensor([2, 2], pt.dense)
+        i, j = pt.get_index_vars(2)
+        res[i, j] = self.t[i, j] * self.t[i, j]
+        return res
+
+    def test_result(self):
+        res = self.make_square()
+        self.assertIs(res.evaluate_async().result(), res)
+        self.assertEqual(res, self.arr * self.arr)
+
+    def test_await(self):
+        results = [self.make_square() for _ in range(4)]
+
+        async def evaluate_all():
+            return await asyncio.gather(*[res.evaluate_async() for res in results])
+
+        for res in asyncio.run(evaluate_all()):
+            self.assertEqual(res, self.arr * self.arr)
+
+
 class testParsers(unittest.TestCase):
 
     def test_evaluate(self):
@@ -34,12 +34,39 @@ const string cHeaders =
   "#include <math.h>\n"
   "#include <complex.h>\n"
   "#include <string.h>\n"
+  "#include <pthread.h>\n"
   "#if _OPENMP\n"
   "#include <omp.h>\n"
   "#endif\n"
+  "#if (__AVX2__ || __SSE2__) && !__TINYC__\n"
+  "#include <immintrin.h>\n"
+  "#endif\n"
   "#define TACO_MIN(_a,_b) ((_a) < (_b) ? (_a) : (_b))\n"
   "#define TACO_MAX(_a,_b) ((_a) > (_b) ? (_a) : (_b))\n"
   "#define TACO_DEREF(_a) (((___context___*)(*__ctx__))->_a)\n"
+  "#define TACO_BIT(_i) ((uint64_t)1 << ((_i) & 63))\n"
+  // Count the trailing zeros (of a nonzero word) and the set bits of 64-bit
+  // words, with the compiler builtins if it has them (libtcc does not).
+  "#ifdef __TINYC__\n"
+  "static inline int taco_ctz64(uint64_t x) {\n"
+  "  static const int positions[64] = {\n"
+  "     0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,\n"
+  "    62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,\n"
+  "    63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,\n"
+  "    46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6\n"
+  "  };\n"
+  "  return positions[((x & -x) * 0x03f79d71b4cb0a89ull) >> 58];\n"
+  "}\n"
+  "static inline int taco_popcount64(uint64_t x) {\n"
+  "  x = x - ((x >> 1) & 0x5555555555555555ull);\n"
+  "  x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);\n"
+  "  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;\n"
+  "  return (int)((x * 0x0101010101010101ull) >> 56);\n"
+  "}\n"
+  "#else\n"
+  "#define taco_ctz64(_x) __builtin_ctzll(_x)\n"
+  "#define taco_popcount64(_x) __builtin_popcountll(_x)\n"
+  "#endif\n"
   "#ifndef TACO_TENSOR_T_DEFINED\n"
   "#define TACO_TENSOR_T_DEFINED\n"
   "typedef enum { taco_mode_dense, taco_mode_sparse } taco_mode_t;\n"
@@ -55,13 +82,33 @@ const string cHeaders =
   "  int32_t      vals_size;     // values array size\n"
   "} taco_tensor_t;\n"
   "#endif\n"
+  // Error code of the running kernel call, which helpers set when they fail.
+  // The shim of a kernel points the calling thread's status at the status of
+  // the call, and the kernel reads it on entry so that helpers on any thread
+  // of its parallel loops report to the call. Kernels that are called
+  // directly report to a status that is never read. The key is deleted by the
+  // last taco_arenaRelease.
+  "static const pthread_once_t taco_onceInit = PTHREAD_ONCE_INIT;\n"
+  "static pthread_key_t taco_statusKey;\n"
+  "static pthread_once_t taco_statusKeyOnce = PTHREAD_ONCE_INIT;\n"
+  "static int taco_statusKeyCreated = 0;\n"
+  "static int32_t taco_unreadStatus;\n"
+  "static void taco_createStatusKey(void) {\n"
+  "  taco_statusKeyCreated = pthread_key_create(&taco_statusKey, NULL) == 0;\n"
+  "}\n"
+  "static void taco_setCallStatus(int32_t* status) {\n"
+  "  pthread_once(&taco_statusKeyOnce, taco_createStatusKey);\n"
+  "  pthread_setspecific(taco_statusKey, status);\n"
+  "}\n"
+  "static int32_t* taco_callStatus(void) {\n"
+  "  pthread_once(&taco_statusKeyOnce, taco_createStatusKey);\n"
+  "  int32_t* status = (int32_t*)pthread_getspecific(taco_statusKey);\n"
+  "  return status ? status : &taco_unreadStatus;\n"
+  "}\n"
   "#if !_OPENMP\n"
   "int omp_get_thread_num() { return 0; }\n"
   "int omp_get_max_threads() { return 1; }\n"
   "#endif\n"
-  "int cmp(const void *a, const void *b) {\n"
-  "  return *((const int*)a) - *((const int*)b);\n"
-  "}\n"
   // Increment arrayStart until array[arrayStart] >= target or arrayStart >= arrayEnd
   // using an exponential search algorithm: https://en.wikipedia.org/wiki/Exponential_search.
   "int taco_gallop(int *array, int arrayStart, int arrayEnd, int target) {\n"
@@ -84,6 +131,48 @@ const string cHeaders =
   "  }\n"
   "  return curr+1;\n"
   "}\n"
+  // Like taco_gallop, but galloping over blocks of TACO_SIMD_WIDTH coordinates
+  // and then counting the coordinates below target in the last block at once,
+  // with an AVX2 compare if available and a loop the compiler can vectorize if
+  // not. The coordinates below target are a prefix of the block since the
+  // array is sorted.
+  "#define TACO_SIMD_WIDTH 8\n"
+  "int taco_simdGallop(int *array, int arrayStart, int arrayEnd, int target) {\n"
+  "  if (arrayStart >= arrayEnd || array[arrayStart] >= target) {\n"
+  "    return arrayStart;\n"
+  "  }\n"
+  "  int step = TACO_SIMD_WIDTH;\n"
+  "  int curr = arrayStart;\n"
+  "  while (curr + step < arrayEnd && array[curr + step] < target) {\n"
+  "    curr += step;\n"
+  "    step = step * 2;\n"
+  "  }\n"
+  "  step = step / 2;\n"
+  "  while (step >= TACO_SIMD_WIDTH) {\n"
+  "    if (curr + step < arrayEnd && array[curr + step] < target) {\n"
+  "      curr += step;\n"
+  "    }\n"
+  "    step = step / 2;\n"
+  "  }\n"
+  "  int block = curr + 1;\n"
+  "  if (block + TACO_SIMD_WIDTH <= arrayEnd) {\n"
+  "#if __AVX2__\n"
+  "    __m256i coords = _mm256_loadu_si256((const __m256i*)&array[block]);\n"
+  "    __m256i below = _mm256_cmpgt_epi32(_mm256_set1_epi32(target), coords);\n"
+  "    return block + __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(below)));\n"
+  "#else\n"
+  "    int below = 0;\n"
+  "    for (int i = 0; i < TACO_SIMD_WIDTH; i++) {\n"
+  "      below += (array[block + i] < target);\n"
+  "    }\n"
+  "    return block + below;\n"
+  "#endif\n"
+  "  }\n"
+  "  while (block < arrayEnd && array[block] < target) {\n"
+  "    block++;\n"
+  "  }\n"
+  "  return block;\n"
+  "}\n"
   "int taco_binarySearchAfter(int *array, int arrayStart, int arrayEnd, int target) {\n"
   "  if (array[arrayStart] >= target) {\n"
   "    return arrayStart;\n"
@@ -126,6 +215,450 @@ const string cHeaders =
   "  }\n"
   "  return lowerBound;\n"
   "}\n"
+  // Define a helper for the index array types that formats accept.
+  "#define TACO_DEFINE_FOR_INDEX_TYPES(DEFINE) \\\n"
+  "  DEFINE(int8_t) DEFINE(int16_t) DEFINE(int32_t) DEFINE(int64_t) \\\n"
+  "  DEFINE(uint8_t) DEFINE(uint16_t) DEFINE(uint32_t) DEFINE(uint64_t)\n"
+  // Variants of the searches above for index arrays of other integer types,
+  // and for positions that do not fit in an int.
+  "#define TACO_DEFINE_INDEX_SEARCHES(T) \\\n"
+  "static inline int64_t taco_gallop_##T(T *array, int64_t arrayStart, int64_t arrayEnd, int64_t target) { \\\n"
+  "  if (array[arrayStart] >= target || arrayStart >= arrayEnd) { \\\n"
+  "    return arrayStart; \\\n"
+  "  } \\\n"
+  "  int64_t step = 1; \\\n"
+  "  int64_t curr = arrayStart; \\\n"
+  "  while (curr + step < arrayEnd && array[curr + step] < target) { \\\n"
+  "    curr += step; \\\n"
+  "    step = step * 2; \\\n"
+  "  } \\\n"
+  "  step = step / 2; \\\n"
+  "  while (step > 0) { \\\n"
+  "    if (curr + step < arrayEnd && array[curr + step] < target) { \\\n"
+  "      curr += step; \\\n"
+  "    } \\\n"
+  "    step = step / 2; \\\n"
+  "  } \\\n"
+  "  return curr+1; \\\n"
+  "} \\\n"
+  "static inline int64_t taco_simdGallop_##T(T *array, int64_t arrayStart, int64_t arrayEnd, int64_t target) { \\\n"
+  "  if (arrayStart >= arrayEnd || array[arrayStart] >= target) { \\\n"
+  "    return arrayStart; \\\n"
+  "  } \\\n"
+  "  int64_t step = TACO_SIMD_WIDTH; \\\n"
+  "  int64_t curr = arrayStart; \\\n"
+  "  while (curr + step < arrayEnd && array[curr + step] < target) { \\\n"
+  "    curr += step; \\\n"
+  "    step = step * 2; \\\n"
+  "  } \\\n"
+  "  step = step / 2; \\\n"
+  "  while (step >= TACO_SIMD_WIDTH) { \\\n"
+  "    if (curr + step < arrayEnd && array[curr + step] < target) { \\\n"
+  "      curr += step; \\\n"
+  "    } \\\n"
+  "    step = step / 2; \\\n"
+  "  } \\\n"
+  "  int64_t block = curr + 1; \\\n"
+  "  if (block + TACO_SIMD_WIDTH <= arrayEnd) { \\\n"
+  "    int64_t below = 0; \\\n"
+  "    for (int i = 0; i < TACO_SIMD_WIDTH; i++) { \\\n"
+  "      below += (array[block + i] < target); \\\n"
+  "    } \\\n"
+  "    return block + below; \\\n"
+  "  } \\\n"
+  "  while (block < arrayEnd && array[block] < target) { \\\n"
+  "    block++; \\\n"
+  "  } \\\n"
+  "  return block; \\\n"
+  "} \\\n"
+  "static inline int64_t taco_binarySearchAfter_##T(T *array, int64_t arrayStart, int64_t arrayEnd, int64_t target) { \\\n"
+  "  if (array[arrayStart] >= target) { \\\n"
+  "    return arrayStart; \\\n"
+  "  } \\\n"
+  "  int64_t lowerBound = arrayStart; \\\n"
+  "  int64_t upperBound = arrayEnd; \\\n"
+  "  while (upperBound - lowerBound > 1) { \\\n"
+  "    int64_t mid = (upperBound + lowerBound) / 2; \\\n"
+  "    if (array[mid] < target) { \\\n"
+  "      lowerBound = mid; \\\n"
+  "    } else if (array[mid] > target) { \\\n"
+  "      upperBound = mid; \\\n"
+  "    } else { \\\n"
+  "      return mid; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  return upperBound; \\\n"
+  "} \\\n"
+  "static inline int64_t taco_binarySearchBefore_##T(T *array, int64_t arrayStart, int64_t arrayEnd, int64_t target) { \\\n"
+  "  if (array[arrayEnd] <= target) { \\\n"
+  "    return arrayEnd; \\\n"
+  "  } \\\n"
+  "  int64_t lowerBound = arrayStart; \\\n"
+  "  int64_t upperBound = arrayEnd; \\\n"
+  "  while (upperBound - lowerBound > 1) { \\\n"
+  "    int64_t mid = (upperBound + lowerBound) / 2; \\\n"
+  "    if (array[mid] < target) { \\\n"
+  "      lowerBound = mid; \\\n"
+  "    } else if (array[mid] > target) { \\\n"
+  "      upperBound = mid; \\\n"
+  "    } else { \\\n"
+  "      return mid; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  return lowerBound; \\\n"
+  "}\n"
+  "TACO_DEFINE_FOR_INDEX_TYPES(TACO_DEFINE_INDEX_SEARCHES)\n"
+  // Compare every coordinate of a block of array a with every coordinate of a
+  // block of array b, by comparing a with each rotation of b, and return a
+  // mask with the bytes of the coordinates of a that are in b set. Blocks are
+  // one vector register of TACO_BLOCK_SIZE coordinates of the given size in
+  // bytes, or empty if there are no vector instructions for that size.
+  "#if __AVX2__ && !__TINYC__\n"
+  "#define TACO_BLOCK_SIZE(_bytes) ((_bytes) >= 4 ? 32 / (_bytes) : 16 / (_bytes))\n"
+  "#elif __SSE2__ && !__TINYC__\n"
+  "#define TACO_BLOCK_SIZE(_bytes) ((_bytes) <= 4 ? 16 / (_bytes) : 0)\n"
+  "#else\n"
+  "#define TACO_BLOCK_SIZE(_bytes) 0\n"
+  "#endif\n"
+  "#if __SSE2__ && !__TINYC__\n"
+  "static inline uint32_t taco_blockMatches8(const void *a, const void *b) {\n"
+  "  __m128i va = _mm_loadu_si128((const __m128i *)a);\n"
+  "  __m128i vb = _mm_loadu_si128((const __m128i *)b);\n"
+  "  __m128i matches = _mm_cmpeq_epi8(va, vb);\n"
+  "  for (int rotation = 1; rotation < 16; rotation++) {\n"
+  "    vb = _mm_or_si128(_mm_srli_si128(vb, 1), _mm_slli_si128(vb, 15));\n"
+  "    matches = _mm_or_si128(matches, _mm_cmpeq_epi8(va, vb));\n"
+  "  }\n"
+  "  return (uint32_t)_mm_movemask_epi8(matches);\n"
+  "}\n"
+  "static inline uint32_t taco_blockMatches16(const void *a, const void *b) {\n"
+  "  __m128i va = _mm_loadu_si128((const __m128i *)a);\n"
+  "  __m128i vb = _mm_loadu_si128((const __m128i *)b);\n"
+  "  __m128i matches = _mm_cmpeq_epi16(va, vb);\n"
+  "  for (int rotation = 1; rotation < 8; rotation++) {\n"
+  "    vb = _mm_or_si128(_mm_srli_si128(vb, 2), _mm_slli_si128(vb, 14));\n"
+  "    matches = _mm_or_si128(matches, _mm_cmpeq_epi16(va, vb));\n"
+  "  }\n"
+  "  return (uint32_t)_mm_movemask_epi8(matches);\n"
+  "}\n"
+  "#endif\n"
+  "#if __AVX2__ && !__TINYC__\n"
+  "static inline uint32_t taco_blockMatches32(const void *a, const void *b) {\n"
+  "  const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);\n"
+  "  __m256i va = _mm256_loadu_si256((const __m256i *)a);\n"
+  "  __m256i vb = _mm256_loadu_si256((const __m256i *)b);\n"
+  "  __m256i matches = _mm256_cmpeq_epi32(va, vb);\n"
+  "  for (int rotation = 1; rotation < 8; rotation++) {\n"
+  "    vb = _mm256_permutevar8x32_epi32(vb, rotate);\n"
+  "    matches = _mm256_or_si256(matches, _mm256_cmpeq_epi32(va, vb));\n"
+  "  }\n"
+  "  return (uint32_t)_mm256_movemask_epi8(matches);\n"
+  "}\n"
+  "static inline uint32_t taco_blockMatches64(const void *a, const void *b) {\n"
+  "  __m256i va = _mm256_loadu_si256((const __m256i *)a);\n"
+  "  __m256i vb = _mm256_loadu_si256((const __m256i *)b);\n"
+  "  __m256i matches = _mm256_cmpeq_epi64(va, vb);\n"
+  "  for (int rotation = 1; rotation < 4; rotation++) {\n"
+  "    vb = _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0, 3, 2, 1));\n"
+  "    matches = _mm256_or_si256(matches, _mm256_cmpeq_epi64(va, vb));\n"
+  "  }\n"
+  "  return (uint32_t)_mm256_movemask_epi8(matches);\n"
+  "}\n"
+  "#elif __SSE2__ && !__TINYC__\n"
+  "static inline uint32_t taco_blockMatches32(const void *a, const void *b) {\n"
+  "  __m128i va = _mm_loadu_si128((const __m128i *)a);\n"
+  "  __m128i vb = _mm_loadu_si128((const __m128i *)b);\n"
+  "  __m128i matches = _mm_cmpeq_epi32(va, vb);\n"
+  "  for (int rotation = 1; rotation < 4; rotation++) {\n"
+  "    vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));\n"
+  "    matches = _mm_or_si128(matches, _mm_cmpeq_epi32(va, vb));\n"
+  "  }\n"
+  "  return (uint32_t)_mm_movemask_epi8(matches);\n"
+  "}\n"
+  "#endif\n"
+  "static inline uint32_t taco_blockMatches(int bytes, const void *a, const void *b) {\n"
+  "  switch (TACO_BLOCK_SIZE(bytes) > 0 ? bytes : 0) {\n"
+  "#if __SSE2__ && !__TINYC__\n"
+  "    case 1: return taco_blockMatches8(a, b);\n"
+  "    case 2: return taco_blockMatches16(a, b);\n"
+  "    case 4: return taco_blockMatches32(a, b);\n"
+  "#endif\n"
+  "#if __AVX2__ && !__TINYC__\n"
+  "    case 8: return taco_blockMatches64(a, b);\n"
+  "#endif\n"
+  "    default: return 0;\n"
+  "  }\n"
+  "}\n"
+  // Return the first position in [aBegin, aEnd) of array a whose coordinate
+  // is also in [bBegin, bEnd) of array b, or aEnd if there is none. Both
+  // ranges must be sorted and without duplicates. Blocks that overlap are
+  // compared all against all at once, blocks below the other array's current
+  // coordinate are skipped by galloping, and the remainder that does not fill
+  // a block is merged one coordinate at a time.
+  "#define TACO_DEFINE_INDEX_INTERSECT(T) \\\n"
+  "static inline int64_t taco_simdIntersect_##T(T *a, int64_t aBegin, int64_t aEnd, T *b, int64_t bBegin, int64_t bEnd) { \\\n"
+  "  const int64_t width = TACO_BLOCK_SIZE(sizeof(T)); \\\n"
+  "  int64_t i = aBegin; \\\n"
+  "  int64_t j = bBegin; \\\n"
+  "  while (width > 0 && i + width <= aEnd && j + width <= bEnd) { \\\n"
+  "    T aLast = a[i + width - 1]; \\\n"
+  "    T bLast = b[j + width - 1]; \\\n"
+  "    if (aLast < b[j]) { \\\n"
+  "      i = taco_simdGallop_##T(a, i + width, aEnd, b[j]); \\\n"
+  "    } else if (bLast < a[i]) { \\\n"
+  "      j = taco_simdGallop_##T(b, j + width, bEnd, a[i]); \\\n"
+  "    } else { \\\n"
+  "      uint32_t matches = taco_blockMatches(sizeof(T), &a[i], &b[j]); \\\n"
+  "      if (matches != 0) { \\\n"
+  "        return i + taco_ctz64(matches) / (int64_t)sizeof(T); \\\n"
+  "      } \\\n"
+  "      i += (aLast <= bLast) ? width : 0; \\\n"
+  "      j += (bLast <= aLast) ? width : 0; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  while (i < aEnd && j < bEnd) { \\\n"
+  "    if (a[i] < b[j]) { \\\n"
+  "      i++; \\\n"
+  "    } else if (b[j] < a[i]) { \\\n"
+  "      j++; \\\n"
+  "    } else { \\\n"
+  "      return i; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  return aEnd; \\\n"
+  "}\n"
+  "TACO_DEFINE_FOR_INDEX_TYPES(TACO_DEFINE_INDEX_INTERSECT)\n"
+  // Replace the n counts in array with their exclusive prefix sum and return
+  // their total. Every thread scans a chunk of the counts, and then offsets
+  // its chunk by the totals of the chunks before it.
+  "#define TACO_DEFINE_PREFIX_SUM(T) \\\n"
+  "static inline T taco_prefixSum_##T(T *array, int64_t n) { \\\n"
+  "  int numChunks = omp_get_max_threads(); \\\n"
+  "  if (n < 4096 * (int64_t)numChunks) { \\\n"
+  "    numChunks = 1; \\\n"
+  "  } \\\n"
+  "  int64_t chunkSize = (n + numChunks - 1) / numChunks; \\\n"
+  "  T *chunkSums = (T *)calloc(numChunks + 1, sizeof(T)); \\\n"
+  "  _Pragma(\"omp parallel for schedule(static, 1)\") \\\n"
+  "  for (int chunk = 0; chunk < numChunks; chunk++) { \\\n"
+  "    int64_t end = TACO_MIN(n, (chunk + 1) * chunkSize); \\\n"
+  "    T sum = 0; \\\n"
+  "    for (int64_t i = chunk * chunkSize; i < end; i++) { \\\n"
+  "      T count = array[i]; \\\n"
+  "      array[i] = sum; \\\n"
+  "      sum += count; \\\n"
+  "    } \\\n"
+  "    chunkSums[chunk + 1] = sum; \\\n"
+  "  } \\\n"
+  "  for (int chunk = 0; chunk < numChunks; chunk++) { \\\n"
+  "    chunkSums[chunk + 1] += chunkSums[chunk]; \\\n"
+  "  } \\\n"
+  "  _Pragma(\"omp parallel for schedule(static, 1)\") \\\n"
+  "  for (int chunk = 1; chunk < numChunks; chunk++) { \\\n"
+  "    int64_t end = TACO_MIN(n, (chunk + 1) * chunkSize); \\\n"
+  "    for (int64_t i = chunk * chunkSize; i < end; i++) { \\\n"
+  "      array[i] += chunkSums[chunk]; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  T total = chunkSums[numChunks]; \\\n"
+  "  free(chunkSums); \\\n"
+  "  return total; \\\n"
+  "}\n"
+  "TACO_DEFINE_FOR_INDEX_TYPES(TACO_DEFINE_PREFIX_SUM)\n"
+  // Return buffer id of the workspace arena, which holds at least size bytes
+  // and is kept across calls of the kernels (per calling thread). Buffers are
+  // zeroed when they are allocated or grown. The per-thread arenas are found
+  // through a pthread key rather than __thread, which libtcc does not support,
+  // and are also kept in a list so that taco_arenaRelease can free them. A
+  // thread's arena is freed when the thread exits.
+  "#define TACO_MAX_ARENA_BUFFERS 65\n"
+  "#define TACO_SORT_ARENA_BUFFER 64\n"
+  "typedef struct taco_arena {\n"
+  "  void* buffers[TACO_MAX_ARENA_BUFFERS];\n"
+  "  int64_t sizes[TACO_MAX_ARENA_BUFFERS];\n"
+  "  struct taco_arena* next;\n"
+  "} taco_arena_t;\n"
+  "static pthread_key_t taco_arenaKey;\n"
+  "static pthread_once_t taco_arenaKeyOnce = PTHREAD_ONCE_INIT;\n"
+  "static pthread_mutex_t taco_arenaLock = PTHREAD_MUTEX_INITIALIZER;\n"
+  "static taco_arena_t* taco_arenas = NULL;\n"
+  "static int taco_arenaKeyCreated = 0;\n"
+  "static int taco_arenaUsers = 0;\n"
+  "static void taco_arenaFree(taco_arena_t* arena) {\n"
+  "  for (int i = 0; i < TACO_MAX_ARENA_BUFFERS; i++) {\n"
+  "    free(arena->buffers[i]);\n"
+  "  }\n"
+  "  free(arena);\n"
+  "}\n"
+  "static void taco_arenaExitThread(void* arena) {\n"
+  "  int found = 0;\n"
+  "  pthread_mutex_lock(&taco_arenaLock);\n"
+  "  for (taco_arena_t** link = &taco_arenas; *link; link = &(*link)->next) {\n"
+  "    if (*link == arena) {\n"
+  "      *link = (*link)->next;\n"
+  "      found = 1;\n"
+  "      break;\n"
+  "    }\n"
+  "  }\n"
+  "  pthread_mutex_unlock(&taco_arenaLock);\n"
+  "  if (found) {\n"
+  "    taco_arenaFree((taco_arena_t*)arena);\n"
+  "  }\n"
+  "}\n"
+  "static void taco_arenaCreateKey(void) {\n"
+  "  taco_arenaKeyCreated =\n"
+  "      pthread_key_create(&taco_arenaKey, taco_arenaExitThread) == 0;\n"
+  "}\n"
+  "static taco_arena_t* taco_arena(void) {\n"
+  "  pthread_once(&taco_arenaKeyOnce, taco_arenaCreateKey);\n"
+  "  taco_arena_t* arena = (taco_arena_t*)pthread_getspecific(taco_arenaKey);\n"
+  "  if (!arena) {\n"
+  "    arena = (taco_arena_t*)calloc(1, sizeof(taco_arena_t));\n"
+  "    pthread_setspecific(taco_arenaKey, arena);\n"
+  "    pthread_mutex_lock(&taco_arenaLock);\n"
+  "    arena->next = taco_arenas;\n"
+  "    taco_arenas = arena;\n"
+  "    pthread_mutex_unlock(&taco_arenaLock);\n"
+  "  }\n"
+  "  return arena;\n"
+  "}\n"
+  // Every loader of the code (e.g. a module that opens the library) retains
+  // the arenas, and releases them before it unloads the code. The last release
+  // frees the arenas of all threads and deletes the pthread keys, so that no
+  // destructor of the unloaded code runs at thread exit. Kernels that are
+  // called after it create the keys and arenas again.
+  "void taco_arenaRetain(void) {\n"
+  "  pthread_mutex_lock(&taco_arenaLock);\n"
+  "  taco_arenaUsers++;\n"
+  "  pthread_mutex_unlock(&taco_arenaLock);\n"
+  "}\n"
+  "void taco_arenaRelease(void) {\n"
+  "  pthread_mutex_lock(&taco_arenaLock);\n"
+  "  if (--taco_arenaUsers <= 0) {\n"
+  "    while (taco_arenas) {\n"
+  "      taco_arena_t* next = taco_arenas->next;\n"
+  "      taco_arenaFree(taco_arenas);\n"
+  "      taco_arenas = next;\n"
+  "    }\n"
+  "    if (taco_arenaKeyCreated) {\n"
+  "      pthread_key_delete(taco_arenaKey);\n"
+  "      taco_arenaKeyCreated = 0;\n"
+  "    }\n"
+  "    if (taco_statusKeyCreated) {\n"
+  "      pthread_key_delete(taco_statusKey);\n"
+  "      taco_statusKeyCreated = 0;\n"
+  "    }\n"
+  "    taco_arenaKeyOnce = taco_onceInit;\n"
+  "    taco_statusKeyOnce = taco_onceInit;\n"
+  "    taco_arenaUsers = 0;\n"
+  "  }\n"
+  "  pthread_mutex_unlock(&taco_arenaLock);\n"
+  "}\n"
+  "void* taco_arenaBuffer(int32_t id, int64_t size) {\n"
+  "  taco_arena_t* arena = taco_arena();\n"
+  "  if (arena->sizes[id] < size) {\n"
+  "    free(arena->buffers[id]);\n"
+  "    arena->buffers[id] = calloc(size, 1);\n"
+  "    arena->sizes[id] = size;\n"
+  "  }\n"
+  "  return arena->buffers[id];\n"
+  "}\n"
+  "void* taco_arenaZeroedBuffer(int32_t id, int64_t size) {\n"
+  "  void* buffer = taco_arenaBuffer(id, size);\n"
+  "  memset(buffer, 0, size);\n"
+  "  return buffer;\n"
+  "}\n"
+  // Sort the n distinct indices in array, which are below dimension and whose
+  // bits are set in bits. Short lists are insertion sorted, lists that are
+  // dense for the dimension are rewritten from the set bits, and other lists
+  // are radix sorted one byte at a time, through a scratch buffer of the
+  // calling thread's arena that is kept across calls.
+  "#define TACO_DEFINE_INDEX_SORT(T) \\\n"
+  "static inline void taco_sortIndices_##T(T *array, int64_t n, int64_t dimension, uint64_t *bits) { \\\n"
+  "  if (n <= 32) { \\\n"
+  "    for (int64_t i = 1; i < n; i++) { \\\n"
+  "      T index = array[i]; \\\n"
+  "      int64_t j = i; \\\n"
+  "      while (j > 0 && array[j - 1] > index) { \\\n"
+  "        array[j] = array[j - 1]; \\\n"
+  "        j--; \\\n"
+  "      } \\\n"
+  "      array[j] = index; \\\n"
+  "    } \\\n"
+  "    return; \\\n"
+  "  } \\\n"
+  "  if ((dimension + 63) / 64 <= 16 * n) { \\\n"
+  "    int64_t found = 0; \\\n"
+  "    for (int64_t word = 0; found < n; word++) { \\\n"
+  "      uint64_t mask = bits[word]; \\\n"
+  "      while (mask != 0) { \\\n"
+  "        array[found++] = (T)(word * 64 + taco_ctz64(mask)); \\\n"
+  "        mask &= mask - 1; \\\n"
+  "      } \\\n"
+  "    } \\\n"
+  "    return; \\\n"
+  "  } \\\n"
+  "  T *buffer = (T *)taco_arenaBuffer(TACO_SORT_ARENA_BUFFER, n * sizeof(T)); \\\n"
+  "  T *from = array; \\\n"
+  "  T *to = buffer; \\\n"
+  "  for (int shift = 0; shift < 8 * (int)sizeof(T) && ((dimension - 1) >> shift) > 0; shift += 8) { \\\n"
+  "    int64_t offsets[257] = {0}; \\\n"
+  "    for (int64_t i = 0; i < n; i++) { \\\n"
+  "      offsets[((from[i] >> shift) & 255) + 1]++; \\\n"
+  "    } \\\n"
+  "    for (int digit = 0; digit < 256; digit++) { \\\n"
+  "      offsets[digit + 1] += offsets[digit]; \\\n"
+  "    } \\\n"
+  "    for (int64_t i = 0; i < n; i++) { \\\n"
+  "      to[offsets[(from[i] >> shift) & 255]++] = from[i]; \\\n"
+  "    } \\\n"
+  "    T *sorted = to; \\\n"
+  "    to = from; \\\n"
+  "    from = sorted; \\\n"
+  "  } \\\n"
+  "  if (from != array) { \\\n"
+  "    memcpy(array, from, n * sizeof(T)); \\\n"
+  "  } \\\n"
+  "}\n"
+  "TACO_DEFINE_FOR_INDEX_TYPES(TACO_DEFINE_INDEX_SORT)\n"
+  // Find the slot of coord in a hashed level's table of width slots at base,
+  // or the empty slot where it would be inserted (linear probing), for crd
+  // arrays of type T. The table is indexed by the high bits of the
+  // multiplicative hash of coord (see HashedModeFormat::hash). If the table is
+  // full, the call fails with error code 1 (stored in status) and the first
+  // slot is returned.
+  // Empty slots hold -1, so crd arrays are of signed types.
+  "#define TACO_DEFINE_HASH_LOCATE(T) \\\n"
+  "static inline int64_t taco_hashLocate_##T(T *crd, int64_t base, int64_t width, int64_t coord, int32_t *status) { \\\n"
+  "  uint64_t hash = (uint32_t)((uint32_t)coord * 2654435761u); \\\n"
+  "  int64_t slot = (int64_t)(hash >> (32 - taco_ctz64(width))); \\\n"
+  "  int64_t probes = 0; \\\n"
+  "  while (crd[base + slot] != coord && crd[base + slot] != -1) { \\\n"
+  "    if (++probes == width) { \\\n"
+  "      *status = 1; \\\n"
+  "      return base; \\\n"
+  "    } \\\n"
+  "    slot = (slot + 1) & (width - 1); \\\n"
+  "  } \\\n"
+  "  return base + slot; \\\n"
+  "}\n"
+  "TACO_DEFINE_HASH_LOCATE(int8_t)\n"
+  "TACO_DEFINE_HASH_LOCATE(int16_t)\n"
+  "TACO_DEFINE_HASH_LOCATE(int32_t)\n"
+  "TACO_DEFINE_HASH_LOCATE(int64_t)\n"
+  // Find the position of coord in a bitmap level whose bit vector below the
+  // parent starts at word base, or the reserved fill position 0 if its bit is
+  // not set, for rank arrays of type T.
+  "#define TACO_DEFINE_BITMAP_LOCATE(T) \\\n"
+  "static inline int64_t taco_bitmapLocate_##T(T *rank, uint64_t *bits, int64_t base, int64_t coord) { \\\n"
+  "  int64_t word = base + (coord >> 6); \\\n"
+  "  uint64_t bit = (uint64_t)1 << (coord & 63); \\\n"
+  "  if (!(bits[word] & bit)) { \\\n"
+  "    return 0; \\\n"
+  "  } \\\n"
+  "  return rank[word] + taco_popcount64(bits[word] & (bit - 1)); \\\n"
+  "}\n"
+  "TACO_DEFINE_FOR_INDEX_TYPES(TACO_DEFINE_BITMAP_LOCATE)\n"
   "taco_tensor_t* init_taco_tensor_t(int32_t order, int32_t csize,\n"
   "                                  int32_t* dimensions, int32_t* mode_ordering,\n"
   "                                  taco_mode_t* mode_types) {\n"
@@ -592,7 +1125,9 @@ void CodeGen_C::generateShim(const Stmt& func, stringstream &ret) {
   const Function *funcPtr = func.as<Function>();
 
   ret << "int _shim_" << funcPtr->name << "(void** parameterPack) {\n";
-  ret << "  return " << funcPtr->name << "(";
+  ret << "  int32_t status = 0;\n";
+  ret << "  taco_setCallStatus(&status);\n";
+  ret << "  int ret = " << funcPtr->name << "(";
 
   size_t i=0;
   string delimiter = "";
@@ -624,6 +1159,8 @@ void CodeGen_C::generateShim(const Stmt& func, stringstream &ret) {
     delimiter = ", ";
   }
   ret << ");\n";
+  ret << "  taco_setCallStatus(NULL);\n";
+  ret << "  return (ret != 0) ? ret : status;\n";
   ret << "}\n";
 }
 }
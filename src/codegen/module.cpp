@@ -2,8 +2,19 @@
 
 #include <iostream>
 #include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
 #include <dlfcn.h>
+#include <dirent.h>
 #include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+#ifdef TACO_TCC
+#include <libtcc.h>
+#endif
 #if USE_OPENMP
 #include <omp.h>
 #endif
@@ -26,11 +37,17 @@ std::default_random_engine Module::gen = std::default_random_engine();
 std::uniform_int_distribution<int> Module::randint =
     std::uniform_int_distribution<int>(0, chars.length() - 1);
 
+// Modules may be created concurrently by threads compiling kernels in the
+// background, so access to the shared generator and tmpdir is serialized.
+static std::mutex jitNameMutex;
+
 void Module::setJITTmpdir() {
+  std::lock_guard<std::mutex> lock(jitNameMutex);
   tmpdir = util::getTmpdir();
 }
 
 void Module::setJITLibname() {
+  std::lock_guard<std::mutex> lock(jitNameMutex);
   libname.resize(12);
   for (int i=0; i<12; i++)
     libname[i] = chars[randint(gen)];
@@ -40,7 +57,7 @@ void Module::addFunction(Stmt func) {
   funcs.push_back(func);
 }
 
-void Module::compileToSource(string path, string prefix) {
+void Module::generateSource() {
   if (!moduleFromUserSource) {
   
     // create a codegen instance and add all the funcs
@@ -64,7 +81,9 @@ void Module::compileToSource(string path, string prefix) {
       didGenRuntime = true;
     }
   }
+}
 
+void Module::writeSource(string path, string prefix) {
   ofstream source_file;
   string file_ending = should_use_CUDA_codegen() ? ".cu" : ".c";
   source_file.open(path+prefix+file_ending);
@@ -77,13 +96,18 @@ void Module::compileToSource(string path, string prefix) {
   header_file.close();
 }
 
+void Module::compileToSource(string path, string prefix) {
+  generateSource();
+  writeSource(path, prefix);
+}
+
 void Module::compileToStaticLibrary(string path, string prefix) {
   taco_tassert(false) << "Compiling to a static library is not supported";
 }
   
 namespace {
 
-void writeShims(vector<Stmt> funcs, string path, string prefix) {
+string generateShims(const vector<Stmt>& funcs) {
   stringstream shims;
   for (auto func: funcs) {
     if (should_use_CUDA_codegen()) {
@@ -93,7 +117,10 @@ void writeShims(vector<Stmt> funcs, string path, string prefix) {
       CodeGen_C::generateShim(func, shims);
     }
   }
-  
+  return shims.str();
+}
+
+void writeShims(vector<Stmt> funcs, string path, string prefix) {
   ofstream shims_file;
   if (should_use_CUDA_codegen()) {
     shims_file.open(path+prefix+"_shims.cpp");
@@ -102,13 +129,250 @@ void writeShims(vector<Stmt> funcs, string path, string prefix) {
     shims_file.open(path+prefix+".c", ios::app);
   }
   shims_file << "#include \"" << path << prefix << ".h\"\n";
-  shims_file << shims.str();
+  shims_file << generateShims(funcs);
   shims_file.close();
 }
 
+/// The persistent kernel cache is enabled by pointing TACO_CACHE_DIR at a
+/// writable directory. Returns the directory with a trailing slash, or the
+/// empty string if caching is disabled.
+string getKernelCacheDir() {
+  string cachedir = util::getFromEnv("TACO_CACHE_DIR", "");
+  if (cachedir.empty()) {
+    return cachedir;
+  }
+  if (cachedir.back() != '/') {
+    cachedir += '/';
+  }
+  int err = mkdir(cachedir.c_str(), 0755);
+  taco_uassert(err == 0 || errno == EEXIST) <<
+    "Unable to create kernel cache directory " << cachedir << ". Please set "
+    "the environment variable TACO_CACHE_DIR to somewhere writable";
+  return cachedir;
+}
+
+/// Maximum total size of the shared libraries kept in the kernel cache,
+/// configured in megabytes through TACO_CACHE_MAX_SIZE.
+off_t getKernelCacheMaxSize() {
+  return (off_t)std::stoll(util::getFromEnv("TACO_CACHE_MAX_SIZE", "1024"))
+         * 1024 * 1024;
+}
+
+/// The 128-bit FNV-1a hash of str, as four 32-bit limbs from least to most
+/// significant.
+vector<uint64_t> fnv1a128(const string& str) {
+  // 2^88 + 0x13b
+  const uint64_t prime[4] = {0x13b, 0, 1 << 24, 0};
+  vector<uint64_t> hash = {0x6295c58d, 0x62b82175, 0x07bb0142, 0x6c62272e};
+  for (unsigned char c : str) {
+    hash[0] ^= c;
+    uint64_t product[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4; i++) {
+      uint64_t carry = 0;
+      for (int j = 0; i + j < 4; j++) {
+        uint64_t limb = product[i + j] + hash[i] * prime[j] + carry;
+        product[i + j] = limb & 0xffffffff;
+        carry = limb >> 32;
+      }
+    }
+    hash.assign(product, product + 4);
+  }
+  return hash;
+}
+
+/// The text that identifies a compiled library. The generated source is a
+/// canonical rendering of the concretized statement, including the formats,
+/// data types and target of its tensors, so together with the compiler
+/// invocation it identifies the compiled library.
+string getKernelCacheText(const string& source, const string& cc,
+                          const string& cflags) {
+  return source + '\0' + cc + '\0' + cflags;
+}
+
+/// Compute the cache key of a kernel, which is the hash of its cache text.
+string getKernelCacheKey(const string& text) {
+  const vector<uint64_t> hash = fnv1a128(text);
+  stringstream hex;
+  hex << std::hex << std::setfill('0');
+  for (int i = 3; i >= 0; i--) {
+    hex << std::setw(8) << hash[i];
+  }
+  return hex.str();
+}
+
+/// The path of the file that holds the cache text of a cached library.
+string getKernelCacheTextPath(const string& cachedpath) {
+  return cachedpath.substr(0, cachedpath.size() - 3) + ".key";
+}
+
+/// True if the library at cachedpath was compiled from text, which guards
+/// against loading the wrong kernel when two cache keys collide.
+bool isInKernelCache(const string& cachedpath, const string& text) {
+  if (access(cachedpath.c_str(), R_OK) != 0) {
+    return false;
+  }
+  ifstream file(getKernelCacheTextPath(cachedpath), ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  stringstream cachedText;
+  cachedText << file.rdbuf();
+  return cachedText.str() == text;
+}
+
+/// Atomically write the stream src to path by writing it to a file that is
+/// private to this process and renaming it into place.
+void publishFile(istream& src, const string& path, const string& libname) {
+  const string tmppath = path + "." + libname + ".tmp";
+  {
+    ofstream dst(tmppath, ios::binary);
+    if (!dst.is_open()) {
+      return;
+    }
+    dst << src.rdbuf();
+    if (!dst.good()) {
+      dst.close();
+      remove(tmppath.c_str());
+      return;
+    }
+  }
+  if (rename(tmppath.c_str(), path.c_str()) != 0) {
+    remove(tmppath.c_str());
+  }
+}
+
+/// Publish a compiled library and its cache text into the cache. Both are
+/// renamed into place, so concurrent processes never observe a partially
+/// written library, and the text is published first so that a library is
+/// only found once its text can be compared.
+void publishToKernelCache(const string& libpath, const string& cachedpath,
+                          const string& libname, const string& text) {
+  ifstream lib(libpath, ios::binary);
+  if (!lib.is_open()) {
+    return;
+  }
+  stringstream textStream(text);
+  publishFile(textStream, getKernelCacheTextPath(cachedpath), libname);
+  publishFile(lib, cachedpath, libname);
+}
+
+/// Evict least recently used libraries until the cache fits in its budget.
+/// Cache hits refresh the modification time of a library, so the oldest
+/// modification time identifies the least recently used entry.
+void evictFromKernelCache(const string& cachedir, off_t maxSize) {
+  DIR* dir = opendir(cachedir.c_str());
+  if (!dir) {
+    return;
+  }
+  vector<pair<time_t,pair<off_t,string>>> entries;
+  off_t totalSize = 0;
+  while (struct dirent* entry = readdir(dir)) {
+    const string name = entry->d_name;
+    if (name.size() < 3 || name.compare(name.size() - 3, 3, ".so") != 0) {
+      continue;
+    }
+    const string path = cachedir + name;
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+      continue;
+    }
+    entries.push_back({info.st_mtime, {info.st_size, path}});
+    totalSize += info.st_size;
+  }
+  closedir(dir);
+
+  std::sort(entries.begin(), entries.end());
+  for (const auto& entry : entries) {
+    if (totalSize <= maxSize) {
+      break;
+    }
+    // Other processes may have already evicted the library, and processes
+    // that have it loaded keep their mapping after it is removed.
+    remove(entry.second.second.c_str());
+    remove(getKernelCacheTextPath(entry.second.second).c_str());
+    totalSize -= entry.second.first;
+  }
+}
+
 } // anonymous namespace
 
+Module::~Module() {
+  unload();
+}
+
+void Module::unload() {
+  // The workspace arenas of the generated code would leak once it is unloaded
+  if (lib_handle) {
+    callArenaFunction("taco_arenaRelease");
+    dlclose(lib_handle);
+    lib_handle = nullptr;
+  }
+#ifdef TACO_TCC
+  if (jit_state) {
+    callArenaFunction("taco_arenaRelease");
+    tcc_delete(static_cast<TCCState*>(jit_state));
+    jit_state = nullptr;
+  }
+#endif
+}
+
+void Module::callArenaFunction(const std::string& name) {
+  // Code that was set by the user need not define the arena functions
+  void* ptr = getFuncPtr(name);
+  if (ptr) {
+    void (*func)(void);
+    *reinterpret_cast<void**>(&func) = ptr;
+    func();
+  }
+}
+
+bool Module::compileInProcess() {
+#ifdef TACO_TCC
+  TCCState* state = tcc_new();
+  if (!state) {
+    return false;
+  }
+  // Errors are not fatal since the system compiler is used as a fallback.
+  tcc_set_error_func(state, nullptr, [](void*, const char*) {});
+  tcc_set_output_type(state, TCC_OUTPUT_MEMORY);
+
+  // The generated functions precede their shims, so unlike the shims file
+  // written for the system compiler the header need not be included.
+  const string code = source.str() + "\n" + generateShims(funcs);
+  bool compiled = tcc_compile_string(state, code.c_str()) != -1 &&
+                  tcc_add_library(state, "m") != -1 &&
+                  tcc_add_library(state, "pthread") != -1;
+#ifdef TCC_RELOCATE_AUTO
+  compiled = compiled && tcc_relocate(state, TCC_RELOCATE_AUTO) >= 0;
+#else
+  compiled = compiled && tcc_relocate(state) >= 0;
+#endif
+  if (!compiled) {
+    tcc_delete(state);
+    return false;
+  }
+  unload();
+  jit_state = state;
+  callArenaFunction("taco_arenaRetain");
+  return true;
+#else
+  return false;
+#endif
+}
+
 string Module::compile() {
+  generateSource();
+
+  // the in-process compiler reads the source from memory, so only the system
+  // compiler needs it written out
+  if (target.backend == Target::TCC && !should_use_CUDA_codegen() &&
+      compileInProcess()) {
+    return "";
+  }
+
+  // open the output file & write out the source
+  writeSource(tmpdir, libname);
+
   string prefix = tmpdir+libname;
   string fullpath = prefix + ".so";
   
@@ -145,23 +409,39 @@ string Module::compile() {
     prefix + file_ending + " " + shims_file + " " + 
     "-o " + fullpath + " -lm";
 
-  // open the output file & write out the source
-  compileToSource(tmpdir, libname);
-  
-  // write out the shims
-  writeShims(funcs, tmpdir, libname);
-  
-  // now compile it
-  int err = system(cmd.data());
-  taco_uassert(err == 0) << "Compilation command failed:\n" << cmd
-    << "\nreturned " << err;
+  // reuse a library compiled by an earlier process if one is cached
+  string cachedir = getKernelCacheDir();
+  string cachedpath;
+  string cachetext;
+  if (!cachedir.empty()) {
+    cachetext = getKernelCacheText(source.str(), cc, cflags);
+    cachedpath = cachedir + getKernelCacheKey(cachetext) + ".so";
+    if (isInKernelCache(cachedpath, cachetext)) {
+      utime(cachedpath.c_str(), nullptr);
+      fullpath = cachedpath;
+    }
+  }
 
-  // use dlsym() to open the compiled library
-  if (lib_handle) {
-    dlclose(lib_handle);
+  if (fullpath != cachedpath) {
+    // write out the shims
+    writeShims(funcs, tmpdir, libname);
+
+    // now compile it
+    int err = system(cmd.data());
+    taco_uassert(err == 0) << "Compilation command failed:\n" << cmd
+      << "\nreturned " << err;
+
+    if (!cachedir.empty()) {
+      publishToKernelCache(fullpath, cachedpath, libname, cachetext);
+      evictFromKernelCache(cachedir, getKernelCacheMaxSize());
+    }
   }
+
+  // use dlsym() to open the compiled library
+  unload();
   lib_handle = dlopen(fullpath.data(), RTLD_NOW | RTLD_LOCAL);
   taco_uassert(lib_handle) << "Failed to load generated code, error is: " << dlerror();
+  callArenaFunction("taco_arenaRetain");
 
   return fullpath;
 }
@@ -176,44 +456,100 @@ string Module::getSource() {
 }
 
 void* Module::getFuncPtr(std::string name) {
+#ifdef TACO_TCC
+  if (jit_state) {
+    return tcc_get_symbol(static_cast<TCCState*>(jit_state), name.data());
+  }
+#endif
   return dlsym(lib_handle, name.data());
 }
 
-int Module::callFuncPackedRaw(std::string name, void** args) {
-  typedef int (*fnptr_t)(void**);
+typedef int (*fnptr_t)(void**);
+
+static fnptr_t getPackedFunc(Module* module, std::string name) {
   static_assert(sizeof(void*) == sizeof(fnptr_t),
     "Unable to cast dlsym() returned void pointer to function pointer");
-  void* v_func_ptr = getFuncPtr(name);
+  void* v_func_ptr = module->getFuncPtr(name);
   fnptr_t func_ptr;
   *reinterpret_cast<void**>(&func_ptr) = v_func_ptr;
+  return func_ptr;
+}
 
 #if USE_OPENMP
-  omp_sched_t existingSched;
-  ParallelSchedule tacoSched;
-  int existingChunkSize, tacoChunkSize;
-  int existingNumThreads = omp_get_max_threads();
-  omp_get_schedule(&existingSched, &existingChunkSize);
-  taco_get_parallel_schedule(&tacoSched, &tacoChunkSize);
-  switch (tacoSched) {
-    case ParallelSchedule::Static:
-      omp_set_schedule(omp_sched_static, tacoChunkSize);
-      break;
-    case ParallelSchedule::Dynamic:
-      omp_set_schedule(omp_sched_dynamic, tacoChunkSize);
-      break;
-    default:
-      break;
+namespace {
+/// Sets the OpenMP schedule and number of threads to taco's while it is in
+/// scope, and restores the previous ones afterwards.
+class TacoParallelSchedule {
+public:
+  TacoParallelSchedule() {
+    ParallelSchedule tacoSched;
+    int tacoChunkSize;
+    existingNumThreads = omp_get_max_threads();
+    omp_get_schedule(&existingSched, &existingChunkSize);
+    taco_get_parallel_schedule(&tacoSched, &tacoChunkSize);
+    switch (tacoSched) {
+      case ParallelSchedule::Static:
+        omp_set_schedule(omp_sched_static, tacoChunkSize);
+        break;
+      case ParallelSchedule::Dynamic:
+        omp_set_schedule(omp_sched_dynamic, tacoChunkSize);
+        break;
+      default:
+        break;
+    }
+    omp_set_num_threads(taco_get_num_threads());
   }
-  omp_set_num_threads(taco_get_num_threads());
-#endif
 
-  int ret = func_ptr(args);
+  ~TacoParallelSchedule() {
+    omp_set_schedule(existingSched, existingChunkSize);
+    omp_set_num_threads(existingNumThreads);
+  }
 
+private:
+  omp_sched_t existingSched;
+  int existingChunkSize;
+  int existingNumThreads;
+};
+}
+#endif
+
+int Module::callFuncPackedRaw(std::string name, void** args) {
+  fnptr_t func_ptr = getPackedFunc(this, name);
 #if USE_OPENMP
-  omp_set_schedule(existingSched, existingChunkSize);
-  omp_set_num_threads(existingNumThreads);
+  TacoParallelSchedule schedule;
 #endif
+  return func_ptr(args);
+}
 
+int Module::callFuncPackedBatchRaw(std::string name,
+                                   const std::vector<void**>& argsBatch) {
+  fnptr_t func_ptr = getPackedFunc(this, name);
+  const int64_t batchSize = (int64_t)argsBatch.size();
+  int ret = 0;
+#if USE_OPENMP
+  TacoParallelSchedule schedule;
+  #pragma omp parallel
+  {
+    // Every thread calls the function on its own batch elements, so the
+    // parallel loops of the function run on one thread
+    omp_set_num_threads(1);
+    #pragma omp for schedule(runtime)
+    for (int64_t i = 0; i < batchSize; i++) {
+      int result = func_ptr(argsBatch[i]);
+      if (result != 0) {
+        #pragma omp atomic write
+        ret = result;
+      }
+    }
+  }
+#else
+  for (int64_t i = 0; i < batchSize; i++) {
+    int result = func_ptr(argsBatch[i]);
+    if (result != 0) {
+      ret = result;
+    }
+  }
+#endif
   return ret;
 }
 
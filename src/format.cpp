@@ -9,6 +9,10 @@
 #include "taco/lower/mode_format_dense.h"
 #include "taco/lower/mode_format_compressed.h"
 #include "taco/lower/mode_format_singleton.h"
+#include "taco/lower/mode_format_hashed.h"
+#include "taco/lower/mode_format_bitmap.h"
+#include "taco/lower/mode_format_diagonal.h"
+#include "taco/lower/mode_format_ell.h"
 
 #include "taco/error.h"
 #include "taco/util/strings.h"
@@ -96,6 +100,28 @@ Datatype Format::getCoordinateTypeIdx(size_t level) const {
 }
 
 void Format::setLevelArrayTypes(std::vector<std::vector<Datatype>> levelArrayTypes) {
+  // The generated code defines its index search, prefix sum and sort helpers
+  // for these types only
+  const std::vector<ModeFormat> modeFormats = getModeFormats();
+  for (size_t level = 0; level < levelArrayTypes.size(); level++) {
+    for (size_t i = 0; i < levelArrayTypes[level].size(); i++) {
+      const Datatype type = levelArrayTypes[level][i];
+      const string name = (level < modeFormats.size())
+                          ? modeFormats[level].getName() : "";
+      if (i == 1 && name == ModeFormat::Bitmap.getName()) {
+        taco_uassert(type == UInt64)
+            << "The bit vector of a bitmap level must be of type uint64_t";
+        continue;
+      }
+      taco_uassert((type.isInt() || type.isUInt()) && type.getNumBits() <= 64)
+          << "Level arrays must be of an integer type of at most 64 bits, "
+          << "not " << type;
+      taco_uassert(i != 1 || name != ModeFormat::Hashed.getName() ||
+                   type.isInt())
+          << "The crd array of a hashed level must be of a signed type, "
+          << "since its empty slots hold -1";
+    }
+  }
   this->levelArrayTypes = levelArrayTypes;
 }
 
@@ -120,6 +146,12 @@ bool operator==(const Format& a, const Format& b){
       return false;
     }
   } 
+  for (int i = 0; i < a.getOrder(); i++) {
+    if (a.getCoordinateTypePos(i) != b.getCoordinateTypePos(i) ||
+        a.getCoordinateTypeIdx(i) != b.getCoordinateTypeIdx(i)) {
+      return false;
+    }
+  }
   return true;
 }
 
@@ -384,26 +416,44 @@ ModeFormat ModeFormat::Dense(std::make_shared<DenseModeFormat>());
 ModeFormat ModeFormat::Compressed(std::make_shared<CompressedModeFormat>());
 ModeFormat ModeFormat::Sparse = ModeFormat::Compressed;
 ModeFormat ModeFormat::Singleton(std::make_shared<SingletonModeFormat>());
+ModeFormat ModeFormat::Hashed(std::make_shared<HashedModeFormat>());
+ModeFormat ModeFormat::Bitmap(std::make_shared<BitmapModeFormat>());
+ModeFormat ModeFormat::Diagonal(std::make_shared<DiagonalModeFormat>());
+ModeFormat ModeFormat::Ell(std::make_shared<EllModeFormat>());
 
 ModeFormat ModeFormat::dense = ModeFormat::Dense;
 ModeFormat ModeFormat::compressed = ModeFormat::Compressed;
 ModeFormat ModeFormat::sparse = ModeFormat::Compressed;
 ModeFormat ModeFormat::singleton = ModeFormat::Singleton;
+ModeFormat ModeFormat::hashed = ModeFormat::Hashed;
+ModeFormat ModeFormat::bitmap = ModeFormat::Bitmap;
+ModeFormat ModeFormat::diagonal = ModeFormat::Diagonal;
+ModeFormat ModeFormat::ell = ModeFormat::Ell;
 
 const ModeFormat Dense = ModeFormat::Dense;
 const ModeFormat Compressed = ModeFormat::Compressed;
 const ModeFormat Sparse = ModeFormat::Compressed;
 const ModeFormat Singleton = ModeFormat::Singleton;
+const ModeFormat Hashed = ModeFormat::Hashed;
+const ModeFormat Bitmap = ModeFormat::Bitmap;
+const ModeFormat Diagonal = ModeFormat::Diagonal;
+const ModeFormat Ell = ModeFormat::Ell;
 
 const ModeFormat dense = ModeFormat::Dense;
 const ModeFormat compressed = ModeFormat::Compressed;
 const ModeFormat sparse = ModeFormat::Compressed;
 const ModeFormat singleton = ModeFormat::Singleton;
+const ModeFormat hashed = ModeFormat::Hashed;
+const ModeFormat bitmap = ModeFormat::Bitmap;
+const ModeFormat diagonal = ModeFormat::Diagonal;
+const ModeFormat ell = ModeFormat::Ell;
 
 const Format CSR({Dense, Sparse}, {0,1});
 const Format CSC({Dense, Sparse}, {1,0});
 const Format DCSR({Sparse, Sparse}, {0,1});
 const Format DCSC({Sparse, Sparse}, {1,0});
+const Format BCSR({Dense, Sparse, Dense, Dense}, {0,1,2,3});
+const Format DIA({Dense, Diagonal}, {0,1});
 
 const Format COO(int order, bool isUnique, bool isOrdered, bool isAoS, 
                  const std::vector<int>& modeOrdering) {
@@ -430,6 +480,18 @@ const Format COO(int order, bool isUnique, bool isOrdered, bool isAoS,
          : Format(modeTypes, modeOrdering);
 }
 
+const Format BCSF(int order) {
+  taco_uassert(order > 0);
+  std::vector<ModeFormatPack> modeTypes(order, Sparse);
+  modeTypes.insert(modeTypes.end(), order, Dense);
+  return Format(modeTypes);
+}
+
+const Format SELL(int sliceHeight, int sortWindow) {
+  return Format({Dense, ModeFormat(std::make_shared<EllModeFormat>(
+                            sliceHeight, sortWindow))});
+}
+
 bool isDense(const Format& format) {
   for (ModeFormat modeFormat : format.getModeFormats()) {
     if (modeFormat != Dense) {
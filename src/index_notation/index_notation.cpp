@@ -622,6 +622,221 @@ bool isomorphic(IndexStmt a, IndexStmt b) {
   return Isomorphic().check(a,b);
 }
 
+/// Computes a hash of index notation that is invariant under the renaming that
+/// `isomorphic` allows: tensor and index variables are numbered in the order
+/// they are first encountered, which is the order in which `Isomorphic` pairs
+/// them up, and tensor variables additionally contribute their type and format.
+struct StructuralHash : public IndexNotationVisitorStrict {
+  size_t result = 0;
+  std::map<TensorVar,size_t> tensorIds;
+  std::map<IndexVar,size_t> varIds;
+
+  void combine(size_t value) {
+    result ^= value + 0x9e3779b97f4a7c15ULL + (result << 6) + (result >> 2);
+  }
+
+  template <typename T>
+  void combineString(const T& value) {
+    combine(std::hash<std::string>()(util::toString(value)));
+  }
+
+  void hash(IndexExpr expr) {
+    if (!expr.defined()) {
+      combine(0);
+      return;
+    }
+    expr.accept(this);
+  }
+
+  void hash(IndexStmt stmt) {
+    if (!stmt.defined()) {
+      combine(0);
+      return;
+    }
+    stmt.accept(this);
+  }
+
+  void hash(TensorVar tensorVar) {
+    if (!util::contains(tensorIds, tensorVar)) {
+      tensorIds.insert({tensorVar, tensorIds.size()});
+      combineString(tensorVar.getType());
+      combineString(tensorVar.getFormat());
+    }
+    combine(tensorIds.at(tensorVar));
+  }
+
+  void hash(IndexVar indexVar) {
+    if (!util::contains(varIds, indexVar)) {
+      varIds.insert({indexVar, varIds.size()});
+    }
+    combine(varIds.at(indexVar));
+  }
+
+  using IndexNotationVisitorStrict::visit;
+
+  void visit(const IndexVarNode* node) {
+    // Isomorphic index variable expressions must be the same node, but their
+    // addresses are not stable across processes, so only hash the node kind.
+    combine(1);
+  }
+
+  void visit(const AccessNode* node) {
+    combine(2);
+    hash(node->tensorVar);
+    combine(node->indexVars.size());
+    for (auto& indexVar : node->indexVars) {
+      hash(indexVar);
+    }
+    combine(node->isAccessingStructure);
+    for (auto& window : node->windowedModes) {
+      combine(window.first);
+    }
+    for (auto& indexSet : node->indexSetModes) {
+      combine(indexSet.first);
+    }
+  }
+
+  void visit(const LiteralNode* node) {
+    combine(3);
+    combineString(node->getDataType());
+    const char* bytes = static_cast<const char*>(node->val);
+    combine(std::hash<std::string>()(
+        std::string(bytes, node->getDataType().getNumBytes())));
+  }
+
+  void visit(const NegNode* node) {
+    combine(4);
+    hash(node->a);
+  }
+
+  void visit(const SqrtNode* node) {
+    combine(5);
+    hash(node->a);
+  }
+
+  void visit(const AddNode* node) {
+    combine(6);
+    hash(node->a);
+    hash(node->b);
+  }
+
+  void visit(const SubNode* node) {
+    combine(7);
+    hash(node->a);
+    hash(node->b);
+  }
+
+  void visit(const MulNode* node) {
+    combine(8);
+    hash(node->a);
+    hash(node->b);
+  }
+
+  void visit(const DivNode* node) {
+    combine(9);
+    hash(node->a);
+    hash(node->b);
+  }
+
+  void visit(const CastNode* node) {
+    combine(10);
+    combineString(node->getDataType());
+    hash(node->a);
+  }
+
+  void visit(const CallIntrinsicNode* node) {
+    combine(11);
+    combineString(node->func->getName());
+    combine(node->args.size());
+    for (auto& arg : node->args) {
+      hash(arg);
+    }
+  }
+
+  void visit(const CallNode* node) {
+    combine(12);
+    combineString(node->name);
+    combine(node->args.size());
+    for (auto& arg : node->args) {
+      hash(arg);
+    }
+  }
+
+  void visit(const ReductionNode* node) {
+    combine(13);
+    hash(node->op);
+    hash(node->var);
+    hash(node->a);
+  }
+
+  void visit(const AssignmentNode* node) {
+    combine(14);
+    hash(node->lhs);
+    hash(node->rhs);
+    hash(node->op);
+  }
+
+  void visit(const YieldNode* node) {
+    combine(15);
+    combine(node->indexVars.size());
+    for (auto& indexVar : node->indexVars) {
+      hash(indexVar);
+    }
+    hash(node->expr);
+  }
+
+  void visit(const ForallNode* node) {
+    combine(16);
+    hash(node->indexVar);
+    hash(node->stmt);
+    combine((size_t)node->parallel_unit);
+    combine((size_t)node->output_race_strategy);
+    combine(node->unrollFactor);
+  }
+
+  void visit(const WhereNode* node) {
+    combine(17);
+    hash(node->consumer);
+    hash(node->producer);
+  }
+
+  void visit(const SequenceNode* node) {
+    combine(18);
+    hash(node->definition);
+    hash(node->mutation);
+  }
+
+  void visit(const AssembleNode* node) {
+    combine(19);
+    hash(node->queries);
+    hash(node->compute);
+  }
+
+  void visit(const MultiNode* node) {
+    combine(20);
+    hash(node->stmt1);
+    hash(node->stmt2);
+  }
+
+  void visit(const SuchThatNode* node) {
+    combine(21);
+    hash(node->stmt);
+    combine(node->predicate.size());
+  }
+};
+
+size_t structuralHash(IndexExpr expr) {
+  StructuralHash hasher;
+  hasher.hash(expr);
+  return hasher.result;
+}
+
+size_t structuralHash(IndexStmt stmt) {
+  StructuralHash hasher;
+  hasher.hash(stmt);
+  return hasher.result;
+}
+
 struct Equals : public IndexNotationVisitorStrict {
   bool eq = false;
   IndexExpr bExpr;
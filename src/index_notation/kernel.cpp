@@ -64,13 +64,21 @@ void unpackResults(size_t numResults, const vector<void*> arguments,
         modeIndices.push_back(ModeIndex({size}));
         num *= ((int*)tensorData->indices[i][0])[0];
       } else if (modeType.getName() == Sparse.getName()) {
-        auto size = ((int*)tensorData->indices[i][0])[num];
-        Array pos = Array(type<int>(), tensorData->indices[i][0],
-                          num+1, Array::UserOwns);
-        Array idx = Array(type<int>(), tensorData->indices[i][1],
-                          size, Array::UserOwns);
+        Array pos = Array(format.getCoordinateTypePos(i),
+                          tensorData->indices[i][0], num+1, Array::UserOwns);
+        auto size = pos.get(num).getAsIndex();
+        Array idx = Array(format.getCoordinateTypeIdx(i),
+                          tensorData->indices[i][1], size, Array::UserOwns);
         modeIndices.push_back(ModeIndex({pos, idx}));
         num = size;
+      } else if (modeType.getName() == Hashed.getName()) {
+        int width = ((int*)tensorData->indices[i][0])[0];
+        Array widthArray = makeArray({width});
+        Array idx = Array(format.getCoordinateTypeIdx(i),
+                          tensorData->indices[i][1], num * width,
+                          Array::UserOwns);
+        modeIndices.push_back(ModeIndex({widthArray, idx}));
+        num *= width;
       } else {
         taco_not_supported_yet;
       }
@@ -100,6 +108,51 @@ bool Kernel::compute(const vector<TensorStorage>& args) const {
   return (result == 0);
 }
 
+static inline
+vector<vector<void*>> packBatch(const vector<vector<TensorStorage>>& batch) {
+  vector<vector<void*>> arguments;
+  arguments.reserve(batch.size());
+  for (auto& args : batch) {
+    arguments.push_back(packArguments(args));
+  }
+  return arguments;
+}
+
+static inline
+int callBatch(ir::Module* module, string name,
+              vector<vector<void*>>& arguments) {
+  vector<void**> argsBatch;
+  argsBatch.reserve(arguments.size());
+  for (auto& args : arguments) {
+    argsBatch.push_back(args.data());
+  }
+  return module->callFuncPackedBatch(name, argsBatch);
+}
+
+bool Kernel::evaluateBatch(const vector<vector<TensorStorage>>& batch) const {
+  vector<vector<void*>> arguments = packBatch(batch);
+  int result = callBatch(content->module.get(), "evaluate", arguments);
+  for (size_t i = 0; i < batch.size(); i++) {
+    unpackResults(this->numResults, arguments[i], batch[i]);
+  }
+  return (result == 0);
+}
+
+bool Kernel::assembleBatch(const vector<vector<TensorStorage>>& batch) const {
+  vector<vector<void*>> arguments = packBatch(batch);
+  int result = callBatch(content->module.get(), "assemble", arguments);
+  for (size_t i = 0; i < batch.size(); i++) {
+    unpackResults(this->numResults, arguments[i], batch[i]);
+  }
+  return (result == 0);
+}
+
+bool Kernel::computeBatch(const vector<vector<TensorStorage>>& batch) const {
+  vector<vector<void*>> arguments = packBatch(batch);
+  int result = callBatch(content->module.get(), "compute", arguments);
+  return (result == 0);
+}
+
 bool Kernel::defined() {
   return content != nullptr;
 }
@@ -899,6 +899,56 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
           }
         }
 
+        // Precondition 4: Privatized outputs must be dense, indexed by loops 
+        //                 nested in the loop, and reduced by addition in loops
+        //                 parallelized over CPU threads
+        if (parallelize.getOutputRaceStrategy() == OutputRaceStrategy::Privatize) {
+          if (parallelize.getParallelUnit() != ParallelUnit::CPUThread &&
+              parallelize.getParallelUnit() != ParallelUnit::CPUThreadBalanced) {
+            reason = "Precondition failed: Only loops parallelized over CPU "
+                     "threads can privatize outputs";
+            return;
+          }
+          set<IndexVar> nestedVars;
+          match(foralli.getStmt(),
+            function<void(const ForallNode*)>([&](const ForallNode* node) {
+              for (const auto& var : 
+                   provGraph.getUnderivedAncestors(node->indexVar)) {
+                nestedVars.insert(var);
+              }
+            })
+          );
+          match(foralli.getStmt(),
+            function<void(const AssignmentNode*)>([&](const AssignmentNode* node) {
+              Assignment assignment(node);
+              if (util::contains(assignment.getLhs().getIndexVars(), 
+                                 underivedAncestor)) {
+                return;
+              }
+              const Format format = 
+                  assignment.getLhs().getTensorVar().getFormat();
+              bool isDense = format.getOrder() > 0;
+              for (const auto& modeFormat : format.getModeFormats()) {
+                isDense &= (modeFormat.getName() == Dense.getName());
+              }
+              bool isNested = true;
+              for (const auto& var : assignment.getLhs().getIndexVars()) {
+                isNested &= util::contains(nestedVars, var);
+              }
+              if (!isDense || !isNested || 
+                  !assignment.getOperator().defined() ||
+                  !isa<taco::Add>(assignment.getOperator())) {
+                reason = "Precondition failed: Privatized outputs must be "
+                         "dense, indexed by loops nested in the parallelized "
+                         "loop, and reduced by addition";
+              }
+            })
+          );
+          if (!reason.empty()) {
+            return;
+          }
+        }
+
         if (parallelize.getOutputRaceStrategy() == OutputRaceStrategy::Temporary &&
             util::contains(reductionIndexVars, underivedForall.getIndexVar())) {
           // Need to precompute reduction
@@ -598,10 +598,10 @@ void IRPrinter::visit(const GetProperty* op) {
 
 void IRPrinter::visit(const Sort* op) {
   doIndent();
-  stream << "qsort(";
+  stream << "taco_sortIndices_" << op->args[0].type() << "(";
   parentPrecedence = Precedence::CALL;
   acceptJoin(this, stream, op->args, ", ");
-  stream << ", cmp);";
+  stream << ");";
   stream << endl;
 }
 
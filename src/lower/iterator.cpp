@@ -87,9 +87,13 @@ Iterator::Iterator(IndexVar indexVar, Expr tensor, Mode mode, Iterator parent,
   if (useNameForPos) {
     posNamePrefix = name;
   }
-  content->posVar   = Var::make(name,            indexVar.getDataType());
-  content->endVar   = Var::make("p" + modeName + "_end",   indexVar.getDataType());
-  content->beginVar = Var::make("p" + modeName + "_begin", indexVar.getDataType());
+  Datatype posType = indexVar.getDataType();
+  if (mode.getPositionType().getNumBits() > posType.getNumBits()) {
+    posType = mode.getPositionType();
+  }
+  content->posVar   = Var::make(name,            posType);
+  content->endVar   = Var::make("p" + modeName + "_end",   posType);
+  content->beginVar = Var::make("p" + modeName + "_begin", posType);
 
   content->coordVar = Var::make(name, indexVar.getDataType());
   content->segendVar = Var::make(modeName + "_segend", indexVar.getDataType());
@@ -381,6 +385,21 @@ Stmt Iterator::getSeqInsertEdge(const Expr& parentPos,
                                                           queries, getMode());
 }
 
+Stmt Iterator::getParInsertEdge(const Expr& parentPos,
+    const std::vector<Expr>& coords,
+    const std::vector<AttrQueryResult>& queries) const {
+  taco_iassert(defined() && content->mode.defined());
+  return getMode().getModeFormat().impl->getParInsertEdge(parentPos, coords,
+                                                          queries, getMode());
+}
+
+Stmt Iterator::getParFinalizeEdges(const Expr& prevSize,
+    const std::vector<AttrQueryResult>& queries) const {
+  taco_iassert(defined() && content->mode.defined());
+  return getMode().getModeFormat().impl->getParFinalizeEdges(prevSize, queries,
+                                                             getMode());
+}
+
 Stmt Iterator::getInitCoords(const Expr& prevSize, 
     const std::vector<AttrQueryResult>& queries) const {
   taco_iassert(defined() && content->mode.defined());
@@ -582,17 +601,31 @@ void Iterators::createAccessIterators(Access access, Format format, Expr tensorI
 
   int level = 1;
   ModeFormat parentModeType;
+  Datatype positionType = Int32;
   for (ModeFormatPack modeTypePack : format.getModeFormatPacks()) {
     vector<Expr> arrays;
     taco_iassert(modeTypePack.getModeFormats().size() > 0);
 
     int modeNumber = format.getModeOrdering()[level-1];
+    vector<Datatype> arrayTypes;
+    if ((size_t)level <= format.getLevelArrayTypes().size()) {
+      arrayTypes = format.getLevelArrayTypes()[level-1];
+    }
     ModePack modePack(modeTypePack.getModeFormats().size(),
                       modeTypePack.getModeFormats()[0], tensorIR,
-                      modeNumber, level);
+                      modeNumber, level, arrayTypes);
+
+    // Positions below a level with a pos array are bounded by its entries.
+    Expr posArray = modePack.getArray(0);
+    if (isa<GetProperty>(posArray) &&
+        to<GetProperty>(posArray)->property == TensorProperty::Indices &&
+        posArray.type().getNumBits() > positionType.getNumBits()) {
+      positionType = posArray.type();
+    }
 
     int pos = 0;
     for (size_t i = 0; i < modeTypePack.getModeFormats().size(); i++) {
+      ModeFormat modeType = modeTypePack.getModeFormats()[i];
       int modeNumber = format.getModeOrdering()[level-1];
       Dimension dim = shape.getDimension(modeNumber);
       IndexVar indexVar = access.getIndexVars()[modeNumber];
@@ -605,7 +638,7 @@ void Iterators::createAccessIterators(Access access, Format format, Expr tensorI
         iteratorIndexVar = indexVar;
       }
       Mode mode(tensorIR, dim, level, modeType, modePack, pos,
-                parentModeType);
+                parentModeType, positionType);
 
       string name = iteratorIndexVar.getName() + tensorConcrete.getName();
       Iterator iterator(iteratorIndexVar, tensorIR, mode, parent, name, true);
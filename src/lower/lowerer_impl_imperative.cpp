@@ -1,4 +1,7 @@
 #include <taco/lower/mode_format_compressed.h>
+#include "taco/lower/mode_format_bitmap.h"
+#include "taco/lower/mode_format_dense.h"
+#include "taco/lower/mode_format_ell.h"
 #include "taco/lower/lowerer_impl_imperative.h"
 #include "taco/lower/lowerer_impl.h"
 
@@ -10,6 +13,7 @@
 #include "taco/index_notation/provenance_graph.h"
 #include "taco/ir/ir.h"
 #include "taco/ir/ir_generators.h"
+#include "taco/ir/ir_rewriter.h"
 #include "taco/ir/ir_visitor.h"
 #include "taco/ir/simplify.h"
 #include "taco/lower/iterator.h"
@@ -74,6 +78,115 @@ LowererImplImperative::LowererImplImperative() : visitor(new Visitor(this)) {
 }
 
 
+/// Call the search helper `name` (e.g. taco_gallop) of the generated code over
+/// the index array in `args[0]`.  The plain helpers search int arrays between
+/// int positions; other index and position types use the typed variants.
+static Expr callIndexSearch(string name, vector<Expr> args, Datatype type) {
+  bool typed = (args[0].type() != Int32);
+  for (size_t i = 1; i < args.size(); i++) {
+    typed |= (args[i].type().getNumBits() > 32);
+  }
+  if (typed) {
+    name += "_" + util::toString(args[0].type());
+  }
+  return ir::Call::make(name, args, type);
+}
+
+/// True if iterators merged with `strategy` are advanced by galloping to the
+/// resolved coordinate rather than one position at a time.
+static bool isGallop(MergeStrategy strategy) {
+  return strategy == MergeStrategy::Gallop ||
+         strategy == MergeStrategy::SimdGallop;
+}
+
+/// The search helper of the generated code that gallops with `strategy`.
+/// Iterators that gallop regardless of the merge strategy (e.g. over index
+/// sets) use taco_gallop unless `strategy` is SimdGallop.
+static string getGallopSearch(MergeStrategy strategy) {
+  return (strategy == MergeStrategy::SimdGallop) ? "taco_simdGallop"
+                                                 : "taco_gallop";
+}
+
+/// True if `stmt` contains a loop that is parallelized over CPU threads.
+static bool hasCPUThreadLoop(IndexStmt stmt) {
+  bool parallel = false;
+  match(stmt,
+    function<void(const ForallNode*)>([&](const ForallNode* node) {
+      parallel |= (node->parallel_unit == ParallelUnit::CPUThread ||
+                   node->parallel_unit == ParallelUnit::CPUThreadBalanced);
+    })
+  );
+  return parallel;
+}
+
+/// True if `stmt` reads the variable `var`.
+static bool usesVar(Stmt stmt, Expr var) {
+  struct FindVar : IRVisitor {
+    const Var* var;
+    bool found = false;
+    using IRVisitor::visit;
+    void visit(const Var* op) {
+      found |= (op == var);
+    }
+  };
+  FindVar finder;
+  finder.var = var.as<Var>();
+  if (stmt.defined()) {
+    stmt.accept(&finder);
+  }
+  return finder.found;
+}
+
+/// The already set guards of dense workspaces pack the flags of 64 consecutive
+/// coordinates into every uint64 word.
+static const int bitGuardWordBits = 64;
+
+/// The number of guard words that hold the flags of `size` coordinates.
+static Expr getBitGuardWords(Expr size) {
+  return ir::Div::make(ir::Add::make(size, bitGuardWordBits - 1),
+                       bitGuardWordBits);
+}
+
+/// The guard word that holds the flag of `coord`.
+static Expr getBitGuardWord(Expr coord) {
+  return ir::Div::make(coord, bitGuardWordBits);
+}
+
+/// The bit of the flag of `coord` within its guard word.
+static Expr getBitGuardBit(Expr coord) {
+  return ir::Call::make("TACO_BIT", {coord}, UInt64);
+}
+
+/// The stride between the positions that a level iterator iterates over, which
+/// position iterators that are not consecutive (e.g. ell) return with their
+/// bounds.
+static Expr getPosStride(const Iterator& iterator) {
+  if (!iterator.hasPosIter()) {
+    return 1;
+  }
+  ModeFunction bounds = iterator.posBounds(iterator.getParent().getPosVar());
+  return (bounds.numResults() > 2) ? bounds[2] : Expr(1);
+}
+
+/// True if the iterators of a merge point can be intersected by comparing
+/// blocks of the coordinates of both at once, i.e. they are two sorted unique
+/// levels with coordinate arrays of the same type that are not windowed.
+static bool isBlockIntersection(const vector<Iterator>& iterators,
+                                const vector<Iterator>& mergers) {
+  if (iterators.size() != 2 || mergers.size() != 2) {
+    return false;
+  }
+  for (auto& iterator : iterators) {
+    if (!iterator.hasPosIter() || iterator.isFull() || !iterator.isOrdered() ||
+        !iterator.isUnique() || iterator.isWindowed() ||
+        iterator.hasIndexSet() || !isValue(getPosStride(iterator), 1)) {
+      return false;
+    }
+  }
+  return iterators[0].getMode().getModePack().getArray(1).type() ==
+         iterators[1].getMode().getModePack().getArray(1).type();
+}
+
 static void createCapacityVars(const map<TensorVar, Expr>& tensorVars,
                                map<Expr, Expr>* capacityVars) {
   for (auto& tensorVar : tensorVars) {
@@ -93,6 +206,23 @@ static void createReducedValueVars(const vector<Access>& inputAccesses,
   }
 }
 
+/// True if `mode` of the tensor is stored in a dense level whose width is a
+/// compile-time constant.
+static bool isSmallDenseMode(const TensorVar& tensor, int mode) {
+  const Format& format = tensor.getFormat();
+  const Dimension& dimension = tensor.getType().getShape().getDimension(mode);
+  if (format.getOrder() != tensor.getOrder() || !dimension.isFixed() ||
+      dimension.getSize() >= DenseModeFormat::MAX_CONSTANT_WIDTH) {
+    return false;
+  }
+  for (int level = 0; level < format.getOrder(); level++) {
+    if (format.getModeOrdering()[level] == mode) {
+      return format.getModeFormats()[level].getName() == Dense.getName();
+    }
+  }
+  return false;
+}
+
 static void getDependentTensors(IndexStmt stmt, std::set<TensorVar>& tensors) {
   std::set<TensorVar> prev;
   do {
@@ -238,6 +368,8 @@ LowererImplImperative::lower(IndexStmt stmt, string name,
   this->compute = compute;
   definedIndexVarsOrdered = {};
   definedIndexVars = {};
+  numWorkspaceBuffers = 0;
+  numPrivateBuffers = 0;
   loopOrderAllowsShortCircuit = allForFreeLoopsBeforeAllReductionLoops(stmt);
 
   // Create result and parameter variables
@@ -342,6 +474,11 @@ LowererImplImperative::lower(IndexStmt stmt, string name,
         // If the mode has an index set, then the dimension is the size of
         // the index set.
         return ir::Literal::make(a.getIndexSet(mode).size());
+      } else if (isSmallDenseMode(tv, mode)) {
+        // Loops over small dense levels, such as the tiles of blocked
+        // formats, get constant trip counts so that they can be unrolled.
+        return ir::Literal::make(
+            (int)tv.getType().getShape().getDimension(mode).getSize());
       } else {
         return GetProperty::make(tensorVars.at(tv), TensorProperty::Dimension, mode);
       }
@@ -437,6 +574,14 @@ LowererImplImperative::lower(IndexStmt stmt, string name,
     }
   }
 
+  // Fetch the status of the call if helpers of the kernel can fail
+  Stmt kernel = Block::make(initializeResults, body, finalizeResults);
+  if (usesVar(kernel, getKernelStatus())) {
+    header.push_back(VarDecl::make(getKernelStatus(),
+                                   ir::Call::make("taco_callStatus", {},
+                                                  Int32)));
+  }
+
   // Create function
   return Function::make(name, resultsIR, argumentsIR,
                         Block::blanks(Block::make(header),
@@ -581,7 +726,10 @@ Stmt LowererImplImperative::lowerAssignment(Assignment assignment)
     Expr indexList = tempToIndexList.at(result);
     Expr indexListSize = tempToIndexListSize.at(result);
 
-    Stmt markBitGuardAsTrue = Store::make(bitGuardArr, loc, true);
+    Expr guardWord = getBitGuardWord(loc);
+    Expr guardBit = getBitGuardBit(loc);
+    Stmt markBitGuardAsTrue = Store::make(bitGuardArr, guardWord,
+        ir::BitOr::make(Load::make(bitGuardArr, guardWord), guardBit));
     Stmt trackIndex = Store::make(indexList, indexListSize, loc);
     Expr incrementSize = ir::Add::make(indexListSize, 1);
     Stmt incrementStmt = Assign::make(indexListSize, incrementSize);
@@ -597,8 +745,10 @@ Stmt LowererImplImperative::lowerAssignment(Assignment assignment)
       firstWriteAtIndex = Block::make(initialStorage, firstWriteAtIndex);
     }
 
-    Expr readBitGuard = Load::make(bitGuardArr, loc);
-    computeStmt = IfThenElse::make(ir::Neg::make(readBitGuard),
+    Expr readBitGuard = ir::BitAnd::make(Load::make(bitGuardArr, guardWord),
+                                         guardBit);
+    computeStmt = IfThenElse::make(ir::Eq::make(readBitGuard,
+                                                ir::Literal::make(0, UInt64)),
                                    firstWriteAtIndex, computeStmt);
   }
 
@@ -788,8 +938,10 @@ Stmt LowererImplImperative::lowerForall(Forall forall)
   if (temp != temporaryInitialization.end() && forall.getParallelUnit() ==
       ParallelUnit::NotParallel && !isScalar(temp->second.getTemporary().getType()))
     temporaryValuesInitFree = codeToInitializeTemporary(temp->second);
-  else if (temp != temporaryInitialization.end() && forall.getParallelUnit() ==
-           ParallelUnit::CPUThread && !isScalar(temp->second.getTemporary().getType())) {
+  else if (temp != temporaryInitialization.end() &&
+           (forall.getParallelUnit() == ParallelUnit::CPUThread ||
+            forall.getParallelUnit() == ParallelUnit::CPUThreadBalanced) &&
+           !isScalar(temp->second.getTemporary().getType())) {
     temporaryValuesInitFree = codeToInitializeTemporaryParallel(temp->second, forall.getParallelUnit());
   }
 
@@ -843,6 +995,43 @@ Stmt LowererImplImperative::lowerForall(Forall forall)
       canAccelWithSparseIteration &= indexListsExist;
     }
 
+    // A dimension loop that locates into bitmaps and only accumulates can skip
+    // the coordinates where the accumulated expression is zero, which are
+    // found word by word from the bitmaps.
+    Expr bitmapWord;
+    Expr bitmapMask;
+    if (iterator.isDimensionIterator() && appenders.empty() &&
+        forall.getParallelUnit() == ParallelUnit::NotParallel &&
+        provGraph.isUnderived(forall.getIndexVar()) &&
+        !provGraph.hasCoordBounds(forall.getIndexVar()) &&
+        isa<Assignment>(forall.getStmt()) &&
+        isa<taco::Add>(to<Assignment>(forall.getStmt()).getOperator())) {
+      bitmapWord = Var::make(forall.getIndexVar().getName() + "_word", Int32);
+      bitmapMask = lowerBitmapWordMask(to<Assignment>(forall.getStmt()).getRhs(),
+                                       forall.getIndexVar(), locators,
+                                       bitmapWord);
+    }
+
+    // A dimension loop over the rows of an ell level whose rows only
+    // accumulate can be lowered slice by slice.
+    Iterator ellIterator;
+    IndexStmt ellRows;
+    IndexStmt ellInitRows;
+    if (iterator.isDimensionIterator() && appenders.empty() &&
+        generateComputeCode() &&
+        (forall.getParallelUnit() == ParallelUnit::NotParallel ||
+         (forall.getParallelUnit() == ParallelUnit::CPUThread &&
+          (forall.getOutputRaceStrategy() == OutputRaceStrategy::NoRaces ||
+           forall.getOutputRaceStrategy() == OutputRaceStrategy::IgnoreRaces))) &&
+        provGraph.isUnderived(forall.getIndexVar()) &&
+        !provGraph.hasCoordBounds(forall.getIndexVar())) {
+      ellRows = getAccumulatedRows(forall, &ellIterator, &ellInitRows);
+      if (ellRows.defined() &&
+          ellIterator.getMode().getModeFormat().getName() != "ell") {
+        ellRows = IndexStmt();
+      }
+    }
+
     if (!isWhereProducer && hasPosDescendant && underivedAncestors.size() > 1 && provGraph.isPosVariable(iterator.getIndexVar()) && posDescendant == forall.getIndexVar()) {
       loops = lowerForallFusedPosition(forall, iterator, locators, inserters, appenders, caseLattice,
                                        reducedAccesses, recoveryStmt);
@@ -850,6 +1039,19 @@ Stmt LowererImplImperative::lowerForall(Forall forall)
     else if (canAccelWithSparseIteration) {
       loops = lowerForallDenseAcceleration(forall, locators, inserters, appenders, caseLattice, reducedAccesses, recoveryStmt);
     }
+    // Emit loop over the set bits of bitmap words
+    else if (bitmapMask.defined()) {
+      loops = lowerForallBitmap(forall, point.locators(), inserters, appenders,
+                                caseLattice, reducedAccesses, recoveryStmt,
+                                bitmapWord, bitmapMask);
+    }
+    // Emit loop over the slices of the rows of an ell level
+    else if (ellRows.defined()) {
+      loops = lowerForallEllSlices(forall, point.locators(), inserters,
+                                   appenders, caseLattice, reducedAccesses,
+                                   recoveryStmt, ellRows, ellInitRows,
+                                   ellIterator);
+    }
     // Emit dimension coordinate iteration loop
     else if (iterator.isDimensionIterator()) {
       loops = lowerForallDimension(forall, point.locators(), inserters, appenders, caseLattice,
@@ -881,6 +1083,10 @@ Stmt LowererImplImperative::lowerForall(Forall forall)
     // omitted.
     loops = Stmt();
   }
+  if (forall.getOutputRaceStrategy() == OutputRaceStrategy::Privatize &&
+      generateComputeCode()) {
+    loops = privatizeResults(forall, resultAccesses, loops);
+  }
   definedIndexVars.erase(forall.getIndexVar());
   definedIndexVarsOrdered.pop_back();
   if (forall.getParallelUnit() != ParallelUnit::NotParallel) {
@@ -1173,8 +1379,8 @@ Stmt LowererImplImperative::searchForFusedPositionStart(Forall forall, Iterator
     };
     Expr posVarUnknown = this->iterators.modeIterator(underivedAncestors[i]).getPosVar();
     searchForUnderivedStart.push_back(ir::VarDecl::make(posVarUnknown,
-                                                        ir::Call::make("taco_binarySearchBefore", binarySearchArgs,
-                                                                       getCoordinateVar(underivedAncestors[i]).type())));
+                                                        callIndexSearch("taco_binarySearchBefore", binarySearchArgs,
+                                                                      getCoordinateVar(underivedAncestors[i]).type())));
     Stmt locateCoordVar;
     if (posIteratorLevel.getParent().hasPosIter()) {
       locateCoordVar = ir::VarDecl::make(indexVarToExprMap[underivedAncestors[i]], ir::Load::make(posIteratorLevel.getParent().getMode().getModePack().getArray(1), posVarUnknown));
@@ -1197,6 +1403,16 @@ Stmt LowererImplImperative::lowerForallDimension(Forall forall,
 {
   Expr coordinate = getCoordinateVar(forall.getIndexVar());
 
+  Expr balancePosArray;
+  IndexStmt balancedRows;
+  if (forall.getParallelUnit() == ParallelUnit::CPUThreadBalanced &&
+      !ignoreVectorize && provGraph.isUnderived(forall.getIndexVar())) {
+    balancePosArray = getBalancePosArray(forall, Iterator(), coordinate);
+    if (balancePosArray.defined()) {
+      balancedRows = getBalancedRows(forall, coordinate, balancePosArray);
+    }
+  }
+
   if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
     markAssignsAtomicDepth++;
     atomicParallelUnit = forall.getParallelUnit();
@@ -1205,6 +1421,14 @@ Stmt LowererImplImperative::lowerForallDimension(Forall forall,
   Stmt body = lowerForallBody(coordinate, forall.getStmt(), locators, inserters,
                               appenders, caseLattice, reducedAccesses, forall.getMergeStrategy());
 
+  Stmt carriedRow;
+  if (balancedRows.defined()) {
+    carriedRow = lowerForallBody(coordinate, balancedRows, locators, inserters,
+                                 appenders, caseLattice, reducedAccesses,
+                                 forall.getMergeStrategy());
+    carriedRow = Block::make(recoveryStmt, carriedRow);
+  }
+
   if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
     markAssignsAtomicDepth--;
   }
@@ -1225,12 +1449,216 @@ Stmt LowererImplImperative::lowerForallDimension(Forall forall,
     kind = LoopKind::Runtime;
   }
 
+  if (balancePosArray.defined()) {
+    return Block::blanks(lowerBalancedLoop(coordinate, bounds[0], bounds[1],
+                                           balancePosArray, body, carriedRow),
+                         posAppend);
+  }
+
   return Block::blanks(For::make(coordinate, bounds[0], bounds[1], 1, body,
                                  kind,
                                  ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit(), ignoreVectorize ? 0 : forall.getUnrollFactor()),
                        posAppend);
 }
 
+Stmt LowererImplImperative::lowerForallBitmap(Forall forall,
+                                              vector<Iterator> locators,
+                                              vector<Iterator> inserters,
+                                              vector<Iterator> appenders,
+                                              MergeLattice caseLattice,
+                                              set<Access> reducedAccesses,
+                                              ir::Stmt recoveryStmt,
+                                              Expr word, Expr wordMask)
+{
+  Expr coordinate = getCoordinateVar(forall.getIndexVar());
+
+  Stmt body = lowerForallBody(coordinate, forall.getStmt(), locators, inserters,
+                              appenders, caseLattice, reducedAccesses, forall.getMergeStrategy());
+  body = Block::make({recoveryStmt, body});
+
+  // Visit the set bits of each word from lowest to highest, clearing each
+  // one before the body so that the coordinates stay ordered.
+  Expr mask = Var::make(forall.getIndexVar().getName() + "_mask", UInt64);
+  Expr bit = ir::Call::make("taco_ctz64", {mask}, Int());
+  Stmt wordLoop = Block::make({
+      VarDecl::make(mask, wordMask),
+      While::make(ir::Neq::make(mask, ir::Literal::make(0, UInt64)), Block::make({
+          VarDecl::make(coordinate,
+                        ir::Add::make(ir::Mul::make(word, BitmapModeFormat::WORD_BITS), bit)),
+          Assign::make(mask, ir::BitAnd::make(mask, ir::Sub::make(mask, ir::Literal::make(1, UInt64)))),
+          body}))});
+
+  std::vector<ir::Expr> bounds = provGraph.deriveIterBounds(forall.getIndexVar(), definedIndexVarsOrdered, underivedBounds, indexVarToExprMap, iterators);
+  Expr numWords = ir::Div::make(ir::Add::make(bounds[1], BitmapModeFormat::WORD_BITS - 1),
+                                BitmapModeFormat::WORD_BITS);
+  return For::make(word, 0, numWords, 1, wordLoop);
+}
+
+Expr LowererImplImperative::lowerBitmapWordMask(IndexExpr expr,
+                                                IndexVar indexVar,
+                                                const vector<Iterator>& locators,
+                                                Expr word) {
+  if (isa<Access>(expr)) {
+    for (Iterator& iterator : getIterators(to<Access>(expr))) {
+      const Literal& fill = to<Access>(expr).getTensorVar().getFill();
+      if (iterator.getIndexVar() == indexVar && util::contains(locators, iterator) &&
+          iterator.getMode().getModeFormat().getName() == Bitmap.getName() &&
+          !iterator.isWindowed() && !iterator.hasIndexSet() &&
+          (!fill.defined() || equals(fill, Literal::zero(fill.getDataType())))) {
+        // The second array of a bitmap level holds its bits
+        Expr bits = iterator.getMode().getModePack().getArray(1);
+        Expr base = ir::Mul::make(iterator.getParent().getPosVar(),
+                                  iterator.getWidth());
+        return Load::make(bits, ir::Add::make(base, word));
+      }
+    }
+    return Expr();
+  }
+  if (isa<Neg>(expr)) {
+    return lowerBitmapWordMask(to<Neg>(expr).getA(), indexVar, locators, word);
+  }
+  if (isa<taco::Mul>(expr)) {
+    Expr a = lowerBitmapWordMask(to<taco::Mul>(expr).getA(), indexVar, locators, word);
+    Expr b = lowerBitmapWordMask(to<taco::Mul>(expr).getB(), indexVar, locators, word);
+    return !a.defined() ? b : (!b.defined() ? a : ir::BitAnd::make(a, b));
+  }
+  if (isa<taco::Add>(expr) || isa<taco::Sub>(expr)) {
+    IndexExpr aExpr = isa<taco::Add>(expr) ? to<taco::Add>(expr).getA() : to<taco::Sub>(expr).getA();
+    IndexExpr bExpr = isa<taco::Add>(expr) ? to<taco::Add>(expr).getB() : to<taco::Sub>(expr).getB();
+    Expr a = lowerBitmapWordMask(aExpr, indexVar, locators, word);
+    Expr b = lowerBitmapWordMask(bExpr, indexVar, locators, word);
+    return (a.defined() && b.defined()) ? ir::BitOr::make(a, b) : Expr();
+  }
+  return Expr();
+}
+
+Stmt LowererImplImperative::lowerForallEllSlices(Forall forall,
+                                                 vector<Iterator> locators,
+                                                 vector<Iterator> inserters,
+                                                 vector<Iterator> appenders,
+                                                 MergeLattice caseLattice,
+                                                 set<Access> reducedAccesses,
+                                                 ir::Stmt recoveryStmt,
+                                                 IndexStmt rows,
+                                                 IndexStmt initRows,
+                                                 Iterator ellIterator)
+{
+  Expr coordinate = getCoordinateVar(forall.getIndexVar());
+  const string name = forall.getIndexVar().getName();
+  Expr sliceHeight =
+      EllModeFormat::getSliceHeight(ellIterator.getMode().getModeFormat());
+  Expr slice = Var::make(name + "_slice", Int32);
+  Expr lane = Var::make(name + "_lane", Int32);
+  Expr lanes = Var::make(name + "_lanes", Int32);
+  Expr width = Var::make(name + "_width", Int32);
+  Expr offset = Var::make(name + "_offset", Int32);
+
+  // The slice is as wide as its longest row, whose results are initialized
+  // while its length is read
+  ModeFunction rowBounds =
+      ellIterator.posBounds(ellIterator.getParent().getPosVar());
+  Stmt measureRow = Block::make(
+      declLocatePosVars(inserters, true), declLocatePosVars(locators),
+      rowBounds.compute(),
+      Assign::make(width, ir::Max::make(width, ir::Sub::make(rowBounds[1],
+                                                             rowBounds[0]))),
+      initRows.defined() ? lower(initRows) : Stmt());
+
+  ellSliceOffset = offset;
+  Stmt body = lowerForallBody(coordinate, rows, locators, inserters, appenders,
+                              caseLattice, reducedAccesses,
+                              forall.getMergeStrategy());
+  ellSliceOffset = Expr();
+  body = Block::make(recoveryStmt, body);
+
+  auto laneLoop = [&](Stmt laneBody) {
+    return For::make(lane, 0, lanes, 1,
+                     Block::make(VarDecl::make(coordinate,
+                                               ir::Add::make(slice, lane)),
+                                 laneBody));
+  };
+
+  std::vector<ir::Expr> bounds = provGraph.deriveIterBounds(forall.getIndexVar(), definedIndexVarsOrdered, underivedBounds, indexVarToExprMap, iterators);
+  Stmt sliceBody = Block::make(
+      VarDecl::make(lanes, ir::Min::make(sliceHeight,
+                                         ir::Sub::make(bounds[1], slice))),
+      VarDecl::make(width, 0),
+      laneLoop(measureRow),
+      For::make(offset, 0, width, sliceHeight, laneLoop(body)));
+
+  LoopKind kind = LoopKind::Serial;
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel && !ignoreVectorize) {
+    kind = LoopKind::Runtime;
+  }
+  return For::make(slice, bounds[0], bounds[1], sliceHeight, sliceBody, kind,
+                   ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit());
+}
+
+IndexStmt LowererImplImperative::getAccumulatedRows(Forall forall,
+                                                    Iterator* rowIterator,
+                                                    IndexStmt* initRows) {
+  IndexStmt stmt = forall.getStmt();
+  Where where;
+  Assignment consumer;
+  if (isa<Where>(stmt)) {
+    where = to<Where>(stmt);
+    if (!isa<Assignment>(where.getConsumer()) ||
+        where.getTemporary().getOrder() != 0) {
+      return IndexStmt();
+    }
+    consumer = to<Assignment>(where.getConsumer());
+    if (!isa<Access>(consumer.getRhs()) ||
+        to<Access>(consumer.getRhs()).getTensorVar() != where.getTemporary()) {
+      return IndexStmt();
+    }
+    stmt = where.getProducer();
+  }
+  if (!isa<Forall>(stmt) || !isa<Assignment>(to<Forall>(stmt).getStmt())) {
+    return IndexStmt();
+  }
+  Forall rows = to<Forall>(stmt);
+  Assignment accumulate = to<Assignment>(rows.getStmt());
+  if (rows.getParallelUnit() != ParallelUnit::NotParallel ||
+      !provGraph.isUnderived(rows.getIndexVar()) ||
+      provGraph.hasCoordBounds(rows.getIndexVar()) ||
+      !isa<taco::Add>(accumulate.getOperator()) ||
+      util::contains(accumulate.getLhs().getIndexVars(), rows.getIndexVar())) {
+    return IndexStmt();
+  }
+  IndexStmt init;
+  if (consumer.defined()) {
+    if (accumulate.getLhs().getTensorVar() != where.getTemporary()) {
+      return IndexStmt();
+    }
+    if (!consumer.getOperator().defined()) {
+      init = Assignment(consumer.getLhs(),
+                        Literal::zero(consumer.getLhs().getDataType()));
+    }
+    accumulate = Assignment(consumer.getLhs(), accumulate.getRhs(),
+                            consumer.getOperator().defined() ?
+                                consumer.getOperator() : accumulate.getOperator());
+    rows = Forall(rows.getIndexVar(), accumulate, rows.getMergeStrategy(),
+                  rows.getParallelUnit(), rows.getOutputRaceStrategy(),
+                  rows.getUnrollFactor());
+  }
+
+  set<IndexVar> rowIndexVars = definedIndexVars;
+  rowIndexVars.insert(rows.getIndexVar());
+  MergeLattice lattice = MergeLattice::make(rows, iterators, provGraph,
+                                            rowIndexVars, whereTempsToResult);
+  if (lattice.iterators().size() != 1 || lattice.points().size() != 1) {
+    return IndexStmt();
+  }
+  Iterator iterator = lattice.iterators()[0];
+  if (!iterator.hasPosIter() || iterator.isWindowed() ||
+      iterator.getParent().getIndexVar() != forall.getIndexVar()) {
+    return IndexStmt();
+  }
+  *rowIterator = iterator;
+  *initRows = init;
+  return rows;
+}
+
   Stmt LowererImplImperative::lowerForallDenseAcceleration(Forall forall,
                                                  vector<Iterator> locators,
                                                  vector<Iterator> inserters,
@@ -1265,7 +1693,9 @@ Stmt LowererImplImperative::lowerForallDimension(Forall forall,
 
     Stmt declareVar = VarDecl::make(coordinate, Load::make(indexList, loopVar));
     Stmt body = lowerForallBody(coordinate, forall.getStmt(), locators, inserters, appenders, caseLattice, reducedAccesses, forall.getMergeStrategy());
-    Stmt resetGuard = ir::Store::make(bitGuard, coordinate, ir::Literal::make(false), markAssignsAtomicDepth > 0, atomicParallelUnit);
+    // Clear the whole guard word of every coordinate in the index list, which
+    // resets exactly the words that the producer touched
+    Stmt resetGuard = ir::Store::make(bitGuard, getBitGuardWord(coordinate), ir::Literal::make(0, UInt64), markAssignsAtomicDepth > 0, atomicParallelUnit);
 
     if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
       markAssignsAtomicDepth--;
@@ -1313,9 +1743,16 @@ Stmt LowererImplImperative::lowerForallPosition(Forall forall, Iterator iterator
   Stmt declareCoordinate = Stmt();
   Stmt strideGuard = Stmt();
   Stmt boundsGuard = Stmt();
+  Stmt emptyGuard = Stmt();
   if (provGraph.isCoordVariable(forall.getIndexVar())) {
-    Expr coordinateArray = iterator.posAccess(iterator.getPosVar(),
-                                              coordinates(iterator)).getResults()[0];
+    ModeFunction posAccess = iterator.posAccess(iterator.getPosVar(),
+                                                coordinates(iterator));
+    Expr coordinateArray = posAccess.getResults()[0];
+    // Levels whose positions may be empty (e.g. hashed) skip those positions.
+    if (!isValue(posAccess.getResults()[1], true)) {
+      emptyGuard = IfThenElse::make(ir::Neg::make(posAccess.getResults()[1]),
+                                    Continue::make());
+    }
     // If the iterator is windowed, we must recover the coordinate index
     // variable from the windowed space.
     if (iterator.isWindowed()) {
@@ -1336,12 +1773,38 @@ Stmt LowererImplImperative::lowerForallPosition(Forall forall, Iterator iterator
     }
     declareCoordinate = VarDecl::make(coordinate, coordinateArray);
   }
+
+  const bool branchless = iterator.isBranchless() && iterator.isCompact() &&
+      (iterator.getParent().isRoot() || iterator.getParent().isUnique());
+  Expr balancePosArray;
+  IndexStmt balancedRows;
+  if (!branchless && !ellSliceOffset.defined() &&
+      forall.getParallelUnit() == ParallelUnit::CPUThreadBalanced &&
+      !ignoreVectorize && provGraph.isUnderived(forall.getIndexVar()) &&
+      isValue(getPosStride(iterator), 1)) {
+    balancePosArray = getBalancePosArray(forall, iterator, iterator.getPosVar());
+    if (balancePosArray.defined() && !emptyGuard.defined() &&
+        !strideGuard.defined() && !boundsGuard.defined()) {
+      balancedRows = getBalancedRows(forall, iterator.getPosVar(),
+                                     balancePosArray);
+    }
+  }
+
   if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
     markAssignsAtomicDepth++;
   }
 
   Stmt body = lowerForallBody(coordinate, forall.getStmt(), locators, inserters, appenders, caseLattice, reducedAccesses, forall.getMergeStrategy());
 
+  Stmt carriedRow;
+  if (balancedRows.defined()) {
+    carriedRow = lowerForallBody(coordinate, balancedRows, locators, inserters,
+                                 appenders, caseLattice, reducedAccesses,
+                                 forall.getMergeStrategy());
+    carriedRow = Block::make(declareCoordinate,
+                             Block::make(recoveryStmt, carriedRow));
+  }
+
   if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
     markAssignsAtomicDepth--;
   }
@@ -1391,9 +1854,24 @@ Stmt LowererImplImperative::lowerForallPosition(Forall forall, Iterator iterator
     endBound = endBounds[1];
   }
 
-  Stmt loop = Block::make(strideGuard, declareCoordinate, boundsGuard, body);
-  if (iterator.isBranchless() && iterator.isCompact() && 
-      (iterator.getParent().isRoot() || iterator.getParent().isUnique())) {
+  // The positions of a thread of a balanced loop may end or start in the
+  // middle of a row (see lowerBalancedLoop)
+  if (balancedIterator.defined() && iterator == balancedIterator) {
+    startBound = ir::Max::make(startBound, balancedPosBegin);
+    endBound = ir::Min::make(endBound, balancedPosEnd);
+  }
+
+  Stmt loop = Block::make(emptyGuard, strideGuard, declareCoordinate,
+                          boundsGuard, body);
+  if (ellSliceOffset.defined() &&
+      iterator.getMode().getModeFormat().getName() == "ell") {
+    // The lanes of an ell slice each access one position of their row (see
+    // lowerForallEllSlices)
+    Expr posVar = iterator.getPosVar();
+    loop = Block::make(VarDecl::make(posVar,
+                                     ir::Add::make(startBound, ellSliceOffset)),
+                       IfThenElse::make(ir::Lt::make(posVar, endBound), loop));
+  } else if (branchless) {
     loop = Block::make(VarDecl::make(iterator.getPosVar(), startBound), loop);
   } else {
     LoopKind kind = LoopKind::Serial;
@@ -1406,15 +1884,385 @@ Stmt LowererImplImperative::lowerForallPosition(Forall forall, Iterator iterator
       kind = LoopKind::Runtime;
     }
 
-    loop = For::make(iterator.getPosVar(), startBound, endBound, 1, loop, kind,
-                     ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit(), 
-		     ignoreVectorize ? 0 : forall.getUnrollFactor());
+    if (balancePosArray.defined()) {
+      loop = lowerBalancedLoop(iterator.getPosVar(), startBound, endBound,
+                               balancePosArray, loop, carriedRow);
+    } else {
+      loop = For::make(iterator.getPosVar(), startBound, endBound,
+                       getPosStride(iterator), loop, kind,
+                       ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit(), 
+		       ignoreVectorize ? 0 : forall.getUnrollFactor());
+    }
   }
 
   // Loop with preamble and postamble
   return Block::blanks(boundsCompute, loop, posAppend);
 }
 
+Expr LowererImplImperative::getBalancePosArray(Forall forall,
+                                               Iterator loopIterator,
+                                               Expr loopVar) {
+  // The pos arrays of results may not be assembled yet
+  set<Expr> results;
+  for (const Access& access : getResultAccesses(forall).first) {
+    results.insert(tensorVars.at(access.getTensorVar()));
+  }
+
+  for (auto& levelIterator : iterators.levelIterators()) {
+    const Iterator& iterator = levelIterator.second;
+    Iterator parent = iterator.getParent();
+    if (!parent.defined() || parent.isRoot() ||
+        util::contains(results, iterator.getTensor()) ||
+        !iterator.hasPosIter() || !iterator.isCompact() ||
+        iterator.isWindowed() || parent.isWindowed() || parent.hasIndexSet()) {
+      continue;
+    }
+    // The positions of a dense top level are the coordinates of its dimension
+    bool isBelowLoop = loopIterator.defined()
+        ? parent == loopIterator
+        : (parent.getIndexVar() == forall.getIndexVar() && parent.isFull() &&
+           parent.hasLocate() && parent.getParent().isRoot());
+    if (!isBelowLoop) {
+      continue;
+    }
+    ModeFunction bounds = iterator.posBounds(loopVar);
+    if (!bounds.compute().defined() && isa<ir::Load>(bounds[0]) &&
+        to<ir::Load>(bounds[0])->loc == loopVar) {
+      return to<ir::Load>(bounds[0])->arr;
+    }
+  }
+  return Expr();
+}
+
+IndexStmt LowererImplImperative::getBalancedRows(Forall forall, Expr loopVar,
+                                                 Expr posArray) {
+  if (!generateComputeCode()) {
+    return IndexStmt();
+  }
+  Iterator rowIterator;
+  IndexStmt initRows;
+  IndexStmt rows = getAccumulatedRows(forall, &rowIterator, &initRows);
+  if (!rows.defined() ||
+      !util::contains(to<Assignment>(to<Forall>(rows).getStmt()).getLhs()
+                          .getIndexVars(), forall.getIndexVar())) {
+    return IndexStmt();
+  }
+  ModeFunction bounds = rowIterator.posBounds(loopVar);
+  if (bounds.compute().defined() || !isa<ir::Load>(bounds[0]) ||
+      to<ir::Load>(bounds[0])->arr != posArray) {
+    return IndexStmt();
+  }
+  string name = util::toString(loopVar);
+  balancedIterator = rowIterator;
+  balancedPosBegin = Var::make(name + "_thread_pos", posArray.type());
+  balancedPosEnd = Var::make(name + "_thread_pos_end", posArray.type());
+  return rows;
+}
+
+namespace {
+/// Rewrites the stores into the values of a result such that they accumulate
+/// into `carry` instead, and record their location in `carryLoc`.
+struct CarryValues : public IRRewriter {
+  Expr carry;
+  Expr carryLoc;
+  Expr values;
+  bool carried = true;
+
+  using IRRewriter::visit;
+
+  static bool isValues(Expr array, Expr values) {
+    if (array == values) {
+      return true;
+    }
+    return isa<GetProperty>(array) && isa<GetProperty>(values) &&
+           to<GetProperty>(array)->property == TensorProperty::Values &&
+           to<GetProperty>(values)->property == TensorProperty::Values &&
+           to<GetProperty>(array)->tensor == to<GetProperty>(values)->tensor;
+  }
+
+  void visit(const Store* op) {
+    if (!values.defined()) {
+      values = op->arr;
+      carry = Var::make(util::toString(carryLoc) + "_value", op->data.type());
+    }
+    carried &= isValues(op->arr, values);
+    stmt = Block::make(Assign::make(carryLoc, rewrite(op->loc)),
+                       Assign::make(carry, rewrite(op->data)));
+  }
+
+  void visit(const Load* op) {
+    if (values.defined() && isValues(op->arr, values)) {
+      expr = carry;
+    } else {
+      IRRewriter::visit(op);
+    }
+  }
+};
+}
+
+Stmt LowererImplImperative::lowerBalancedLoop(Expr loopVar, Expr begin,
+                                              Expr end, Expr posArray,
+                                              Stmt body, Stmt carriedRow) {
+  // Thread t gets the positions from the (t * nnz / T)-th position below the
+  // loop, where nnz is the number of positions below the loop and T the number
+  // of threads, to where thread t+1 starts. It iterates over the iterations
+  // whose positions start in its positions.
+  string name = util::toString(loopVar);
+  Expr numThreads = Var::make(name + "_threads", Int32);
+  Expr posBegin = Var::make(name + "_pos_begin", posArray.type());
+  Expr numPositions = Var::make(name + "_nnz", Int64);
+  Expr thread = Var::make(name + "_thread", Int32);
+  Expr threadBegin = Var::make(name + "_begin", loopVar.type());
+  Expr threadEnd = Var::make(name + "_end", loopVar.type());
+  Expr threadPosBegin = balancedPosBegin.defined()
+      ? balancedPosBegin : Var::make(name + "_thread_pos", posArray.type());
+  Expr threadPosEnd = balancedPosEnd.defined()
+      ? balancedPosEnd : Var::make(name + "_thread_pos_end", posArray.type());
+  balancedIterator = Iterator();
+  balancedPosBegin = Expr();
+  balancedPosEnd = Expr();
+
+  auto threadPos = [&](Expr t) {
+    return ir::Cast::make(
+        ir::Add::make(ir::Cast::make(posBegin, Int64),
+                      ir::Div::make(ir::Mul::make(numPositions, t),
+                                    numThreads)),
+        posArray.type());
+  };
+  auto searchIteration = [&](Expr target) {
+    return ir::Cast::make(callIndexSearch("taco_binarySearchAfter",
+                                          {posArray, begin, end, target},
+                                          loopVar.type()),
+                          loopVar.type());
+  };
+  Expr nextThread = ir::Add::make(thread, 1);
+  Stmt threadBounds = Block::make(
+      VarDecl::make(threadPosBegin, threadPos(thread)),
+      VarDecl::make(threadPosEnd, threadPos(nextThread)),
+      VarDecl::make(threadBegin, begin),
+      IfThenElse::make(Gt::make(thread, 0),
+                       Assign::make(threadBegin, searchIteration(threadPosBegin))),
+      VarDecl::make(threadEnd, end),
+      IfThenElse::make(Lt::make(nextThread, numThreads),
+                       Assign::make(threadEnd, searchIteration(threadPosEnd))));
+  Stmt loop = For::make(loopVar, threadBegin, threadEnd, 1, body);
+
+  // The row that the previous thread stopped in is computed into a carry,
+  // which is added to the row's results after the threads are done
+  CarryValues carrier;
+  carrier.carryLoc = Var::make(name + "_carry", Int64);
+  if (carriedRow.defined()) {
+    carriedRow = carrier.rewrite(carriedRow);
+  }
+  Stmt carryStmts;
+  Stmt addCarries;
+  vector<Stmt> carryBuffers;
+  if (carriedRow.defined() && carrier.values.defined() && carrier.carried) {
+    Datatype type = carrier.carry.type();
+    Expr carries = Var::make(name + "_carries", type, true, false);
+    Expr carryLocs = Var::make(name + "_carry_locs", Int64, true, false);
+    carryBuffers.push_back(VarDecl::make(carries,
+                                         getArenaBuffer(numThreads, type)));
+    carryBuffers.push_back(VarDecl::make(carryLocs,
+                                         getArenaBuffer(numThreads, Int64)));
+    carryStmts = Block::make(
+        VarDecl::make(carrier.carry, ir::Literal::zero(type)),
+        VarDecl::make(carrier.carryLoc, ir::Literal::make((int64_t)-1, Int64)),
+        IfThenElse::make(Gt::make(threadBegin, begin), Block::make(
+            VarDecl::make(loopVar, ir::Sub::make(threadBegin, 1)),
+            carriedRow)),
+        Store::make(carries, thread, carrier.carry),
+        Store::make(carryLocs, thread, carrier.carryLoc));
+
+    Expr carryLoc = Load::make(carryLocs, thread);
+    addCarries = For::make(thread, 0, numThreads, 1,
+        IfThenElse::make(Gte::make(carryLoc, ir::Literal::make((int64_t)0, Int64)),
+            Store::make(carrier.values, carryLoc,
+                        ir::Add::make(Load::make(carrier.values, carryLoc),
+                                      Load::make(carries, thread)))));
+  } else if (carriedRow.defined()) {
+    // The thread's last row cannot be cut short
+    threadBounds = Block::make(threadBounds,
+                               Assign::make(threadPosEnd, Load::make(posArray, threadEnd)));
+  }
+
+  Stmt threadLoop = For::make(thread, 0, numThreads, 1,
+                              Block::make(threadBounds, loop, carryStmts),
+                              LoopKind::Static, ParallelUnit::CPUThread);
+  Expr posEnd = Load::make(posArray, end);
+  return Block::make({
+      VarDecl::make(numThreads,
+                    ir::Call::make("omp_get_max_threads", {}, Int32)),
+      VarDecl::make(posBegin, Load::make(posArray, begin)),
+      VarDecl::make(numPositions,
+                    ir::Cast::make(ir::Sub::make(posEnd, posBegin), Int64)),
+      Block::make(carryBuffers),
+      threadLoop,
+      addCarries});
+}
+
+/// The first buffers of the workspace arena of the generated code hold
+/// workspaces, and the next ones (up to TACO_SORT_ARENA_BUFFER, the scratch of
+/// taco_sortIndices) hold the private copies of privatized results. The
+/// functions of a module share the arena, so the private copies, which every
+/// function leaves zeroed, must not share buffers with workspaces.
+static const int maxWorkspaceBuffers = 48;
+static const int maxPrivateBuffers = 16;
+
+Expr LowererImplImperative::getArenaBuffer(Expr size, Datatype type,
+                                           bool zeroed) {
+  taco_uassert(numWorkspaceBuffers < maxWorkspaceBuffers)
+      << "Cannot keep more than " << maxWorkspaceBuffers 
+      << " workspaces across calls of a kernel";
+  Expr bytes = ir::Mul::make(ir::Cast::make(size, Int64), Sizeof::make(type));
+  return ir::Call::make(zeroed ? "taco_arenaZeroedBuffer" : "taco_arenaBuffer",
+                        {ir::Literal::make(numWorkspaceBuffers++), bytes}, 
+                        type);
+}
+
+namespace {
+/// Rewrites the first loop that is parallelized over CPU threads such that it
+/// starts with `decls` and every access of the values of the tensors in
+/// `privateValues` in the loop accesses their private values instead.
+struct PrivatizeValues : public IRRewriter {
+  map<Expr,Expr> privateValues;
+  Stmt decls;
+  bool inLoop = false;
+  bool privatized = false;
+
+  using IRRewriter::visit;
+
+  void visit(const For* op) {
+    if (privatized || op->parallel_unit != ParallelUnit::CPUThread) {
+      IRRewriter::visit(op);
+      return;
+    }
+    inLoop = true;
+    Stmt contents = rewrite(op->contents);
+    inLoop = false;
+    privatized = true;
+    stmt = For::make(op->var, op->start, op->end, op->increment,
+                     Block::make(decls, contents), op->kind, op->parallel_unit,
+                     op->unrollFactor, op->vec_width);
+  }
+
+  void visit(const GetProperty* op) {
+    if (inLoop && op->property == TensorProperty::Values &&
+        util::contains(privateValues, op->tensor)) {
+      expr = privateValues.at(op->tensor);
+    } else {
+      expr = op;
+    }
+  }
+};
+}
+
+Stmt LowererImplImperative::privatizeResults(Forall forall,
+                                             vector<Access> resultAccesses,
+                                             Stmt loops) {
+  const IndexVar underivedAncestor =
+      provGraph.getUnderivedAncestors(forall.getIndexVar()).back();
+  Expr numThreads = Var::make(forall.getIndexVar().getName() + "_threads", 
+                              Int32);
+  Expr thread = ir::Call::make("omp_get_thread_num", {}, Int64);
+
+  PrivatizeValues privatizer;
+  vector<Stmt> acquireStmts, threadDecls, reduceStmts;
+  set<TensorVar> privatized;
+  for (const auto& access : resultAccesses) {
+    const TensorVar result = access.getTensorVar();
+    if (result.getOrder() == 0 ||
+        util::contains(access.getIndexVars(), underivedAncestor) ||
+        util::contains(temporaryArrays, result) ||
+        util::contains(privatized, result)) {
+      continue;
+    }
+    taco_uassert(numPrivateBuffers < maxPrivateBuffers)
+        << "Cannot privatize more than " << maxPrivateBuffers 
+        << " results in a kernel";
+    privatized.insert(result);
+
+    const Expr tensor = getTensorVar(result);
+    const Datatype type = result.getType().getDataType();
+    const string name = result.getName();
+    Expr size = Var::make(name + "_private_size", Int64);
+    Expr privateAll = Var::make(name + "_private_all", type, true, false);
+    Expr privateValues = Var::make(name + "_private", type, true, false);
+    Expr values = getValuesArray(result);
+
+    // The private copies of all threads are in a zeroed buffer that is kept
+    // across calls
+    Expr sizeExpr = ir::Literal::make((int64_t)1, Int64);
+    for (int mode = 0; mode < result.getOrder(); mode++) {
+      Expr dimension = GetProperty::make(tensor, TensorProperty::Dimension, 
+                                         mode);
+      sizeExpr = ir::Mul::make(sizeExpr, ir::Cast::make(dimension, Int64));
+    }
+    acquireStmts.push_back(VarDecl::make(size, sizeExpr));
+    Expr bytes = ir::Mul::make(ir::Mul::make(size, 
+                                             ir::Cast::make(numThreads, Int64)),
+                               Sizeof::make(type));
+    Expr buffer = ir::Literal::make(maxWorkspaceBuffers + numPrivateBuffers++);
+    acquireStmts.push_back(VarDecl::make(privateAll,
+        ir::Call::make("taco_arenaBuffer", {buffer, bytes}, type)));
+
+    privatizer.privateValues.insert({tensor, privateValues});
+    threadDecls.push_back(VarDecl::make(privateValues, 
+        ir::Add::make(privateAll, ir::Mul::make(size, thread))));
+
+    // Add copy t + stride into copy t for every t that is a multiple of 
+    // 2 * stride in each round of the tree reduction, and then add copy 0 into
+    // the values
+    Expr stride = Var::make(name + "_stride", Int32);
+    Expr q = Var::make(name + "_q", Int64);
+    Expr lo = Var::make(name + "_lo", Int64);
+    Expr hi = Var::make(name + "_hi", Int64);
+    Expr pairStride = ir::Mul::make(2, stride);
+    Expr numPairs = ir::Div::make(ir::Sub::make(ir::Add::make(numThreads, 
+                                                              stride), 1),
+                                  pairStride);
+    Expr pairBase = ir::Mul::make(ir::Mul::make(ir::Div::make(q, size), 
+                                                ir::Cast::make(pairStride, 
+                                                               Int64)),
+                                  size);
+    Stmt combine = Block::make(
+        VarDecl::make(lo, ir::Add::make(pairBase, ir::Rem::make(q, size))),
+        VarDecl::make(hi, ir::Add::make(lo, ir::Mul::make(size, stride))),
+        Store::make(privateAll, lo, ir::Add::make(Load::make(privateAll, lo),
+                                                  Load::make(privateAll, hi))),
+        Store::make(privateAll, hi, ir::Literal::zero(type)));
+    Stmt round = Block::make(
+        For::make(q, 0, ir::Mul::make(size, ir::Cast::make(numPairs, Int64)),
+                  1, combine, LoopKind::Static_Chunked, 
+                  ParallelUnit::CPUThread),
+        Assign::make(stride, pairStride));
+    reduceStmts.push_back(VarDecl::make(stride, 1));
+    reduceStmts.push_back(While::make(Lt::make(stride, numThreads), round));
+
+    Expr p = Var::make(name + "_p", Int64);
+    Stmt add = Block::make(
+        Store::make(values, p, ir::Add::make(Load::make(values, p),
+                                             Load::make(privateAll, p))),
+        Store::make(privateAll, p, ir::Literal::zero(type)));
+    reduceStmts.push_back(For::make(p, 0, size, 1, add, 
+                                    LoopKind::Static_Chunked, 
+                                    ParallelUnit::CPUThread));
+  }
+  if (privatized.empty()) {
+    return loops;
+  }
+
+  privatizer.decls = Block::make(threadDecls);
+  loops = privatizer.rewrite(loops);
+  taco_iassert(privatizer.privatized);
+  return Block::blanks(
+      Block::make(VarDecl::make(numThreads, ir::Call::make(
+                      "omp_get_max_threads", {}, Int32)), 
+                  Block::make(acquireStmts)),
+      loops,
+      Block::make(reduceStmts));
+}
+
 Stmt LowererImplImperative::lowerForallFusedPosition(Forall forall, Iterator iterator,
                                       vector<Iterator> locators,
                                       vector<Iterator> inserters,
@@ -1638,6 +2486,33 @@ Stmt LowererImplImperative::lowerMergePoint(MergeLattice pointLattice,
   taco_iassert(mergers.size() > 0);
   taco_iassert(rangers.size() > 0);
 
+  // Intersections merged with SimdGallop first skip to the next coordinate
+  // the iterators have in common, comparing blocks of both at once:
+  //   ia = taco_simdIntersect_T(a_crd, ia, pa_end, b_crd, ib, pb_end);
+  //   if (ia >= pa_end) break;
+  //   ib = taco_simdGallop(b_crd, ib, pb_end, a_crd[ia]);
+  Stmt intersectStmts;
+  if (mergeStrategy == MergeStrategy::SimdGallop &&
+      pointLattice.points().size() == 1 &&
+      isBlockIntersection(iterators, mergers)) {
+    Expr aCrd = iterators[0].getMode().getModePack().getArray(1);
+    Expr bCrd = iterators[1].getMode().getModePack().getArray(1);
+    Expr aVar = iterators[0].getIteratorVar();
+    Expr bVar = iterators[1].getIteratorVar();
+    Expr aEnd = iterators[0].getEndVar();
+    Expr bEnd = iterators[1].getEndVar();
+    string intersect = "taco_simdIntersect_" + util::toString(aCrd.type());
+    intersectStmts = ir::Block::make(
+      ir::Assign::make(aVar, ir::Call::make(intersect, {aCrd, aVar, aEnd,
+                                                        bCrd, bVar, bEnd},
+                                            aVar.type())),
+      ir::IfThenElse::make(ir::Gte::make(aVar, aEnd), ir::Break::make()),
+      ir::Assign::make(bVar, callIndexSearch("taco_simdGallop",
+                                             {bCrd, bVar, bEnd,
+                                              ir::Load::make(aCrd, aVar)},
+                                             bVar.type())));
+  }
+
   // Load coordinates from position iterators
   Stmt loadPosIterCoordinates = codeToLoadCoordinatesFromPosIterators(iterators, !resolvedCoordDeclared);
 
@@ -1692,9 +2567,10 @@ Stmt LowererImplImperative::lowerMergePoint(MergeLattice pointLattice,
       indexVar, indexIterBounds[1],
       setMatch
     };
+    string search = getGallopSearch(mergeStrategy);
     auto incr = ir::Block::make(
-      ir::Assign::make(ivar, ir::Call::make("taco_gallop", iterGallopArgs, ivar.type())),
-      ir::Assign::make(indexVar, ir::Call::make("taco_gallop", indexGallopArgs, indexVar.type())),
+      ir::Assign::make(ivar, callIndexSearch(search, iterGallopArgs, ivar.type())),
+      ir::Assign::make(indexVar, callIndexSearch(search, indexGallopArgs, indexVar.type())),
       ir::Continue::make()
     );
     // Code that uses the defined parts together in the if-then-else.
@@ -1702,12 +2578,7 @@ Stmt LowererImplImperative::lowerMergePoint(MergeLattice pointLattice,
   }
 
   // Merge iterator coordinate variables
-  bool mergeWithMax;
-  if (mergeStrategy == MergeStrategy::Gallop) {
-    mergeWithMax = true;
-  } else {
-    mergeWithMax = false;
-  }
+  bool mergeWithMax = isGallop(mergeStrategy);
   Stmt resolvedCoordinate = resolveCoordinate(mergers, coordinate, !resolvedCoordDeclared, mergeWithMax);
 
   // Locate positions
@@ -1729,7 +2600,8 @@ Stmt LowererImplImperative::lowerMergePoint(MergeLattice pointLattice,
 
   /// While loop over rangers
   return While::make(checkThatNoneAreExhausted(rangers),
-                     Block::make(loadPosIterCoordinates,
+                     Block::make(intersectStmts,
+                                 loadPosIterCoordinates,
                                  ir::Block::make(indexSetStmts),
                                  resolvedCoordinate,
                                  loadLocatorPosVars,
@@ -2076,7 +2948,7 @@ Stmt LowererImplImperative::lowerForallBody(Expr coordinate, IndexStmt stmt,
                                   MergeStrategy mergeStrategy) {
 
   // Inserter positions
-  Stmt declInserterPosVars = declLocatePosVars(inserters);
+  Stmt declInserterPosVars = declLocatePosVars(inserters, true);
 
   // Locate positions
   Stmt declLocatorPosVars = declLocatePosVars(locators);
@@ -2125,10 +2997,10 @@ Stmt LowererImplImperative::lowerForallBody(Expr coordinate, IndexStmt stmt,
   std::vector<Stmt> stmts;
   
   // Code to increment iterators when merging by galloping.
-  if (mergeStrategy == MergeStrategy::Gallop && caseLattice.iterators().size() > 1) {
+  if (isGallop(mergeStrategy) && caseLattice.iterators().size() > 1) {
     for (auto it : caseLattice.iterators()) {
       Expr ivar = it.getIteratorVar();
-      stmts.push_back(compoundAssign(ivar, 1));
+      stmts.push_back(compoundAssign(ivar, getPosStride(it)));
     }
   }
 
@@ -2200,8 +3072,8 @@ vector<Stmt> LowererImplImperative::codeToInitializeDenseAcceleratorArrays(Where
 
   TensorVar temporary = where.getTemporary();
 
-  // TODO: emit as uint64 and manually emit bit pack code
-  const Datatype bitGuardType = taco::Bool;
+  // The guard packs the already set flags of 64 coordinates into every word
+  const Datatype bitGuardType = taco::UInt64;
   std::string bitGuardSuffix;
   if (parallel)
     bitGuardSuffix = "_already_set_all";
@@ -2209,10 +3081,13 @@ vector<Stmt> LowererImplImperative::codeToInitializeDenseAcceleratorArrays(Where
     bitGuardSuffix = "_already_set";
   const std::string bitGuardName = temporary.getName() + bitGuardSuffix;
 
-  Expr bitGuardSize = getTemporarySize(where);
-  Expr maxThreads = ir::Call::make("omp_get_max_threads", {}, bitGuardSize.type());
-  if (parallel)
+  Expr indexListSize = getTemporarySize(where);
+  Expr bitGuardSize = getBitGuardWords(indexListSize);
+  Expr maxThreads = ir::Call::make("omp_get_max_threads", {}, indexListSize.type());
+  if (parallel) {
+    indexListSize = ir::Mul::make(indexListSize, maxThreads);
     bitGuardSize = ir::Mul::make(bitGuardSize, maxThreads);
+  }
 
   const Expr alreadySetArr = ir::Var::make(bitGuardName,
                                            bitGuardType,
@@ -2232,10 +3107,16 @@ vector<Stmt> LowererImplImperative::codeToInitializeDenseAcceleratorArrays(Where
                                           indexListType,
                                           true, false);
 
+  // Workspaces that are initialized outside of parallel loops are kept in the
+  // workspace arena across calls
+  const bool useArena = !should_use_CUDA_codegen() &&
+                        inParallelLoopDepth == (parallel ? 1 : 0);
+
   // no decl for shared memory
   Stmt alreadySetDecl = Stmt();
   Stmt indexListDecl = Stmt();
-  Stmt freeTemps = Block::make(Free::make(indexListArr), Free::make(alreadySetArr));
+  Stmt freeTemps = useArena ? Stmt() : Block::make(Free::make(indexListArr),
+                                                   Free::make(alreadySetArr));
   if ((isa<Forall>(where.getProducer()) && inParallelLoopDepth == 0) || !should_use_CUDA_codegen()) {
     alreadySetDecl = VarDecl::make(alreadySetArr, ir::Literal::make(0));
     indexListDecl = VarDecl::make(indexListArr, ir::Literal::make(0));
@@ -2251,7 +3132,9 @@ vector<Stmt> LowererImplImperative::codeToInitializeDenseAcceleratorArrays(Where
     tempToBitGuard[temporary] = alreadySetArr;
   }
 
-  Stmt allocateIndexList = Allocate::make(indexListArr, bitGuardSize);
+  Stmt allocateIndexList = useArena
+      ? Assign::make(indexListArr, getArenaBuffer(indexListSize, indexListType))
+      : Allocate::make(indexListArr, indexListSize);
   if(should_use_CUDA_codegen()) {
     Stmt allocateAlreadySet = Allocate::make(alreadySetArr, bitGuardSize);
     Expr p = Var::make("p" + temporary.getName(), Int());
@@ -2262,7 +3145,9 @@ vector<Stmt> LowererImplImperative::codeToInitializeDenseAcceleratorArrays(Where
     return {inits, freeTemps};
   } else {
     Expr sizeOfElt = Sizeof::make(bitGuardType);
-    Expr callocAlreadySet = ir::Call::make("calloc", {bitGuardSize, sizeOfElt}, Int());
+    Expr callocAlreadySet = useArena 
+        ? getArenaBuffer(bitGuardSize, bitGuardType, true)
+        : ir::Call::make("calloc", {bitGuardSize, sizeOfElt}, Int());
     Stmt allocateAlreadySet = VarDecl::make(alreadySetArr, callocAlreadySet);
     Stmt inits = Block::make(indexListDecl, allocateIndexList, allocateAlreadySet);
     return {inits, freeTemps};
@@ -2386,14 +3271,15 @@ vector<Stmt> LowererImplImperative::codeToInitializeLocalTemporaryParallel(Where
     const Expr indexListSizeExpr = ir::Var::make(indexListName + "_size", taco::Int32, false, false);
 
     // Declare local already set array (bit guard)
-    // TODO: emit as uint64 and manually emit bit pack code
-    const Datatype bitGuardType = taco::Bool;
+    const Datatype bitGuardType = taco::UInt64;
     const std::string bitGuardName = temporary.getName() + "_already_set";
     const Expr alreadySetArr = ir::Var::make(bitGuardName,
                                              bitGuardType,
                                              true, false);
     Expr bitGuard_all = this->whereToBitGuardAll[where];
-    Expr bitGuardRhs = ir::Add::make(bitGuard_all, tempSize);
+    Expr bitGuardOffset = ir::Mul::make(getBitGuardWords(getTemporarySize(where)),
+                                        threadNum);
+    Expr bitGuardRhs = ir::Add::make(bitGuard_all, bitGuardOffset);
     Stmt bitGuardDecl = ir::VarDecl::make(alreadySetArr, bitGuardRhs);
     decls.push_back(bitGuardDecl);
 
@@ -2440,10 +3326,15 @@ vector<Stmt> LowererImplImperative::codeToInitializeTemporaryParallel(Where wher
     if ((isa<Forall>(where.getProducer()) && inParallelLoopDepth == 0) || !should_use_CUDA_codegen()) {
       decl = VarDecl::make(values, ir::Literal::make(0));
     }
-    Stmt allocate = Allocate::make(values, sizeAll);
-
-    freeTemporary = Block::make(freeTemporary, Free::make(values));
-    initializeTemporary = Block::make(decl, initializeTemporary, allocate);
+    if (!should_use_CUDA_codegen() && inParallelLoopDepth == 1) {
+      Stmt allocate = Assign::make(values, getArenaBuffer(sizeAll, 
+          temporaryAll.getType().getDataType()));
+      initializeTemporary = Block::make(decl, initializeTemporary, allocate);
+    } else {
+      Stmt allocate = Allocate::make(values, sizeAll);
+      freeTemporary = Block::make(freeTemporary, Free::make(values));
+      initializeTemporary = Block::make(decl, initializeTemporary, allocate);
+    }
   }
   /// Make a struct object that lowerAssignment and lowerAccess can read
   /// temporary value arrays from.
@@ -2493,10 +3384,15 @@ vector<Stmt> LowererImplImperative::codeToInitializeTemporary(Where where) {
       if ((isa<Forall>(where.getProducer()) && inParallelLoopDepth == 0) || !should_use_CUDA_codegen()) {
         decl = VarDecl::make(values, ir::Literal::make(0));
       }
-      Stmt allocate = Allocate::make(values, size);
-
-      freeTemporary = Block::make(freeTemporary, Free::make(values));
-      initializeTemporary = Block::make(decl, initializeTemporary, allocate);
+      if (!should_use_CUDA_codegen() && inParallelLoopDepth == 0) {
+        Stmt allocate = Assign::make(values, getArenaBuffer(size, 
+            temporary.getType().getDataType()));
+        initializeTemporary = Block::make(decl, initializeTemporary, allocate);
+      } else {
+        Stmt allocate = Allocate::make(values, size);
+        freeTemporary = Block::make(freeTemporary, Free::make(values));
+        initializeTemporary = Block::make(decl, initializeTemporary, allocate);
+      }
     }
 
     /// Make a struct object that lowerAssignment and lowerAccess can read
@@ -2521,8 +3417,10 @@ Stmt LowererImplImperative::lowerWhere(Where where) {
     if (it->second == where && it->first.getParallelUnit() ==
         ParallelUnit::NotParallel && !isScalar(temporary.getType())) {
       temporaryHoisted = true;
-    } else if (it->second == where && it->first.getParallelUnit() ==
-               ParallelUnit::CPUThread && !isScalar(temporary.getType())) {
+    } else if (it->second == where &&
+               (it->first.getParallelUnit() == ParallelUnit::CPUThread ||
+                it->first.getParallelUnit() == ParallelUnit::CPUThreadBalanced) &&
+               !isScalar(temporary.getType())) {
       temporaryHoisted = true;
       auto decls = codeToInitializeLocalTemporaryParallel(where, it->first.getParallelUnit());
 
@@ -2550,8 +3448,11 @@ Stmt LowererImplImperative::lowerWhere(Where where) {
     // We need to sort the indices array
     Expr listOfIndices = tempToIndexList.at(temporary);
     Expr listOfIndicesSize = tempToIndexListSize.at(temporary);
-    Expr sizeOfElt = ir::Sizeof::make(listOfIndices.type());
-    Stmt sortCall = ir::Sort::make({listOfIndices, listOfIndicesSize, sizeOfElt});
+    // The sort picks insertion sort, radix sort, or a sweep over the set bits
+    // of the guard at runtime
+    Stmt sortCall = ir::Sort::make({listOfIndices, listOfIndicesSize,
+                                    getTemporarySize(where),
+                                    tempToBitGuard.at(temporary)});
     consumer = Block::make(sortCall, consumer);
   }
 
@@ -2665,6 +3566,13 @@ Stmt LowererImplImperative::lowerAssemble(Assemble assemble) {
       getResultAccesses(assemble.getCompute());
   const auto& queryResults = assemble.getAttrQueryResults();
 
+  // If the result is computed in parallel, then its edges are also inserted in
+  // parallel if the levels support it, which stores the edges of every parent
+  // position independently (e.g., the number of children) and then completes
+  // them (e.g., with a parallel prefix sum).
+  const bool parallelInsertEdges = !should_use_CUDA_codegen() &&
+                                   hasCPUThreadLoop(assemble.getCompute());
+
   std::vector<Stmt> initAssembleStmts;
   for (const auto& resultAccess : resultAccesses) {
     Expr prevSize = 1;
@@ -2688,8 +3596,18 @@ Stmt LowererImplImperative::lowerAssemble(Assemble assemble) {
                                                           queryResults);
           initAssembleStmts.push_back(initEdges);
 
-          Stmt insertEdgeLoop = resultIterator.getSeqInsertEdge(
+          Stmt parInsertEdge = resultIterator.getParInsertEdge(
               resultIterator.getParent().getPosVar(), coords, queryResults);
+          Stmt parFinalizeEdges = resultIterator.getParFinalizeEdges(
+              prevSize, queryResults);
+          const bool parallelInsert = parallelInsertEdges &&
+                                      parInsertEdge.defined() &&
+                                      parFinalizeEdges.defined();
+
+          Stmt insertEdgeLoop = parallelInsert ? parInsertEdge :
+              resultIterator.getSeqInsertEdge(
+                  resultIterator.getParent().getPosVar(), coords, 
+                  queryResults);
           auto locateCoords = coords;
           for (auto iter = resultIterator.getParent(); !iter.isRoot();
                iter = iter.getParent()) {
@@ -2699,14 +3617,22 @@ Stmt LowererImplImperative::lowerAssemble(Assemble assemble) {
                   resultModeOrdering[iter.getMode().getLevel() - 1]);
               Expr pos = iter.getPosVar();
               Stmt initPos = VarDecl::make(pos, iter.locate(locateCoords)[0]);
+              const bool parallel = parallelInsert &&
+                                    iter.getParent().isRoot();
               insertEdgeLoop = For::make(coords.back(), 0, dim, 1,
-                                         Block::make(initPos, insertEdgeLoop));
+                  Block::make(initPos, insertEdgeLoop),
+                  parallel ? LoopKind::Static : LoopKind::Serial,
+                  parallel ? ParallelUnit::CPUThread 
+                           : ParallelUnit::NotParallel);
             } else {
               taco_not_supported_yet;
             }
             locateCoords.pop_back();
           }
           initAssembleStmts.push_back(insertEdgeLoop);
+          if (parallelInsert) {
+            initAssembleStmts.push_back(parFinalizeEdges);
+          }
         }
 
         Stmt initCoords = resultIterator.getInitCoords(prevSize, queryResults);
@@ -3358,7 +4284,8 @@ Stmt LowererImplImperative::initValues(Expr tensor, Expr initVal, Expr begin, Ex
   return For::make(p, lower, upper, 1, zeroInit, parallel);
 }
 
-Stmt LowererImplImperative::declLocatePosVars(vector<Iterator> locators) {
+Stmt LowererImplImperative::declLocatePosVars(vector<Iterator> locators,
+                                                bool insert) {
   vector<Stmt> result;
   for (Iterator& locator : locators) {
     accessibleIterators.insert(locator);
@@ -3374,7 +4301,7 @@ Stmt LowererImplImperative::declLocatePosVars(vector<Iterator> locators) {
 
     if (doLocate) {
       Iterator locateIterator = locator;
-      if (locateIterator.hasPosIter()) {
+      if (locateIterator.hasPosIter() && !locateIterator.hasLocate()) {
         taco_iassert(!provGraph.isUnderived(locateIterator.getIndexVar()));
         continue; // these will be recovered with separate procedure
       }
@@ -3399,6 +4326,15 @@ Stmt LowererImplImperative::declLocatePosVars(vector<Iterator> locators) {
         Stmt declarePosVar = VarDecl::make(locateIterator.getPosVar(),
                                            locate.getResults()[0]);
         result.push_back(declarePosVar);
+        // Levels that store coordinates at located positions (e.g. hashed)
+        // must record the coordinate when a result component is inserted.
+        if (insert && locateIterator.hasInsertCoord()) {
+          Stmt insertCoord = locateIterator.getInsertCoord(
+              locateIterator.getPosVar(), coords);
+          if (insertCoord.defined()) {
+            result.push_back(insertCoord);
+          }
+        }
 
         if (locateIterator.isLeaf()) {
           break;
@@ -3503,7 +4439,7 @@ Stmt LowererImplImperative::codeToInitializeIteratorVar(Iterator iterator, vecto
                   iterator.getBeginVar() // target
           };
           result.push_back(
-                  VarDecl::make(iterVar, ir::Call::make("taco_binarySearchAfter", binarySearchArgs, iterVar.type())));
+                  VarDecl::make(iterVar, callIndexSearch("taco_binarySearchAfter", binarySearchArgs, iterVar.type())));
         }
         else {
           result.push_back(VarDecl::make(iterVar, bounds[0]));
@@ -3614,7 +4550,7 @@ Stmt LowererImplImperative::codeToIncIteratorVars(Expr coordinate, IndexVar coor
     Expr ivar = iterators[0].getIteratorVar();
 
     if (iterators[0].isUnique()) {
-      return compoundAssign(ivar, 1);
+      return compoundAssign(ivar, getPosStride(iterators[0]));
     }
 
     // If iterator is over bottommost coordinate hierarchy level with
@@ -3639,7 +4575,7 @@ Stmt LowererImplImperative::codeToIncIteratorVars(Expr coordinate, IndexVar coor
       if (iterator.isFull()) {
         Expr increment = 1;
         result.push_back(compoundAssign(ivar, increment));
-      } else if (strategy == MergeStrategy::Gallop) {
+      } else if (isGallop(strategy) && isValue(getPosStride(iterator), 1)) {
         Expr iteratorParentPos = iterator.getParent().getPosVar();
         ModeFunction iterBounds = iterator.posBounds(iteratorParentPos);
         result.push_back(iterBounds.compute());
@@ -3648,9 +4584,12 @@ Stmt LowererImplImperative::codeToIncIteratorVars(Expr coordinate, IndexVar coor
           ivar, iterBounds[1],
           coordinate,
         };
-        result.push_back(ir::Assign::make(ivar, ir::Call::make("taco_gallop", gallopArgs, ivar.type())));
-      } else { // strategy == MergeStrategy::TwoFinger
+        result.push_back(ir::Assign::make(ivar, callIndexSearch(getGallopSearch(strategy), gallopArgs, ivar.type())));
+      } else { // strategy == MergeStrategy::TwoFinger, or a strided level
         Expr increment = ir::Cast::make(Eq::make(iterator.getCoordVar(), coordinate), ivar.type());
+        if (!isValue(getPosStride(iterator), 1)) {
+          increment = ir::Mul::make(increment, getPosStride(iterator));
+        }
         result.push_back(compoundAssign(ivar, increment));
       }
     } else if (!iterator.isLeaf()) {
@@ -4028,7 +4967,7 @@ Expr LowererImplImperative::searchForStartOfWindowPosition(Iterator iterator, ir
             // for the beginning of the window.
             iterator.getWindowLowerBound(),
     };
-    return ir::Call::make("taco_binarySearchAfter", args, Datatype::UInt64);
+    return callIndexSearch("taco_binarySearchAfter", args, Datatype::UInt64);
 }
 
 
@@ -4042,7 +4981,7 @@ Expr LowererImplImperative::searchForEndOfWindowPosition(Iterator iterator, ir::
             // for the end of the window.
             iterator.getWindowUpperBound(),
     };
-    return ir::Call::make("taco_binarySearchAfter", args, Datatype::UInt64);
+    return callIndexSearch("taco_binarySearchAfter", args, Datatype::UInt64);
 }
 
 
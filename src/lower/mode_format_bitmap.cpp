@@ -0,0 +1,83 @@
+#include "taco/lower/mode_format_bitmap.h"
+
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+BitmapModeFormat::BitmapModeFormat() : BitmapModeFormat(true) {
+}
+
+BitmapModeFormat::BitmapModeFormat(bool isUnique) :
+    ModeFormatImpl("bitmap", false, true, isUnique, false, false, false,
+                   false, false, false, true, false, false, false, false,
+                   false) {
+}
+
+ModeFormat BitmapModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  bool isUnique = this->isUnique;
+  for (const auto property : properties) {
+    switch (property) {
+      case ModeFormat::UNIQUE:
+        isUnique = true;
+        break;
+      case ModeFormat::NOT_UNIQUE:
+        isUnique = false;
+        break;
+      default:
+        break;
+    }
+  }
+  return ModeFormat(std::make_shared<BitmapModeFormat>(isUnique));
+}
+
+ModeFunction BitmapModeFormat::locate(Expr parentPos,
+                                      std::vector<Expr> coords,
+                                      Mode mode) const {
+  // Coordinates whose bit is not set are located at the reserved position 0,
+  // which holds the fill value, so the coordinate is always found.
+  ModePack pack = mode.getModePack();
+  Expr base = ir::Mul::make(parentPos, getWidth(mode));
+  Expr rankArray = getRankArray(pack);
+  Expr pos = ir::Call::make("taco_bitmapLocate_" +
+                            util::toString(rankArray.type()),
+                            {rankArray, getBitsArray(pack), base,
+                             coords.back()},
+                            mode.getPositionType());
+  return ModeFunction(Stmt(), {pos, true});
+}
+
+Expr BitmapModeFormat::getWidth(Mode mode) const {
+  if (mode.getSize().isFixed()) {
+    return (int)((mode.getSize().getSize() + WORD_BITS - 1) / WORD_BITS);
+  }
+  return ir::Div::make(ir::Add::make(getSizeArray(mode.getModePack()),
+                                     WORD_BITS - 1), WORD_BITS);
+}
+
+vector<Expr> BitmapModeFormat::getArrays(Expr tensor, int mode,
+                                         int level) const {
+  std::string arraysName = util::toString(tensor) + std::to_string(level);
+  return {GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 0, arraysName + "_rank"),
+          GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 1, arraysName + "_bits"),
+          GetProperty::make(tensor, TensorProperty::Dimension, mode)};
+}
+
+Expr BitmapModeFormat::getRankArray(ModePack pack) const {
+  return pack.getArray(0);
+}
+
+Expr BitmapModeFormat::getBitsArray(ModePack pack) const {
+  return pack.getArray(1);
+}
+
+Expr BitmapModeFormat::getSizeArray(ModePack pack) const {
+  return pack.getArray(2);
+}
+
+}
@@ -146,7 +146,7 @@ Stmt CompressedModeFormat::getAppendInitEdges(Expr pPrevBegin,
     return doubleSizeIfFull(posArray, posCapacity, pPrevEnd);
   }
 
-  Expr pVar = Var::make("p" + mode.getName(), Int());
+  Expr pVar = Var::make("p" + mode.getName(), mode.getPositionType());
   Expr lb = ir::Add::make(pPrevBegin, 1);
   Expr ub = ir::Add::make(pPrevEnd, 1);
   Stmt initPos = For::make(pVar, lb, ub, 1, Store::make(posArray, pVar, 0));
@@ -174,7 +174,7 @@ Stmt CompressedModeFormat::getAppendInitLevel(Expr szPrev, Expr sz,
 
   if (mode.getParentModeType().defined() &&
       !mode.getParentModeType().hasAppend() && !szPrevIsZero) {
-    Expr pVar = Var::make("p" + mode.getName(), Int());
+    Expr pVar = Var::make("p" + mode.getName(), mode.getPositionType());
     Stmt storePos = Store::make(posArray, pVar, 0);
     initStmts.push_back(For::make(pVar, 1, initCapacity, 1, storePos));
   }
@@ -197,10 +197,10 @@ Stmt CompressedModeFormat::getAppendFinalizeLevel(Expr szPrev,
     return Stmt();
   }
 
-  Expr csVar = Var::make("cs" + mode.getName(), Int());
+  Expr csVar = Var::make("cs" + mode.getName(), mode.getPositionType());
   Stmt initCs = VarDecl::make(csVar, 0);
   
-  Expr pVar = Var::make("p" + mode.getName(), Int());
+  Expr pVar = Var::make("p" + mode.getName(), mode.getPositionType());
   Expr loadPos = Load::make(getPosArray(mode.getModePack()), pVar);
   Stmt incCs = Assign::make(csVar, ir::Add::make(csVar, loadPos));
   Stmt updatePos = Store::make(getPosArray(mode.getModePack()), pVar, csVar);
@@ -231,6 +231,25 @@ Stmt CompressedModeFormat::getSeqInsertEdge(Expr parentPos,
   return Store::make(posArray, ir::Add::make(parentPos, 1), pos);
 }
 
+Stmt CompressedModeFormat::getParInsertEdge(Expr parentPos,
+    std::vector<Expr> coords, std::vector<AttrQueryResult> queries,
+    Mode mode) const {
+  // Store the number of children of every parent, which a parallel exclusive
+  // prefix sum turns into the pos array in getParFinalizeEdges.
+  Expr posArray = getPosArray(mode.getModePack());
+  Expr nnz = queries[0].getResult(coords, "nnz");
+  return Store::make(posArray, parentPos, nnz);
+}
+
+Stmt CompressedModeFormat::getParFinalizeEdges(Expr prevSize,
+    std::vector<AttrQueryResult> queries, Mode mode) const {
+  Expr posArray = getPosArray(mode.getModePack());
+  Expr prefixSum = ir::Call::make(
+      "taco_prefixSum_" + util::toString(posArray.type()),
+      {posArray, prevSize}, posArray.type());
+  return Store::make(posArray, prevSize, prefixSum);
+}
+
 Stmt CompressedModeFormat::getInitCoords(Expr prevSize, 
     std::vector<AttrQueryResult> queries, Mode mode) const {
   Expr posArray = getPosArray(mode.getModePack());
@@ -246,7 +265,7 @@ ModeFunction CompressedModeFormat::getYieldPos(Expr parentPos,
     std::vector<Expr> coords, Mode mode) const {
   Expr ptrArr = getPosArray(mode.getModePack());
   Expr loadPtr = Load::make(ptrArr, parentPos);
-  Expr pVar = Var::make("p" + mode.getName(), Int());
+  Expr pVar = Var::make("p" + mode.getName(), mode.getPositionType());
   Stmt getPtr = VarDecl::make(pVar, loadPtr);
   Stmt incPtr = Store::make(ptrArr, parentPos, ir::Add::make(loadPtr, 1));
   return ModeFunction(Block::make(getPtr, incPtr), {pVar});
@@ -262,7 +281,7 @@ Stmt CompressedModeFormat::getInsertCoord(Expr parentPos, Expr pos,
 
 Stmt CompressedModeFormat::getFinalizeYieldPos(Expr prevSize, Mode mode) const {
   Expr posArr = getPosArray(mode.getModePack());
-  Expr pVar = Var::make("p", Int());
+  Expr pVar = Var::make("p", mode.getPositionType());
   Stmt resetLoop = For::make(pVar, 0, prevSize, 1, 
       Store::make(posArr, ir::Sub::make(prevSize, pVar), 
                   Load::make(posArr, 
@@ -291,7 +310,7 @@ Expr CompressedModeFormat::getPosCapacity(Mode mode) const {
   const std::string varName = mode.getName() + "_pos_size";
  
   if (!mode.hasVar(varName)) {
-    Expr posCapacity = Var::make(varName, Int());
+    Expr posCapacity = Var::make(varName, mode.getPositionType());
     mode.addVar(varName, posCapacity);
     return posCapacity;
   }
@@ -303,7 +322,7 @@ Expr CompressedModeFormat::getCoordCapacity(Mode mode) const {
   const std::string varName = mode.getName() + "_crd_size";
   
   if (!mode.hasVar(varName)) {
-    Expr idxCapacity = Var::make(varName, Int());
+    Expr idxCapacity = Var::make(varName, mode.getPositionType());
     mode.addVar(varName, idxCapacity);
     return idxCapacity;
   }
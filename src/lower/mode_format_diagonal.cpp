@@ -0,0 +1,74 @@
+#include "taco/lower/mode_format_diagonal.h"
+
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+DiagonalModeFormat::DiagonalModeFormat() :
+    ModeFormatImpl("diagonal", false, true, true, false, false, false, false,
+                   false, true, false, false, false, false, false, false) {
+}
+
+ModeFormat DiagonalModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  return ModeFormat(std::make_shared<DiagonalModeFormat>());
+}
+
+ModeFunction DiagonalModeFormat::posIterBounds(Expr parentPos,
+                                               Mode mode) const {
+  // The parent position is the row, whose columns are the row plus the
+  // offsets. Skip the diagonals that start left of or end above the row.
+  ModePack pack = mode.getModePack();
+  Expr numDiagonals = getWidth(mode);
+  Expr base = ir::Mul::make(parentPos, numDiagonals);
+  Expr first = ir::Call::make("taco_binarySearchAfter",
+                              {getOffsetsArray(pack), 0, numDiagonals,
+                               ir::Neg::make(parentPos)}, Int32);
+  Expr last = ir::Call::make("taco_binarySearchAfter",
+                             {getOffsetsArray(pack), 0, numDiagonals,
+                              ir::Sub::make(getSizeArray(pack), parentPos)},
+                             Int32);
+  return ModeFunction(Stmt(), {ir::Add::make(base, first),
+                               ir::Add::make(base, last)});
+}
+
+ModeFunction DiagonalModeFormat::posIterAccess(Expr pos,
+                                               std::vector<Expr> coords,
+                                               Mode mode) const {
+  taco_iassert(coords.size() >= 2);
+  Expr row = coords[coords.size() - 2];
+  Expr diagonal = ir::Sub::make(pos, ir::Mul::make(row, getWidth(mode)));
+  Expr offset = Load::make(getOffsetsArray(mode.getModePack()), diagonal);
+  return ModeFunction(Stmt(), {ir::Add::make(row, offset), true});
+}
+
+Expr DiagonalModeFormat::getWidth(Mode mode) const {
+  return Load::make(getNumArray(mode.getModePack()), 0);
+}
+
+vector<Expr> DiagonalModeFormat::getArrays(Expr tensor, int mode,
+                                           int level) const {
+  std::string arraysName = util::toString(tensor) + std::to_string(level);
+  return {GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 0, arraysName + "_num"),
+          GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 1, arraysName + "_offsets"),
+          GetProperty::make(tensor, TensorProperty::Dimension, mode)};
+}
+
+Expr DiagonalModeFormat::getNumArray(ModePack pack) const {
+  return pack.getArray(0);
+}
+
+Expr DiagonalModeFormat::getOffsetsArray(ModePack pack) const {
+  return pack.getArray(1);
+}
+
+Expr DiagonalModeFormat::getSizeArray(ModePack pack) const {
+  return pack.getArray(2);
+}
+
+}
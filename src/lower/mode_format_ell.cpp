@@ -0,0 +1,79 @@
+#include "taco/lower/mode_format_ell.h"
+
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+EllModeFormat::EllModeFormat() : EllModeFormat(DEFAULT_SLICE_HEIGHT, 1) {
+}
+
+EllModeFormat::EllModeFormat(int sliceHeight, int sortWindow) :
+    ModeFormatImpl("ell", false, true, true, false, false, false, true, false,
+                   true, false, false, false, false, false, false),
+    sliceHeight(sliceHeight), sortWindow(sortWindow) {
+  taco_uassert(sliceHeight > 0) << "The slice height must be positive";
+  taco_uassert(sortWindow == 1 ||
+               (sortWindow > 0 && sortWindow % sliceHeight == 0))
+      << "The sort window must be 1 or a multiple of the slice height";
+}
+
+ModeFormat EllModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  return ModeFormat(std::make_shared<EllModeFormat>(sliceHeight, sortWindow));
+}
+
+ModeFunction EllModeFormat::posIterBounds(Expr parentPos, Mode mode) const {
+  // The entries of a row are a slice height apart, which the pos array stores
+  // so that tensors can be read with any ell mode format.
+  Expr posArray = getPosArray(mode.getModePack());
+  Expr rowPos = ir::Mul::make(parentPos, 2);
+  Expr pbegin = Load::make(posArray, ir::Add::make(rowPos, 1));
+  Expr pend = Load::make(posArray, ir::Add::make(rowPos, 2));
+  Expr stride = Load::make(posArray, 0);
+  return ModeFunction(Stmt(), {pbegin, pend, stride});
+}
+
+ModeFunction EllModeFormat::posIterAccess(Expr pos,
+                                          std::vector<Expr> coords,
+                                          Mode mode) const {
+  Expr idx = Load::make(getCoordArray(mode.getModePack()), pos);
+  return ModeFunction(Stmt(), {idx, true});
+}
+
+vector<Expr> EllModeFormat::getArrays(Expr tensor, int mode, int level) const {
+  std::string arraysName = util::toString(tensor) + std::to_string(level);
+  return {GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 0, arraysName + "_pos"),
+          GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 1, arraysName + "_crd")};
+}
+
+int EllModeFormat::getSliceHeight(const ModeFormat& modeFormat) {
+  taco_iassert(modeFormat.getName() == "ell");
+  return static_cast<const EllModeFormat&>(*modeFormat.impl).sliceHeight;
+}
+
+int EllModeFormat::getSortWindow(const ModeFormat& modeFormat) {
+  taco_iassert(modeFormat.getName() == "ell");
+  return static_cast<const EllModeFormat&>(*modeFormat.impl).sortWindow;
+}
+
+bool EllModeFormat::equals(const ModeFormatImpl& other) const {
+  auto& otherEll = dynamic_cast<const EllModeFormat&>(other);
+  return ModeFormatImpl::equals(other) &&
+         otherEll.sliceHeight == sliceHeight &&
+         otherEll.sortWindow == sortWindow;
+}
+
+Expr EllModeFormat::getPosArray(ModePack pack) const {
+  return pack.getArray(0);
+}
+
+Expr EllModeFormat::getCoordArray(ModePack pack) const {
+  return pack.getArray(1);
+}
+
+}
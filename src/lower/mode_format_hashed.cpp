@@ -0,0 +1,155 @@
+#include "taco/lower/mode_format_hashed.h"
+
+#include <cstdint>
+
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+HashedModeFormat::HashedModeFormat() : HashedModeFormat(true, false) {
+}
+
+HashedModeFormat::HashedModeFormat(bool isUnique, bool isZeroless,
+                                   long long width) :
+    ModeFormatImpl("hashed", false, false, isUnique, false, false, isZeroless,
+                   false, false, true, true, true, false, false, true, true),
+    width(width) {
+  taco_uassert(width > 0 && (width & (width - 1)) == 0 && width <= (1 << 30))
+      << "The width of a hashed mode must be a power of two no larger than 2^30";
+}
+
+ModeFormat HashedModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  bool isUnique = this->isUnique;
+  bool isZeroless = this->isZeroless;
+  for (const auto property : properties) {
+    switch (property) {
+      case ModeFormat::UNIQUE:
+        isUnique = true;
+        break;
+      case ModeFormat::NOT_UNIQUE:
+        isUnique = false;
+        break;
+      case ModeFormat::ZEROLESS:
+        isZeroless = true;
+        break;
+      case ModeFormat::NOT_ZEROLESS:
+        isZeroless = false;
+        break;
+      default:
+        break;
+    }
+  }
+  return ModeFormat(
+      std::make_shared<HashedModeFormat>(isUnique, isZeroless, width));
+}
+
+ModeFunction HashedModeFormat::posIterBounds(Expr parentPos, Mode mode) const {
+  Expr width = getWidth(mode);
+  Expr pbegin = ir::Mul::make(parentPos, width);
+  Expr pend = ir::Mul::make(ir::Add::make(parentPos, 1), width);
+  return ModeFunction(Stmt(), {pbegin, pend});
+}
+
+ModeFunction HashedModeFormat::posIterAccess(Expr pos,
+                                             std::vector<Expr> coords,
+                                             Mode mode) const {
+  Expr idx = Load::make(getCoordArray(mode.getModePack()), pos);
+  return ModeFunction(Stmt(), {idx, ir::Neq::make(idx, -1)});
+}
+
+ModeFunction HashedModeFormat::locate(Expr parentPos,
+                                      std::vector<Expr> coords,
+                                      Mode mode) const {
+  // Probes for the slot of the coordinate, or the empty slot where it would be
+  // inserted. An empty slot holds the fill value, so the coordinate is always
+  // found. A full table is reported through the status of the kernel call.
+  Expr width = getWidth(mode);
+  Expr crdArray = getCoordArray(mode.getModePack());
+  Expr pos = ir::Call::make("taco_hashLocate_" +
+                            util::toString(crdArray.type()),
+                            {crdArray,
+                             ir::Mul::make(parentPos, width), width,
+                             coords.back(), getKernelStatus()},
+                            mode.getPositionType());
+  return ModeFunction(Stmt(), {pos, true});
+}
+
+Stmt HashedModeFormat::getInsertCoord(Expr p, const std::vector<Expr>& i,
+                                      Mode mode) const {
+  return Store::make(getCoordArray(mode.getModePack()), p, i.back());
+}
+
+Expr HashedModeFormat::getWidth(Mode mode) const {
+  return Load::make(getWidthArray(mode.getModePack()), 0);
+}
+
+Stmt HashedModeFormat::getInsertInitCoords(Expr pBegin, Expr pEnd,
+                                           Mode mode) const {
+  return Stmt();
+}
+
+Stmt HashedModeFormat::getInsertInitLevel(Expr szPrev, Expr sz,
+                                          Mode mode) const {
+  Expr widthArray = getWidthArray(mode.getModePack());
+  Expr crdArray = getCoordArray(mode.getModePack());
+  Expr pVar = Var::make("p" + mode.getName(), mode.getPositionType());
+
+  // A table never holds more coordinates than the dimension of the mode, so
+  // narrow modes get tables with fewer slots
+  long long levelWidth = width;
+  if (mode.getSize().isFixed()) {
+    while (levelWidth > 1 && (size_t)levelWidth / 2 >= mode.getSize().getSize()) {
+      levelWidth /= 2;
+    }
+  }
+  return Block::make({Allocate::make(widthArray, 1),
+                      Store::make(widthArray, 0, (int)levelWidth),
+                      Allocate::make(crdArray, sz),
+                      For::make(pVar, 0, sz, 1, Store::make(crdArray, pVar, -1))});
+}
+
+Stmt HashedModeFormat::getInsertFinalizeLevel(Expr szPrev, Expr sz,
+                                              Mode mode) const {
+  return Stmt();
+}
+
+Expr HashedModeFormat::getAssembledSize(Expr prevSize, Mode mode) const {
+  return ir::Mul::make(prevSize, getWidth(mode));
+}
+
+vector<Expr> HashedModeFormat::getArrays(Expr tensor, int mode,
+                                         int level) const {
+  std::string arraysName = util::toString(tensor) + std::to_string(level);
+  return {GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 0, arraysName + "_width"),
+          GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 1, arraysName + "_crd")};
+}
+
+int HashedModeFormat::hash(int coord, int width) {
+  int shift = 32;
+  for (int w = width; w > 1; w /= 2) {
+    shift--;
+  }
+  const uint64_t hash = (uint32_t)((uint32_t)coord * 2654435761u);
+  return (int)(hash >> shift);
+}
+
+bool HashedModeFormat::equals(const ModeFormatImpl& other) const {
+  return ModeFormatImpl::equals(other) &&
+         (dynamic_cast<const HashedModeFormat&>(other).width == width);
+}
+
+Expr HashedModeFormat::getWidthArray(ModePack pack) const {
+  return pack.getArray(0);
+}
+
+Expr HashedModeFormat::getCoordArray(ModePack pack) const {
+  return pack.getArray(1);
+}
+
+}
@@ -143,6 +143,11 @@ std::ostream& operator<<(std::ostream& os, const ModeFunction& modeFunction) {
             << util::join(modeFunction.getResults());
 }
 
+ir::Expr getKernelStatus() {
+  static const Expr status = Var::make("status", Int32, true);
+  return status;
+}
+
 
 // class ModeTypeImpl
 ModeFormatImpl::ModeFormatImpl(const std::string name, bool isFull, 
@@ -270,6 +275,16 @@ Stmt ModeFormatImpl::getSeqInsertEdge(Expr parentPos, std::vector<Expr> coords,
   return Stmt();
 }
 
+Stmt ModeFormatImpl::getParInsertEdge(Expr parentPos, std::vector<Expr> coords,
+    std::vector<AttrQueryResult> queries, Mode mode) const {
+  return Stmt();
+}
+
+Stmt ModeFormatImpl::getParFinalizeEdges(Expr prevSize,
+    std::vector<AttrQueryResult> queries, Mode mode) const {
+  return Stmt();
+}
+
 Stmt ModeFormatImpl::getInitCoords(Expr prevSize, 
     std::vector<AttrQueryResult> queries, Mode mode) const {
   return Stmt();
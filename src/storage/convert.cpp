@@ -0,0 +1,290 @@
+#include "taco/storage/convert.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#if USE_OPENMP
+#include <omp.h>
+#endif
+
+#include "taco/error.h"
+#include "taco/index_notation/index_notation.h"
+#include "taco/storage/array.h"
+#include "taco/storage/index.h"
+
+using namespace std;
+
+#if USE_OPENMP
+#define TACO_PARALLEL_FOR _Pragma("omp parallel for schedule(static)")
+#else
+#define TACO_PARALLEL_FOR
+#endif
+
+namespace taco {
+
+static bool isLevel(const ModeFormat& modeFormat, const ModeFormat& level) {
+  return modeFormat.getName() == level.getName();
+}
+
+static bool hasInt32Indices(const Format& format) {
+  if (format.getLevelArrayTypes().size() != (size_t)format.getOrder()) {
+    return false;
+  }
+  for (const auto& arrayTypes : format.getLevelArrayTypes()) {
+    for (const Datatype& type : arrayTypes) {
+      if (type != Int32) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool isConvertible(const Format& source, const Format& target) {
+  if (source.getOrder() == 0 || source.getOrder() != target.getOrder() ||
+      (int)source.getModeFormatPacks().size() != source.getOrder() ||
+      (int)target.getModeFormatPacks().size() != target.getOrder() ||
+      !hasInt32Indices(source) || !hasInt32Indices(target)) {
+    return false;
+  }
+  for (const ModeFormat& modeFormat : source.getModeFormats()) {
+    if ((!isLevel(modeFormat, Dense) && !isLevel(modeFormat, Compressed) &&
+         !isLevel(modeFormat, Singleton)) || !modeFormat.isOrdered()) {
+      return false;
+    }
+  }
+  if (!source.getModeFormats().back().isUnique()) {
+    return false;
+  }
+  const vector<ModeFormat> targetModeFormats = target.getModeFormats();
+  for (int level = 0; level < target.getOrder(); level++) {
+    const ModeFormat& modeFormat = targetModeFormats[level];
+    if (isLevel(modeFormat, Singleton)) {
+      const ModeFormat& parent = targetModeFormats[std::max(level - 1, 0)];
+      if (level == 0 || parent.isUnique() || isLevel(parent, Dense)) {
+        return false;
+      }
+    } else if (!isLevel(modeFormat, Dense) &&
+               !isLevel(modeFormat, Compressed)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Number of chunks that the parallel passes over `n` components with `numKeys`
+/// distinct keys are split into, such that the per-chunk histograms stay
+/// smaller than the components.
+static int getNumChunks(size_t n, size_t numKeys) {
+#if USE_OPENMP
+  const size_t minChunkSize = 1 << 16;
+  size_t numChunks = std::min((size_t)omp_get_max_threads(), n / minChunkSize);
+  numChunks = std::min(numChunks, n / std::max(numKeys, (size_t)1));
+#else
+  size_t numChunks = 1;
+#endif
+  return (int)std::max(numChunks, (size_t)1);
+}
+
+/// Stable counting sort of the components in `perm` by their `keys`, which
+/// are below `numKeys`. Each chunk of components is counted into its own
+/// histogram in parallel, and the chunks are then scattered in parallel.
+static void countingSort(const vector<int>& keys, size_t numKeys,
+                         vector<size_t>& perm) {
+  const size_t n = perm.size();
+  const int numChunks = getNumChunks(n, numKeys);
+  const size_t chunkSize = (n + numChunks - 1) / numChunks;
+
+  vector<size_t> offsets(numChunks * numKeys, 0);
+  TACO_PARALLEL_FOR
+  for (int chunk = 0; chunk < numChunks; chunk++) {
+    size_t* histogram = &offsets[chunk * numKeys];
+    const size_t end = std::min(n, (chunk + 1) * chunkSize);
+    for (size_t i = chunk * chunkSize; i < end; i++) {
+      histogram[keys[perm[i]]]++;
+    }
+  }
+  size_t offset = 0;
+  for (size_t key = 0; key < numKeys; key++) {
+    for (int chunk = 0; chunk < numChunks; chunk++) {
+      size_t& chunkOffset = offsets[chunk * numKeys + key];
+      const size_t count = chunkOffset;
+      chunkOffset = offset;
+      offset += count;
+    }
+  }
+
+  vector<size_t> sortedPerm(n);
+  TACO_PARALLEL_FOR
+  for (int chunk = 0; chunk < numChunks; chunk++) {
+    size_t* chunkOffsets = &offsets[chunk * numKeys];
+    const size_t end = std::min(n, (chunk + 1) * chunkSize);
+    for (size_t i = chunk * chunkSize; i < end; i++) {
+      sortedPerm[chunkOffsets[keys[perm[i]]]++] = perm[i];
+    }
+  }
+  perm.swap(sortedPerm);
+}
+
+TensorStorage convert(const TensorStorage& storage, const Format& format) {
+  TensorStorage source = storage;
+  const Format& sourceFormat = source.getFormat();
+  const vector<int>& dimensions = source.getDimensions();
+  const int order = source.getOrder();
+  taco_iassert(isConvertible(sourceFormat, format));
+
+  // The positions of every source level are all of its positions in order, so
+  // walking the index only records the parent of each compressed position
+  const Index& index = source.getIndex();
+  const vector<ModeFormat> sourceModeFormats = sourceFormat.getModeFormats();
+  const vector<ModeFormat> targetModeFormats = format.getModeFormats();
+  vector<vector<int>> parents(order);
+  vector<size_t> levelDimensions(order, 0);
+  vector<const int*> levelCrds(order, nullptr);
+  size_t size = 1;
+  for (int level = 0; level < order; level++) {
+    const ModeFormat& modeFormat = sourceModeFormats[level];
+    const ModeIndex& modeIndex = index.getModeIndex(level);
+    if (isLevel(modeFormat, Dense)) {
+      levelDimensions[level] = modeIndex.getIndexArray(0).get(0).getAsIndex();
+      size *= levelDimensions[level];
+      continue;
+    }
+    levelCrds[level] = (const int*)modeIndex.getIndexArray(1).getData();
+    if (isLevel(modeFormat, Compressed)) {
+      const int* pos = (const int*)modeIndex.getIndexArray(0).getData();
+      const size_t parentSize = size;
+      size = pos[parentSize];
+      parents[level].resize(size);
+      int* levelParents = parents[level].data();
+      TACO_PARALLEL_FOR
+      for (size_t p = 0; p < parentSize; p++) {
+        for (int q = pos[p]; q < pos[p+1]; q++) {
+          levelParents[q] = (int)p;
+        }
+      }
+    }
+  }
+  const size_t numComponents = size;
+
+  // Recover the coordinates of every component from its ancestors
+  vector<vector<int>> coordinates(order, vector<int>(numComponents));
+  TACO_PARALLEL_FOR
+  for (size_t c = 0; c < numComponents; c++) {
+    size_t p = c;
+    for (int level = order - 1; level >= 0; level--) {
+      int& coordinate = coordinates[sourceFormat.getModeOrdering()[level]][c];
+      if (levelCrds[level] == nullptr) {
+        coordinate = (int)(p % levelDimensions[level]);
+        p /= levelDimensions[level];
+      } else {
+        coordinate = levelCrds[level][p];
+        if (!parents[level].empty()) {
+          p = parents[level][p];
+        }
+      }
+    }
+  }
+
+  // The components are sorted by the source modes, so they are already sorted
+  // by the last target modes if those are the first source modes. Sort them
+  // by the other target modes, least significant first.
+  const vector<int>& sourceOrdering = sourceFormat.getModeOrdering();
+  const vector<int>& targetOrdering = format.getModeOrdering();
+  int sortedLevels = 0;
+  while (sortedLevels < order &&
+         !std::equal(targetOrdering.begin() + sortedLevels, targetOrdering.end(),
+                     sourceOrdering.begin())) {
+    sortedLevels++;
+  }
+  vector<size_t> perm(numComponents);
+  TACO_PARALLEL_FOR
+  for (size_t c = 0; c < numComponents; c++) {
+    perm[c] = c;
+  }
+  for (int level = sortedLevels - 1; level >= 0; level--) {
+    const int mode = targetOrdering[level];
+    countingSort(coordinates[mode], std::max(dimensions[mode], 1), perm);
+  }
+
+  // Assemble the target levels top down, tracking the position of every
+  // component in the current level
+  vector<size_t> positions(numComponents, 0);
+  vector<ModeIndex> modeIndices;
+  size = 1;
+  for (int level = 0; level < order; level++) {
+    const ModeFormat& modeFormat = targetModeFormats[level];
+    const vector<int>& levelCoordinates = coordinates[targetOrdering[level]];
+    if (isLevel(modeFormat, Dense)) {
+      const int dimension = dimensions[targetOrdering[level]];
+      TACO_PARALLEL_FOR
+      for (size_t i = 0; i < numComponents; i++) {
+        positions[i] = positions[i] * dimension + levelCoordinates[perm[i]];
+      }
+      size *= dimension;
+      modeIndices.push_back(ModeIndex({makeArray({dimension})}));
+    } else if (isLevel(modeFormat, Compressed)) {
+      // Count the coordinates of every parent and prefix sum the counts
+      Array pos = makeArray(Int32, size + 1);
+      int* posData = (int*)pos.getData();
+      memset(posData, 0, (size + 1) * sizeof(int));
+      vector<int> crd;
+      crd.reserve(numComponents);
+      size_t prevParent = 0;
+      for (size_t i = 0; i < numComponents; i++) {
+        const size_t parent = positions[i];
+        const int coordinate = levelCoordinates[perm[i]];
+        if (i == 0 || !modeFormat.isUnique() || parent != prevParent ||
+            coordinate != crd.back()) {
+          crd.push_back(coordinate);
+          posData[parent + 1]++;
+        }
+        prevParent = parent;
+        positions[i] = crd.size() - 1;
+      }
+      for (size_t p = 0; p < size; p++) {
+        posData[p + 1] += posData[p];
+      }
+      size = crd.size();
+      modeIndices.push_back(ModeIndex({pos, makeArray(crd)}));
+    } else {
+      // Singletons are below non-unique levels, so every component has its own
+      // parent position
+      Array crd = makeArray(Int32, size);
+      int* crdData = (int*)crd.getData();
+      TACO_PARALLEL_FOR
+      for (size_t i = 0; i < numComponents; i++) {
+        crdData[positions[i]] = levelCoordinates[perm[i]];
+      }
+      modeIndices.push_back(ModeIndex({makeArray(Int32, 0), crd}));
+    }
+  }
+
+  // Scatter the values, where dense levels leave positions that hold the fill
+  const Datatype componentType = source.getComponentType();
+  const size_t csize = componentType.getNumBytes();
+  Literal fill = source.getFillValue();
+  Array vals = makeArray(componentType, size);
+  char* valsData = (char*)vals.getData();
+  if (size != numComponents) {
+    for (size_t p = 0; p < size; p++) {
+      if (fill.defined()) {
+        memcpy(&valsData[p * csize], fill.getValPtr(), csize);
+      } else {
+        memset(&valsData[p * csize], 0, csize);
+      }
+    }
+  }
+  const char* sourceVals = (const char*)source.getValues().getData();
+  TACO_PARALLEL_FOR
+  for (size_t i = 0; i < numComponents; i++) {
+    memcpy(&valsData[positions[i] * csize], &sourceVals[perm[i] * csize], csize);
+  }
+
+  TensorStorage result(componentType, dimensions, format, fill);
+  result.setIndex(Index(format, modeIndices));
+  result.setValues(vals);
+  return result;
+}
+
+}
@@ -12,17 +12,90 @@
 #include "taco/util/strings.h"
 #include "taco/util/timers.h"
 #include "taco/util/files.h"
+#include "storage/file_io_parse.h"
 
 using namespace std;
 
 namespace taco {
 
+/// Read the `%%MatrixMarket` banner line.
+static void readHeader(const string& line, string* formats, bool* symm) {
+  std::stringstream lineStream(line);
+  string head, type, field, symmetry;
+  lineStream >> head >> type >> *formats >> field >> symmetry;
+  taco_uassert(head=="%%MatrixMarket") << "Unknown header of MatrixMarket";
+  // type = [matrix tensor]
+  taco_uassert((type=="matrix") || (type=="tensor"))
+                                       << "Unknown type of MatrixMarket";
+  // formats = [coordinate array]
+  // field = [real integer complex pattern]
+  taco_uassert(field=="real")          << "MatrixMarket field not available";
+  // symmetry = [general symmetric skew-symmetric Hermitian]
+  taco_uassert((symmetry=="general") || (symmetry=="symmetric"))
+                                       << "MatrixMarket symmetry not available";
+
+  *symm = (symmetry=="symmetric");
+}
+
+/// Read the line of dimension sizes that follows the comments.
+static vector<int> readDimensions(const string& line) {
+  vector<int> dimensions;
+  char* linePtr = (char*)line.data();
+  while (size_t dimension = strtoul(linePtr, &linePtr, 10)) {
+    taco_uassert(dimension <= INT_MAX) << "Dimension exceeds INT_MAX";
+    dimensions.push_back(static_cast<int>(dimension));
+  }
+  return dimensions;
+}
+
 template <typename T>
 TensorBase dispatchReadMTX(std::string filename, const T& format, bool pack) {
-  std::fstream file;
-  util::openStream(file, filename, fstream::in);
-  TensorBase tensor = readMTX(file, format, pack);
-  file.close();
+  util::MappedFile file(filename);
+  const char* pos = file.data();
+  const char* end = pos + file.size();
+  if (pos == end) {
+    return TensorBase();
+  }
+
+  string formats;
+  bool symm;
+  readHeader(readLine(pos, end), &formats, &symm);
+  if (formats != "coordinate") {
+    std::fstream stream;
+    util::openStream(stream, filename, fstream::in);
+    return readMTX(stream, format, pack);
+  }
+
+  // Skip comments at the top of the file
+  string line;
+  do {
+    line = readLine(pos, end);
+  } while (pos < end && isCommentLine(line));
+
+  // The first non-comment line is the header with dimensions and the number
+  // of nonzeros
+  vector<int> dimensions = readDimensions(line);
+  taco_uassert(dimensions.size() > 1) << "MatrixMarket size line missing";
+  dimensions.pop_back();
+  if (symm)
+    taco_uassert(dimensions.size()==2) << "Symmetry only available for matrix";
+
+  // Parse the coordinates in parallel straight into the insertion buffer
+  vector<int> maxCoordinates;
+  vector<char> components = parseComponents(pos, end, dimensions.size(), symm,
+                                            &maxCoordinates);
+  for (size_t i = 0; i < dimensions.size(); i++) {
+    taco_uassert(maxCoordinates[i] <= dimensions[i]) <<
+        "Coordinate " << maxCoordinates[i] << " of mode " << i << " exceeds "
+        "the dimension " << dimensions[i] << " in the MatrixMarket size line";
+  }
+  TensorBase tensor(type<double>(), dimensions, format);
+  tensor.insertComponents(type<double>(), std::move(components));
+
+  if (pack) {
+    tensor.pack();
+  }
+
   return tensor;
 }
 
@@ -41,22 +114,9 @@ TensorBase dispatchReadMTX(std::istream& stream, const T& format, bool pack) {
     return TensorBase();
   }
 
-  // Read Header
-  std::stringstream lineStream(line);
-  string head, type, formats, field, symmetry;
-  lineStream >> head >> type >> formats >> field >> symmetry;
-  taco_uassert(head=="%%MatrixMarket") << "Unknown header of MatrixMarket";
-  // type = [matrix tensor]
-  taco_uassert((type=="matrix") || (type=="tensor"))
-                                       << "Unknown type of MatrixMarket";
-  // formats = [coordinate array]
-  // field = [real integer complex pattern]
-  taco_uassert(field=="real")          << "MatrixMarket field not available";
-  // symmetry = [general symmetric skew-symmetric Hermitian]
-  taco_uassert((symmetry=="general") || (symmetry=="symmetric"))
-                                       << "MatrixMarket symmetry not available";
-
-  bool symm = (symmetry=="symmetric");
+  string formats;
+  bool symm;
+  readHeader(line, &formats, &symm);
 
   TensorBase tensor;
   if (formats=="coordinate")
@@ -98,12 +158,8 @@ TensorBase dispatchReadSparse(std::istream& stream, const T& format,
   } while (std::getline(stream, line));
 
   // The first non-comment line is the header with dimensions
-  vector<int> dimensions;
-  char* linePtr = (char*)line.data();
-  while (size_t dimension = strtoul(linePtr, &linePtr, 10)) {
-    taco_uassert(dimension <= INT_MAX) << "Dimension exceeds INT_MAX";
-    dimensions.push_back(static_cast<int>(dimension));
-  }
+  vector<int> dimensions = readDimensions(line);
+  char* linePtr;
   size_t nnz = dimensions[dimensions.size()-1];
   dimensions.pop_back();
   if (symm)
@@ -174,12 +230,8 @@ TensorBase dispatchReadDense(std::istream& stream, const T& format, bool symm) {
   } while (std::getline(stream, line));
 
   // The first non-comment line is the header with dimension sizes
-  vector<int> dimensions;
-  char* linePtr = (char*)line.data();
-  while (size_t dimension = strtoul(linePtr, &linePtr, 10)) {
-    taco_uassert(dimension <= INT_MAX) << "Dimension exceeds INT_MAX";
-    dimensions.push_back(static_cast<int>(dimension));
-  }
+  vector<int> dimensions = readDimensions(line);
+  char* linePtr;
   if (symm)
     taco_uassert(dimensions.size()==2) << "Symmetry only available for matrix";
 
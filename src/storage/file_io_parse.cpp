@@ -0,0 +1,289 @@
+#include "storage/file_io_parse.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#if USE_OPENMP
+#include <omp.h>
+#endif
+
+#include "taco/error.h"
+
+using namespace std;
+
+#if USE_OPENMP
+#define TACO_PARALLEL_FOR _Pragma("omp parallel for schedule(static)")
+#else
+#define TACO_PARALLEL_FOR
+#endif
+
+namespace taco {
+
+string readLine(const char*& pos, const char* end) {
+  const char* lineEnd = (const char*)memchr(pos, '\n', end - pos);
+  if (lineEnd == nullptr) {
+    lineEnd = end;
+  }
+  string line(pos, (lineEnd > pos && lineEnd[-1] == '\r') ? lineEnd-1 : lineEnd);
+  pos = (lineEnd == end) ? end : lineEnd + 1;
+  return line;
+}
+
+size_t countTokens(const string& line) {
+  size_t numTokens = 0;
+  bool inToken = false;
+  for (char c : line) {
+    bool isSpace = (c == ' ' || c == '\t' || c == '\r');
+    if (!isSpace && !inToken) {
+      numTokens++;
+    }
+    inToken = !isSpace;
+  }
+  return numTokens;
+}
+
+bool isCommentLine(const string& line) {
+  size_t first = line.find_first_not_of(" \t\r");
+  return first == string::npos || line[first] == '%' || line[first] == '#';
+}
+
+namespace {
+
+inline bool isBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* pos, const char* end) {
+  while (pos < end && isBlank(*pos)) {
+    pos++;
+  }
+  return pos;
+}
+
+inline const char* skipLine(const char* pos, const char* end) {
+  const char* lineEnd = (const char*)memchr(pos, '\n', end - pos);
+  return (lineEnd == nullptr) ? end : lineEnd + 1;
+}
+
+/// Parse an unsigned decimal integer. Returns false if there are no digits or
+/// if the integer exceeds INT_MAX.
+inline bool parseIndex(const char*& pos, const char* end, int* index) {
+  const char* start = pos;
+  long value = 0;
+  while (pos < end && *pos >= '0' && *pos <= '9') {
+    value = value * 10 + (*pos - '0');
+    if (value > INT_MAX) {
+      return false;
+    }
+    pos++;
+  }
+  *index = (int)value;
+  return pos != start;
+}
+
+/// Parse a floating-point number. Numbers with at most 19 significant digits
+/// whose mantissa and power of ten are exactly representable as doubles are
+/// computed directly, which rounds correctly; all other numbers (including
+/// inf and nan) are handed to strtod.
+inline double parseValue(const char*& pos, const char* end) {
+  static const double powersOf10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const char* start = pos;
+  bool negative = false;
+  if (pos < end && (*pos == '-' || *pos == '+')) {
+    negative = (*pos == '-');
+    pos++;
+  }
+
+  uint64_t mantissa = 0;
+  int numDigits = 0;
+  int exponent = 0;
+  bool hasDigits = false;
+  for (; pos < end && *pos >= '0' && *pos <= '9'; pos++) {
+    hasDigits = true;
+    if (mantissa != 0 || *pos != '0') {
+      if (++numDigits <= 19) {
+        mantissa = mantissa * 10 + (*pos - '0');
+      } else {
+        exponent++;
+      }
+    }
+  }
+  if (pos < end && *pos == '.') {
+    for (pos++; pos < end && *pos >= '0' && *pos <= '9'; pos++) {
+      hasDigits = true;
+      if (mantissa != 0 || *pos != '0') {
+        if (++numDigits <= 19) {
+          mantissa = mantissa * 10 + (*pos - '0');
+          exponent--;
+        }
+      } else {
+        exponent--;
+      }
+    }
+  }
+  if (hasDigits && pos < end && (*pos == 'e' || *pos == 'E')) {
+    const char* exponentStart = pos++;
+    bool negativeExponent = false;
+    if (pos < end && (*pos == '-' || *pos == '+')) {
+      negativeExponent = (*pos == '-');
+      pos++;
+    }
+    if (pos < end && *pos >= '0' && *pos <= '9') {
+      int value = 0;
+      for (; pos < end && *pos >= '0' && *pos <= '9'; pos++) {
+        value = std::min(value * 10 + (*pos - '0'), 100000);
+      }
+      exponent += negativeExponent ? -value : value;
+    } else {
+      pos = exponentStart;
+    }
+  }
+
+  if (hasDigits && numDigits <= 19 && mantissa <= (UINT64_C(1) << 53) &&
+      exponent >= -22 && exponent <= 22) {
+    double value = (double)mantissa;
+    value = (exponent < 0) ? value / powersOf10[-exponent]
+                           : value * powersOf10[exponent];
+    return negative ? -value : value;
+  }
+
+  // Slow path: strtod needs a terminated string
+  pos = start;
+  while (pos < end && !isBlank(*pos) && *pos != '\n') {
+    pos++;
+  }
+  string token(start, pos);
+  return strtod(token.c_str(), nullptr);
+}
+
+/// Parse the lines in [begin, end) into `components`, which has room for at
+/// least `capacity` components. Returns the number of components written, or
+/// -1 if a line is malformed.
+long parseChunk(const char* begin, const char* end, size_t order,
+                bool symmetric, char* components, size_t capacity,
+                vector<int>& maxCoordinates) {
+  const size_t componentSize = order * sizeof(int) + sizeof(double);
+  vector<int> coordinates(order);
+  size_t numComponents = 0;
+  const char* pos = begin;
+  while (pos < end) {
+    pos = skipBlanks(pos, end);
+    if (pos == end || *pos == '\n' || *pos == '%' || *pos == '#') {
+      pos = skipLine(pos, end);
+      continue;
+    }
+
+    for (size_t i = 0; i < order; i++) {
+      pos = skipBlanks(pos, end);
+      int index;
+      if (!parseIndex(pos, end, &index) || index == 0 ||
+          (pos < end && !isBlank(*pos) && *pos != '\n')) {
+        return -1;
+      }
+      coordinates[i] = index - 1;
+      maxCoordinates[i] = std::max(maxCoordinates[i], index);
+    }
+    pos = skipBlanks(pos, end);
+    double value = (pos < end && *pos != '\n') ? parseValue(pos, end) : 0.0;
+    pos = skipLine(pos, end);
+
+    taco_iassert(numComponents < capacity);
+    char* component = &components[numComponents * componentSize];
+    memcpy(component, coordinates.data(), order * sizeof(int));
+    memcpy(component + order * sizeof(int), &value, sizeof(double));
+    numComponents++;
+
+    if (symmetric && coordinates.front() != coordinates.back()) {
+      std::reverse(coordinates.begin(), coordinates.end());
+      taco_iassert(numComponents < capacity);
+      component = &components[numComponents * componentSize];
+      memcpy(component, coordinates.data(), order * sizeof(int));
+      memcpy(component + order * sizeof(int), &value, sizeof(double));
+      numComponents++;
+    }
+  }
+  return numComponents;
+}
+
+}
+
+vector<char> parseComponents(const char* begin, const char* end, size_t order,
+                             bool symmetric, vector<int>* dimensions) {
+  const size_t componentSize = order * sizeof(int) + sizeof(double);
+  const size_t size = end - begin;
+
+  // Split the text into chunks that start at the beginning of a line
+  size_t numChunks = 1;
+#if USE_OPENMP
+  // Chunks smaller than a megabyte are not worth handing to another thread
+  const size_t minChunkSize = 1 << 20;
+  numChunks = std::max<size_t>(1, std::min<size_t>(4 * omp_get_max_threads(),
+                                                   size / minChunkSize));
+#endif
+  vector<const char*> chunks(numChunks + 1);
+  chunks[0] = begin;
+  chunks[numChunks] = end;
+  for (size_t i = 1; i < numChunks; i++) {
+    const char* split = std::max(begin + i * (size / numChunks), chunks[i-1]);
+    chunks[i] = (split == begin) ? begin : skipLine(split - 1, end);
+  }
+
+  // Count the lines of each chunk to bound the number of components it holds
+  vector<size_t> offsets(numChunks + 1, 0);
+  TACO_PARALLEL_FOR
+  for (size_t i = 0; i < numChunks; i++) {
+    size_t numLines = 0;
+    for (const char* pos = chunks[i]; pos < chunks[i+1];
+         pos = skipLine(pos, chunks[i+1])) {
+      numLines++;
+    }
+    offsets[i+1] = symmetric ? 2 * numLines : numLines;
+  }
+  for (size_t i = 0; i < numChunks; i++) {
+    offsets[i+1] += offsets[i];
+  }
+
+  // Parse each chunk into its slice of the component buffer
+  vector<char> components(offsets[numChunks] * componentSize);
+  vector<long> numComponents(numChunks);
+  vector<vector<int>> maxCoordinates(numChunks, vector<int>(order, 0));
+  TACO_PARALLEL_FOR
+  for (size_t i = 0; i < numChunks; i++) {
+    numComponents[i] = parseChunk(chunks[i], chunks[i+1], order, symmetric,
+                                  &components[offsets[i] * componentSize],
+                                  offsets[i+1] - offsets[i], maxCoordinates[i]);
+  }
+
+  // Close the gaps left by skipped lines and symmetric diagonal components
+  size_t used = 0;
+  for (size_t i = 0; i < numChunks; i++) {
+    taco_uassert(numComponents[i] >= 0) <<
+        "Malformed coordinate line: coordinates must be positive integers no "
+        "larger than INT_MAX";
+    if (offsets[i] != used) {
+      memmove(&components[used * componentSize],
+              &components[offsets[i] * componentSize],
+              numComponents[i] * componentSize);
+    }
+    used += numComponents[i];
+  }
+  components.resize(used * componentSize);
+
+  if (dimensions != nullptr) {
+    dimensions->assign(order, 0);
+    for (auto& chunkMax : maxCoordinates) {
+      for (size_t i = 0; i < order; i++) {
+        (*dimensions)[i] = std::max((*dimensions)[i], chunkMax[i]);
+      }
+    }
+  }
+  return components;
+}
+
+}
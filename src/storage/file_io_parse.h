@@ -0,0 +1,33 @@
+#ifndef TACO_FILE_IO_PARSE_H
+#define TACO_FILE_IO_PARSE_H
+
+#include <string>
+#include <vector>
+
+namespace taco {
+
+/// Returns the line that starts at `pos` without its line terminator, and
+/// advances `pos` to the start of the next line.
+std::string readLine(const char*& pos, const char* end);
+
+/// Returns the number of whitespace-separated tokens in `line`.
+size_t countTokens(const std::string& line);
+
+/// Returns true if `line` is blank or a comment starting with '%' or '#'.
+bool isCommentLine(const std::string& line);
+
+/// Parse the coordinate lines in [begin, end) of a Matrix Market or tns file
+/// into a buffer of components that can be passed to
+/// `TensorBase::insertComponents` for a Float64 tensor of the given order.
+/// Each line holds `order` one-based coordinates followed by a value; blank
+/// lines and lines starting with '%' or '#' are skipped. The text is split into
+/// newline-aligned chunks that are parsed in parallel. If `symmetric` is set,
+/// the transpose of every off-diagonal component is added too. If
+/// `dimensions` is not null, it is set to the largest coordinate of each mode,
+/// which callers that read dimensions from a header must check against them.
+std::vector<char> parseComponents(const char* begin, const char* end,
+                                  size_t order, bool symmetric,
+                                  std::vector<int>* dimensions);
+
+}
+#endif
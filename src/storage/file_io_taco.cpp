@@ -0,0 +1,449 @@
+#include "taco/storage/file_io_taco.h"
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <cstdio>
+#include <unistd.h>
+
+#include "taco/tensor.h"
+#include "taco/format.h"
+#include "taco/error.h"
+#include "taco/storage/storage.h"
+#include "taco/storage/index.h"
+#include "taco/storage/array.h"
+#include "taco/util/files.h"
+
+using namespace std;
+
+namespace taco {
+
+// A binary tensor file starts with a fixed preamble (magic string, format
+// version, byte order mark and header size), followed by a header that
+// describes the component type, dimensions, format, fill value and the
+// location of every index and value array. The arrays follow the header, each
+// aligned to `arrayAlignment` bytes so that they can be used in place when the
+// file is memory-mapped. All numbers are stored in native byte order.
+static const char     magic[8]       = {'T','A','C','O','B','I','N','\0'};
+static const uint32_t version        = 1;
+static const uint32_t byteOrderMark  = 0x01020304;
+static const size_t   preambleSize   = sizeof(magic) + 2*sizeof(uint32_t) +
+                                       sizeof(uint64_t);
+static const size_t   arrayAlignment = 64;
+
+// Mode format properties stored as a bit set
+enum {Full = 1, Ordered = 2, Unique = 4, Zeroless = 8, Padded = 16};
+
+static size_t alignUp(size_t offset) {
+  return (offset + arrayAlignment - 1) / arrayAlignment * arrayAlignment;
+}
+
+namespace {
+
+class HeaderWriter {
+public:
+  template <typename T>
+  void write(T value) {
+    const char* bytes = (const char*)&value;
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+  }
+
+  void write(const string& str) {
+    write<uint32_t>(str.size());
+    buffer.insert(buffer.end(), str.begin(), str.end());
+  }
+
+  /// Write an array descriptor whose offset is filled in by `placeArrays`.
+  void write(const Array& array) {
+    write<uint32_t>(array.getType().getKind());
+    write<uint64_t>(array.getSize());
+    offsetFields.push_back(buffer.size());
+    arrays.push_back(array);
+    write<uint64_t>(0);
+  }
+
+  /// Assign every array an aligned offset following the header, and returns
+  /// the size of the file.
+  size_t placeArrays() {
+    size_t offset = alignUp(preambleSize + buffer.size());
+    for (size_t i = 0; i < arrays.size(); i++) {
+      uint64_t arrayOffset = offset;
+      memcpy(&buffer[offsetFields[i]], &arrayOffset, sizeof(arrayOffset));
+      offsets.push_back(offset);
+      offset = alignUp(offset + arrays[i].getSize() *
+                                arrays[i].getType().getNumBytes());
+    }
+    return offset;
+  }
+
+  vector<char> buffer;
+  vector<Array> arrays;
+  vector<size_t> offsets;
+
+private:
+  vector<size_t> offsetFields;
+};
+
+class HeaderReader {
+public:
+  HeaderReader(char* data, size_t size, size_t headerEnd,
+               shared_ptr<void> owner)
+      : data(data), size(size), pos(preambleSize), headerEnd(headerEnd),
+        owner(owner) {
+  }
+
+  template <typename T>
+  T read() {
+    taco_uassert(pos + sizeof(T) <= headerEnd) << "Truncated tensor file";
+    T value;
+    memcpy(&value, &data[pos], sizeof(T));
+    pos += sizeof(T);
+    return value;
+  }
+
+  string readString() {
+    uint32_t length = read<uint32_t>();
+    taco_uassert(pos + length <= headerEnd) << "Truncated tensor file";
+    string str(&data[pos], length);
+    pos += length;
+    return str;
+  }
+
+  Datatype readType() {
+    uint32_t kind = read<uint32_t>();
+    taco_uassert(kind < Datatype::Undefined) << "Corrupt tensor file";
+    return Datatype((Datatype::Kind)kind);
+  }
+
+  /// Read an array descriptor and return an array that points into the data.
+  Array readArray() {
+    Datatype type = readType();
+    uint64_t numElements = read<uint64_t>();
+    uint64_t offset = read<uint64_t>();
+    taco_uassert(offset % arrayAlignment == 0 && offset <= size &&
+                 numElements <= (size - offset) / type.getNumBytes())
+        << "Corrupt tensor file";
+    return Array(type, &data[offset], numElements, owner);
+  }
+
+private:
+  char* data;
+  size_t size;
+  size_t pos;
+  size_t headerEnd;
+  shared_ptr<void> owner;
+};
+
+}
+
+static ModeFormat makeModeFormat(const string& name, uint32_t properties) {
+  ModeFormat modeFormat;
+  if (name == ModeFormat::Dense.getName()) {
+    modeFormat = ModeFormat::Dense;
+  } else if (name == ModeFormat::Compressed.getName()) {
+    modeFormat = ModeFormat::Compressed;
+  } else if (name == ModeFormat::Singleton.getName()) {
+    modeFormat = ModeFormat::Singleton;
+  } else if (name == ModeFormat::Hashed.getName()) {
+    modeFormat = ModeFormat::Hashed;
+  } else if (name == ModeFormat::Bitmap.getName()) {
+    modeFormat = ModeFormat::Bitmap;
+  } else if (name == ModeFormat::Diagonal.getName()) {
+    modeFormat = ModeFormat::Diagonal;
+  } else if (name == ModeFormat::Ell.getName()) {
+    // The stride of the rows is stored with the tensor, so it can be read with
+    // any slice height
+    modeFormat = ModeFormat::Ell;
+  } else {
+    taco_uerror << "Unsupported mode format in tensor file: " << name;
+  }
+  return modeFormat({
+    (properties & Full)     ? ModeFormat::FULL     : ModeFormat::NOT_FULL,
+    (properties & Ordered)  ? ModeFormat::ORDERED  : ModeFormat::NOT_ORDERED,
+    (properties & Unique)   ? ModeFormat::UNIQUE   : ModeFormat::NOT_UNIQUE,
+    (properties & Zeroless) ? ModeFormat::ZEROLESS : ModeFormat::NOT_ZEROLESS,
+    (properties & Padded)   ? ModeFormat::PADDED   : ModeFormat::NOT_PADDED
+  });
+}
+
+static Format makeFormat(const ModeFormat& modetype, int order) {
+  return Format(vector<ModeFormatPack>(order, modetype));
+}
+
+static Format makeFormat(const Format& format, int) {
+  return format;
+}
+
+/// Check that the pos and crd arrays of the compressed and singleton levels
+/// read from a file describe a valid index of a tensor with the given
+/// dimensions, so that kernels never index past the arrays. Validation stops
+/// at the first level of any other format.
+static void checkIndex(const Format& format, const vector<int>& dimensions,
+                       const vector<ModeIndex>& modeIndices,
+                       const Array& values) {
+  size_t numPositions = 1;
+  for (int level = 0; level < format.getOrder(); level++) {
+    const ModeFormat modeFormat = format.getModeFormats()[level];
+    const size_t dimension = dimensions[format.getModeOrdering()[level]];
+    const ModeIndex& modeIndex = modeIndices[level];
+    if (modeFormat.getName() == ModeFormat::Dense.getName()) {
+      numPositions *= dimension;
+      continue;
+    }
+    if (modeFormat.getName() != ModeFormat::Compressed.getName() &&
+        modeFormat.getName() != ModeFormat::Singleton.getName()) {
+      return;
+    }
+    taco_uassert(modeIndex.numIndexArrays() == 2) << "Corrupt tensor file";
+
+    size_t numCoordinates = numPositions;
+    if (modeFormat.getName() == ModeFormat::Compressed.getName()) {
+      const Array& pos = modeIndex.getIndexArray(0);
+      taco_uassert(pos.getSize() > numPositions)
+          << "Corrupt tensor file: level " << level << " has too few pos "
+          << "entries";
+      for (size_t i = 0; i < numPositions; i++) {
+        taco_uassert(pos.get(i).getAsIndex() <= pos.get(i + 1).getAsIndex())
+            << "Corrupt tensor file: pos array of level " << level
+            << " decreases";
+      }
+      numCoordinates = pos.get(numPositions).getAsIndex();
+    }
+    const Array& crd = modeIndex.getIndexArray(1);
+    taco_uassert(numCoordinates <= crd.getSize())
+        << "Corrupt tensor file: pos array of level " << level
+        << " exceeds its crd array";
+    for (size_t i = 0; i < numCoordinates; i++) {
+      taco_uassert(crd.get(i).getAsIndex() < dimension)
+          << "Corrupt tensor file: coordinate out of bounds at level "
+          << level;
+    }
+    numPositions = numCoordinates;
+  }
+  taco_uassert(numPositions <= values.getSize())
+      << "Corrupt tensor file: too few values";
+}
+
+/// Decodes tensors from the binary format. A tensor read from a file has
+/// been packed, so the decoder needs access to the compiler state of tensors.
+struct TACODecoder {
+  static TensorBase decode(char* data, size_t size, shared_ptr<void> owner);
+};
+
+/// Decode a binary tensor whose bytes are kept alive by `owner`.
+TensorBase TACODecoder::decode(char* data, size_t size,
+                               shared_ptr<void> owner) {
+  taco_uassert(size >= preambleSize && memcmp(data, magic, sizeof(magic)) == 0)
+      << "Not a taco tensor file";
+  uint32_t fileVersion, fileByteOrderMark;
+  uint64_t headerSize;
+  memcpy(&fileVersion, &data[sizeof(magic)], sizeof(uint32_t));
+  memcpy(&fileByteOrderMark, &data[sizeof(magic) + sizeof(uint32_t)],
+         sizeof(uint32_t));
+  memcpy(&headerSize, &data[sizeof(magic) + 2*sizeof(uint32_t)],
+         sizeof(uint64_t));
+  taco_uassert(fileVersion == version)
+      << "Unsupported taco tensor file version " << fileVersion;
+  taco_uassert(fileByteOrderMark == byteOrderMark)
+      << "Taco tensor file was written with a different byte order";
+  taco_uassert(headerSize <= size - preambleSize) << "Truncated tensor file";
+
+  HeaderReader reader(data, size, preambleSize + headerSize, owner);
+  Datatype componentType = reader.readType();
+  uint32_t order = reader.read<uint32_t>();
+  vector<int> dimensions(order);
+  for (auto& dimension : dimensions) {
+    dimension = reader.read<int32_t>();
+  }
+  vector<int> modeOrdering(order);
+  for (auto& mode : modeOrdering) {
+    mode = reader.read<int32_t>();
+  }
+  vector<ModeFormatPack> modeFormatPacks;
+  uint32_t numPacks = reader.read<uint32_t>();
+  for (uint32_t i = 0; i < numPacks; i++) {
+    vector<ModeFormat> modeFormats;
+    uint32_t numModes = reader.read<uint32_t>();
+    for (uint32_t j = 0; j < numModes; j++) {
+      string name = reader.readString();
+      modeFormats.push_back(makeModeFormat(name, reader.read<uint32_t>()));
+    }
+    modeFormatPacks.push_back(modeFormats);
+  }
+  vector<vector<Datatype>> levelArrayTypes(reader.read<uint32_t>());
+  for (auto& levelTypes : levelArrayTypes) {
+    levelTypes.resize(reader.read<uint32_t>());
+    for (auto& type : levelTypes) {
+      type = reader.readType();
+    }
+  }
+  Format format(modeFormatPacks, modeOrdering);
+  format.setLevelArrayTypes(levelArrayTypes);
+
+  Literal fill;
+  if (reader.read<uint8_t>()) {
+    fill = Literal::zero(componentType);
+    for (int i = 0; i < componentType.getNumBytes(); i++) {
+      ((char*)fill.getValPtr())[i] = reader.read<char>();
+    }
+  }
+
+  vector<ModeIndex> modeIndices(order);
+  for (auto& modeIndex : modeIndices) {
+    vector<Array> arrays(reader.read<uint32_t>());
+    for (auto& array : arrays) {
+      array = reader.readArray();
+    }
+    modeIndex = ModeIndex(arrays);
+  }
+  Array values = reader.readArray();
+  checkIndex(format, dimensions, modeIndices, values);
+
+  TensorBase tensor(componentType, dimensions, format, fill);
+  TensorStorage storage = tensor.getStorage();
+  storage.setIndex(Index(format, modeIndices));
+  storage.setValues(values);
+  tensor.setStorage(storage);
+
+  // Components inserted into the tensor are added to the stored ones when it
+  // is packed again
+  tensor.unsetNeverPacked();
+  return tensor;
+}
+
+TensorBase readTACO(std::string filename) {
+  auto file = make_shared<util::MappedFile>(filename, true);
+  return TACODecoder::decode(file->data(), file->size(), file);
+}
+
+template <typename T>
+TensorBase dispatchReadTACO(std::string filename, const T& format, bool) {
+  TensorBase tensor = readTACO(filename);
+  Format requested = makeFormat(format, tensor.getOrder());
+  return (requested == tensor.getFormat()) ? tensor : tensor.convert(requested);
+}
+
+TensorBase readTACO(std::string filename, const ModeFormat& modetype,
+                    bool pack) {
+  return dispatchReadTACO(filename, modetype, pack);
+}
+
+TensorBase readTACO(std::string filename, const Format& format, bool pack) {
+  return dispatchReadTACO(filename, format, pack);
+}
+
+template <typename T>
+TensorBase dispatchReadTACO(std::istream& stream, const T& format, bool) {
+  auto bytes = make_shared<vector<char>>(istreambuf_iterator<char>(stream),
+                                         istreambuf_iterator<char>());
+  TensorBase tensor = TACODecoder::decode(bytes->data(), bytes->size(),
+                                            bytes);
+  Format requested = makeFormat(format, tensor.getOrder());
+  return (requested == tensor.getFormat()) ? tensor : tensor.convert(requested);
+}
+
+TensorBase readTACO(std::istream& stream, const ModeFormat& modetype,
+                    bool pack) {
+  return dispatchReadTACO(stream, modetype, pack);
+}
+
+TensorBase readTACO(std::istream& stream, const Format& format, bool pack) {
+  return dispatchReadTACO(stream, format, pack);
+}
+
+void writeTACO(std::string filename, const TensorBase& tensor) {
+  // Tensors read from the file may still map it, so the file is replaced by a
+  // new file rather than overwritten in place
+  const string path = util::sanitizePath(filename);
+  const string tmppath = path + ".tmp" + to_string(getpid());
+  std::fstream file;
+  util::openStream(file, tmppath, fstream::out | fstream::binary);
+  writeTACO(file, tensor);
+  file.close();
+  if (rename(tmppath.c_str(), path.c_str()) != 0) {
+    remove(tmppath.c_str());
+    taco_uerror << "Error writing file: " << filename;
+  }
+}
+
+void writeTACO(std::ostream& stream, const TensorBase& tensor) {
+  TensorStorage storage = tensor.getStorage();
+  const Format& format = storage.getFormat();
+  const Datatype componentType = storage.getComponentType();
+
+  HeaderWriter header;
+  header.write<uint32_t>(componentType.getKind());
+  header.write<uint32_t>(storage.getOrder());
+  for (int dimension : storage.getDimensions()) {
+    header.write<int32_t>(dimension);
+  }
+  for (int mode : format.getModeOrdering()) {
+    header.write<int32_t>(mode);
+  }
+  header.write<uint32_t>(format.getModeFormatPacks().size());
+  for (auto& modeFormatPack : format.getModeFormatPacks()) {
+    header.write<uint32_t>(modeFormatPack.getModeFormats().size());
+    for (auto& modeFormat : modeFormatPack.getModeFormats()) {
+      header.write(modeFormat.getName());
+      header.write<uint32_t>((modeFormat.isFull()     ? Full     : 0) |
+                             (modeFormat.isOrdered()  ? Ordered  : 0) |
+                             (modeFormat.isUnique()   ? Unique   : 0) |
+                             (modeFormat.isZeroless() ? Zeroless : 0) |
+                             (modeFormat.isPadded()   ? Padded   : 0));
+    }
+  }
+  header.write<uint32_t>(format.getLevelArrayTypes().size());
+  for (auto& levelTypes : format.getLevelArrayTypes()) {
+    header.write<uint32_t>(levelTypes.size());
+    for (auto& type : levelTypes) {
+      header.write<uint32_t>(type.getKind());
+    }
+  }
+
+  Literal fill = storage.getFillValue();
+  header.write<uint8_t>(fill.defined());
+  if (fill.defined()) {
+    const char* fillBytes = (const char*)fill.getValPtr();
+    for (int i = 0; i < componentType.getNumBytes(); i++) {
+      header.write<char>(fillBytes[i]);
+    }
+  }
+
+  const Index& index = storage.getIndex();
+  taco_uassert(index.numModeIndices() == storage.getOrder())
+      << "Only packed tensors can be written";
+  for (int i = 0; i < index.numModeIndices(); i++) {
+    const ModeIndex& modeIndex = index.getModeIndex(i);
+    header.write<uint32_t>(modeIndex.numIndexArrays());
+    for (int j = 0; j < modeIndex.numIndexArrays(); j++) {
+      header.write(modeIndex.getIndexArray(j));
+    }
+  }
+  header.write(storage.getValues());
+  const size_t fileSize = header.placeArrays();
+
+  stream.write(magic, sizeof(magic));
+  stream.write((const char*)&version, sizeof(version));
+  stream.write((const char*)&byteOrderMark, sizeof(byteOrderMark));
+  uint64_t headerSize = header.buffer.size();
+  stream.write((const char*)&headerSize, sizeof(headerSize));
+  stream.write(header.buffer.data(), header.buffer.size());
+
+  size_t position = preambleSize + header.buffer.size();
+  const vector<char> padding(arrayAlignment, 0);
+  for (size_t i = 0; i < header.arrays.size(); i++) {
+    const Array& array = header.arrays[i];
+    stream.write(padding.data(), header.offsets[i] - position);
+    const size_t numBytes = array.getSize() * array.getType().getNumBytes();
+    stream.write((const char*)array.getData(), numBytes);
+    position = header.offsets[i] + numBytes;
+  }
+  stream.write(padding.data(), fileSize - position);
+  taco_uassert(stream.good()) << "Error writing tensor";
+}
+
+}
@@ -13,6 +13,7 @@
 #include "taco/error.h"
 #include "taco/util/strings.h"
 #include "taco/util/files.h"
+#include "storage/file_io_parse.h"
 
 using namespace std;
 
@@ -20,10 +21,33 @@ namespace taco {
 
 template <typename T>
 TensorBase dispatchReadTNS(std::string filename, const T& format, bool pack) {
-  std::fstream file;
-  util::openStream(file, filename, fstream::in);
-  TensorBase tensor = readTNS(file, format, pack);
-  file.close();
+  util::MappedFile file(filename);
+  const char* begin = file.data();
+  const char* end = begin + file.size();
+
+  // Infer tensor order from the first coordinate
+  size_t order = 0;
+  for (const char* pos = begin; pos < end && order == 0;) {
+    string line = readLine(pos, end);
+    if (!isCommentLine(line)) {
+      order = countTokens(line) - 1;
+    }
+  }
+  if (order == 0) {
+    return TensorBase();
+  }
+
+  // Parse the coordinates in parallel straight into the insertion buffer
+  std::vector<int> dimensions;
+  std::vector<char> components = parseComponents(begin, end, order, false,
+                                                 &dimensions);
+  TensorBase tensor(type<double>(), dimensions, format);
+  tensor.insertComponents(type<double>(), std::move(components));
+
+  if (pack) {
+    tensor.pack();
+  }
+
   return tensor;
 }
 
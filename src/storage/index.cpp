@@ -59,6 +59,14 @@ size_t Index::getSize() const {
       size *= modeIndex.getIndexArray(0).get(0).getAsIndex();
     } else if (modeType.getName() == Sparse.getName()) {
       size = modeIndex.getIndexArray(0).get(size).getAsIndex();
+    } else if (modeType.getName() == Hashed.getName() ||
+               modeType.getName() == Diagonal.getName()) {
+      size *= modeIndex.getIndexArray(0).get(0).getAsIndex();
+    } else if (modeType.getName() == Bitmap.getName()) {
+      const Array& rank = modeIndex.getIndexArray(0);
+      size = rank.get(rank.getSize() - 1).getAsIndex();
+    } else if (modeType.getName() == Ell.getName()) {
+      size = modeIndex.getIndexArray(0).get(2 * size + 1).getAsIndex();
     } else {
       taco_not_supported_yet;
     }
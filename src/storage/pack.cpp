@@ -1,6 +1,12 @@
 #include "taco/storage/pack.h"
 
+#include <algorithm>
 #include <climits>
+#include <cstdint>
+#include <cstring>
+#if USE_OPENMP
+#include <omp.h>
+#endif
 
 #include "taco/format.h"
 #include "taco/error.h"
@@ -9,10 +15,18 @@
 #include "taco/storage/storage.h"
 #include "taco/storage/index.h"
 #include "taco/storage/array.h"
+#include "taco/lower/mode_format_hashed.h"
+#include "taco/lower/mode_format_bitmap.h"
 #include "taco/util/collections.h"
 
 using namespace std;
 
+#if USE_OPENMP
+#define TACO_PARALLEL_FOR _Pragma("omp parallel for schedule(static)")
+#else
+#define TACO_PARALLEL_FOR
+#endif
+
 namespace taco {
 
 #define PACK_NEXT_LEVEL(cend) {                                          \
@@ -54,6 +68,27 @@ static TypedIndexVector getUniqueEntries(TypedIndexVector v,
   return uniqueEntries;
 }
 
+/// Returns the largest number of unique coordinates of a level below any
+/// position of the level above (assumes the coordinates are sorted).
+static size_t getMaxSegmentSize(const vector<TypedIndexVector>& coords,
+                                size_t level) {
+  size_t maxSize = 0;
+  size_t size = 0;
+  for (size_t n = 0; n < coords[level].size(); n++) {
+    bool newSegment = (n == 0);
+    for (size_t l = 0; l < level && !newSegment; l++) {
+      newSegment = coords[l][n] != coords[l][n-1];
+    }
+    if (newSegment) {
+      size = 1;
+    } else if (coords[level][n] != coords[level][n-1]) {
+      size++;
+    }
+    maxSize = std::max(maxSize, size);
+  }
+  return maxSize;
+}
+
 /// Pack tensor coordinates into an index structure and value array.  The
 /// indices consist of one index per tensor mode, and each index contains
 /// [0,2] index arrays.
@@ -100,6 +135,81 @@ static int packTensor(const vector<int>& dimensions,
       PACK_NEXT_LEVEL(cend);
       cbegin = cend;
     }
+  } else if (modeType.getName() == Hashed.getName()) {
+    TypedIndexVector indexValues = getUniqueEntries(levelCoords, begin, end);
+    const int width = (int)index[0][0].getAsIndex();
+
+    // Place the unique index values in the hash table of this segment and
+    // remember where each of their child segments begins and ends
+    vector<int> slots(width, -1);
+    vector<size_t> segmentBegins(width), segmentEnds(width);
+    size_t cbegin = begin;
+    for (int j = 0; j < (int) indexValues.size(); j++) {
+      size_t cend = cbegin;
+      while (cend < end && levelCoords[cend] == indexValues[j]) {
+        cend++;
+      }
+      const int coord = (int)indexValues[j].getAsIndex();
+      int slot = HashedModeFormat::hash(coord, width);
+      while (slots[slot] != -1) {
+        slot = (slot + 1) & (width - 1);
+      }
+      slots[slot] = coord;
+      segmentBegins[slot] = cbegin;
+      segmentEnds[slot] = cend;
+      cbegin = cend;
+    }
+
+    // Store the table and recursively pack every slot, where empty slots get
+    // empty child segments
+    index[1].push_back_vector(slots);
+    for (int slot = 0; slot < width; slot++) {
+      cbegin = (slots[slot] == -1) ? end : segmentBegins[slot];
+      PACK_NEXT_LEVEL((slots[slot] == -1) ? end : segmentEnds[slot]);
+    }
+  } else if (modeType.getName() == Bitmap.getName()) {
+    // Bitmap levels are last levels, so the values of the set bits are packed
+    // in order after the values packed so far
+    TypedIndexVector indexValues = getUniqueEntries(levelCoords, begin, end);
+    const int wordBits = BitmapModeFormat::WORD_BITS;
+    vector<uint64_t> words((dimensions[i] + wordBits - 1) / wordBits, 0);
+    for (int j = 0; j < (int) indexValues.size(); j++) {
+      const int coord = (int)indexValues[j].getAsIndex();
+      words[coord / wordBits] |= (uint64_t)1 << (coord % wordBits);
+    }
+    int rank = valuesIndex / dataType.getNumBytes();
+    for (uint64_t word : words) {
+      index[0].push_back(rank);
+      rank += __builtin_popcountll(word);
+    }
+    index[1].push_back_vector(words);
+
+    size_t cbegin = begin;
+    for (int j = 0; j < (int) indexValues.size(); j++) {
+      size_t cend = cbegin;
+      while (cend < end && levelCoords[cend] == indexValues[j]) {
+        cend++;
+      }
+      PACK_NEXT_LEVEL(cend);
+      cbegin = cend;
+    }
+  } else if (modeType.getName() == Diagonal.getName()) {
+    // Diagonal levels are below the rows of a dense level, so the row is the
+    // number of values packed so far divided by the number of diagonals, and
+    // every row packs one value per diagonal
+    const int numDiagonals = (int)index[0][0].getAsIndex();
+    const int row = (numDiagonals == 0) ? 0 :
+                    valuesIndex / dataType.getNumBytes() / numDiagonals;
+    size_t cbegin = begin;
+    for (int k = 0; k < numDiagonals; k++) {
+      const int coord = row + (int)index[1][k].getAsIndex();
+      size_t cend = cbegin;
+      while (cend < end && levelCoords[cend] == coord) {
+        cend++;
+      }
+      PACK_NEXT_LEVEL(cend);
+      cbegin = cend;
+    }
   } else {
     taco_not_supported_yet;
   }
@@ -155,17 +265,69 @@ TensorStorage pack(Datatype                             componentType,
       indices[i][0].push_back(0);
 
       maxSize = numCoordinates;
+    } else if (modeType.getName() == Hashed.getName()) {
+      // Hashed indices have two arrays: the width of the hash tables and the
+      // hash tables, which are at most half full
+      int width = 1;
+      while ((size_t)width < 2 * getMaxSegmentSize(coordinates, i)) {
+        width *= 2;
+      }
+      indices.push_back({TypedIndexVector(Int32),
+                         TypedIndexVector(format.getCoordinateTypeIdx(i))});
+      indices[i][0].push_back(width);
+
+      maxSize = std::max(maxSize, (long long int)numCoordinates) * width;
+    } else if (modeType.getName() == Bitmap.getName()) {
+      // Bitmap indices have two arrays: the rank of every word and the words.
+      // Position 0 is reserved for the fill value.
+      taco_iassert(i == order - 1) << "Bitmap levels must be last levels";
+      indices.push_back({TypedIndexVector(format.getCoordinateTypePos(i)),
+                         TypedIndexVector(UInt64)});
+      maxSize = numCoordinates + 1;
+    } else if (modeType.getName() == Diagonal.getName()) {
+      // Diagonal indices have two arrays: the number of diagonals and their
+      // sorted offsets, followed by a sentinel
+      taco_iassert(i == 1 && order == 2 &&
+                   format.getModeFormats()[0].getName() == Dense.getName())
+          << "Diagonal levels must be below a dense row level";
+      vector<int> offsets;
+      for (size_t n = 0; n < numCoordinates; n++) {
+        offsets.push_back((int)coordinates[1][n].getAsIndex() -
+                          (int)coordinates[0][n].getAsIndex());
+      }
+      std::sort(offsets.begin(), offsets.end());
+      offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+      indices.push_back({TypedIndexVector(Int32),
+                         TypedIndexVector(format.getCoordinateTypeIdx(i))});
+      indices[i][0].push_back((int)offsets.size());
+      indices[i][1].push_back_vector(offsets);
+      indices[i][1].push_back(INT_MAX);
+      maxSize = (long long int)dimensions[0] * offsets.size();
     } else {
       taco_not_supported_yet;
     }
   }
 
+  const bool hasBitmap = (format.getModeFormats().back().getName() ==
+                          Bitmap.getName());
   void* vals = malloc(maxSize * componentType.getNumBytes());
   const void* fillData = storage.getFillValue().defined()? storage.getFillValue().getValPtr() : nullptr;
+  int valuesIndex = 0;
+  if (hasBitmap) {
+    if (fillData == nullptr) {
+      memset(vals, 0, componentType.getNumBytes());
+    } else {
+      memcpy(vals, fillData, componentType.getNumBytes());
+    }
+    valuesIndex = componentType.getNumBytes();
+  }
   int actual_size = packTensor(dimensions, coordinates, (char *) values, fillData, 0,
                                numCoordinates, format.getModeFormats(), 0,
-                               &indices, (char *)vals, componentType, 0);
+                               &indices, (char *)vals, componentType, valuesIndex);
   vals = realloc(vals, actual_size);
+  if (hasBitmap) {
+    indices[order - 1][0].push_back(actual_size / componentType.getNumBytes());
+  }
 
   // Create a tensor index
   vector<ModeIndex> modeIndices;
@@ -182,6 +344,22 @@ TensorStorage pack(Datatype                             componentType,
       Array idx = makeArray(format.getCoordinateTypeIdx(i), indices[i][1].size());
       memcpy(idx.getData(), indices[i][1].data(), indices[i][1].size() * format.getCoordinateTypeIdx(i).getNumBytes());
       modeIndices.push_back(ModeIndex({pos, idx}));
+    } else if (modeType.getName() == Hashed.getName()) {
+      Array width = makeArray({(int)indices[i][0][0].getAsIndex()});
+      Array idx = makeArray(format.getCoordinateTypeIdx(i), indices[i][1].size());
+      memcpy(idx.getData(), indices[i][1].data(), indices[i][1].size() * format.getCoordinateTypeIdx(i).getNumBytes());
+      modeIndices.push_back(ModeIndex({width, idx}));
+    } else if (modeType.getName() == Bitmap.getName()) {
+      Array rank = makeArray(format.getCoordinateTypePos(i), indices[i][0].size());
+      memcpy(rank.getData(), indices[i][0].data(), indices[i][0].size() * format.getCoordinateTypePos(i).getNumBytes());
+      Array bits = makeArray(UInt64, indices[i][1].size());
+      memcpy(bits.getData(), indices[i][1].data(), indices[i][1].size() * UInt64.getNumBytes());
+      modeIndices.push_back(ModeIndex({rank, bits}));
+    } else if (modeType.getName() == Diagonal.getName()) {
+      Array num = makeArray({(int)indices[i][0][0].getAsIndex()});
+      Array offsets = makeArray(format.getCoordinateTypeIdx(i), indices[i][1].size());
+      memcpy(offsets.getData(), indices[i][1].data(), indices[i][1].size() * format.getCoordinateTypeIdx(i).getNumBytes());
+      modeIndices.push_back(ModeIndex({num, offsets}));
     } else {
       taco_not_supported_yet;
     }
@@ -195,4 +373,390 @@ TensorStorage pack(Datatype                             componentType,
   return storage;
 }
 
+
+namespace {
+
+/// Number of chunks that the parallel passes over the components are split
+/// into; each chunk is processed by one thread.
+int getNumSortChunks(size_t numCoordinates) {
+#if USE_OPENMP
+  const size_t minChunkSize = 1 << 16;
+  size_t numChunks = std::min((size_t)omp_get_max_threads(),
+                              numCoordinates / minChunkSize);
+#else
+  size_t numChunks = 1;
+#endif
+  return (int)std::max(numChunks, (size_t)1);
+}
+
+/// Stable LSD radix sort of `keys` that applies the same permutation to
+/// `order`. Only the low `keyBits` bits of the keys are examined. Each pass
+/// builds per-chunk digit histograms in parallel, turns them into scatter
+/// offsets, and then scatters the chunks in parallel.
+template <typename Index>
+void radixSort(vector<uint64_t>& keys, vector<Index>& order, int keyBits) {
+  const int radixBits = 8;
+  const size_t numBuckets = size_t(1) << radixBits;
+  const size_t n = keys.size();
+  const int numChunks = getNumSortChunks(n);
+  const size_t chunkSize = (n + numChunks - 1) / numChunks;
+
+  vector<uint64_t> sortedKeys(n);
+  vector<Index> sortedOrder(n);
+  vector<size_t> offsets(numChunks * numBuckets);
+  for (int shift = 0; shift < keyBits; shift += radixBits) {
+    std::fill(offsets.begin(), offsets.end(), 0);
+    TACO_PARALLEL_FOR
+    for (int chunk = 0; chunk < numChunks; chunk++) {
+      size_t* histogram = &offsets[chunk * numBuckets];
+      const size_t end = std::min(n, (chunk + 1) * chunkSize);
+      for (size_t i = chunk * chunkSize; i < end; i++) {
+        histogram[(keys[i] >> shift) & (numBuckets - 1)]++;
+      }
+    }
+
+    // Skip the pass if every key has the same digit.
+    bool isSorted = false;
+    size_t offset = 0;
+    for (size_t bucket = 0; bucket < numBuckets; bucket++) {
+      size_t bucketSize = 0;
+      for (int chunk = 0; chunk < numChunks; chunk++) {
+        size_t& chunkOffset = offsets[chunk * numBuckets + bucket];
+        const size_t count = chunkOffset;
+        chunkOffset = offset;
+        offset += count;
+        bucketSize += count;
+      }
+      isSorted = isSorted || bucketSize == n;
+    }
+    if (isSorted) {
+      continue;
+    }
+
+    TACO_PARALLEL_FOR
+    for (int chunk = 0; chunk < numChunks; chunk++) {
+      size_t* chunkOffsets = &offsets[chunk * numBuckets];
+      const size_t end = std::min(n, (chunk + 1) * chunkSize);
+      for (size_t i = chunk * chunkSize; i < end; i++) {
+        const size_t pos = chunkOffsets[(keys[i] >> shift) & (numBuckets - 1)]++;
+        sortedKeys[pos] = keys[i];
+        sortedOrder[pos] = order[i];
+      }
+    }
+    keys.swap(sortedKeys);
+    order.swap(sortedOrder);
+  }
+}
+
+template <typename Index>
+void sortAndScatter(const char* buffer, size_t numCoordinates, int csize,
+                    const vector<int>& dimensions,
+                    const vector<int>& permutation,
+                    vector<vector<int>>& coordinates, char* values) {
+  const int order = (int)permutation.size();
+  const size_t coordSize = order * sizeof(int) + csize;
+  auto getCoordinate = [&](Index component, int level) {
+    const char* record = &buffer[component * coordSize];
+    return ((const int*)record)[permutation[level]];
+  };
+
+  // Linearize the coordinates in storage order if they fit in 64 bits.
+  int keyBits = 0;
+  bool fitsInKey = true;
+  uint64_t numKeys = 1;
+  for (int level = 0; level < order; level++) {
+    const uint64_t dimension = std::max(dimensions[permutation[level]], 1);
+    if (numKeys > UINT64_MAX / dimension) {
+      fitsInKey = false;
+      break;
+    }
+    numKeys *= dimension;
+  }
+  while (fitsInKey && keyBits < 64 && (numKeys - 1) >> keyBits) {
+    keyBits++;
+  }
+
+  vector<Index> sortedOrder(numCoordinates);
+  TACO_PARALLEL_FOR
+  for (size_t i = 0; i < numCoordinates; i++) {
+    sortedOrder[i] = (Index)i;
+  }
+  if (fitsInKey) {
+    // Together with the scratch arrays of radixSort, this costs 2 keys and 2
+    // indices of scratch memory per component.
+    vector<uint64_t> keys(numCoordinates);
+    TACO_PARALLEL_FOR
+    for (size_t i = 0; i < numCoordinates; i++) {
+      uint64_t key = 0;
+      for (int level = 0; level < order; level++) {
+        key = key * dimensions[permutation[level]] + getCoordinate((Index)i, level);
+      }
+      keys[i] = key;
+    }
+    radixSort(keys, sortedOrder, keyBits);
+  } else {
+    std::stable_sort(sortedOrder.begin(), sortedOrder.end(),
+                     [&](Index a, Index b) {
+      for (int level = 0; level < order; level++) {
+        const int diff = getCoordinate(a, level) - getCoordinate(b, level);
+        if (diff != 0) {
+          return diff < 0;
+        }
+      }
+      return false;
+    });
+  }
+
+  for (int level = 0; level < order; level++) {
+    coordinates[level].resize(numCoordinates);
+  }
+  TACO_PARALLEL_FOR
+  for (size_t i = 0; i < numCoordinates; i++) {
+    const Index component = sortedOrder[i];
+    for (int level = 0; level < order; level++) {
+      coordinates[level][i] = getCoordinate(component, level);
+    }
+    memcpy(&values[i * csize], &buffer[component * coordSize + order * sizeof(int)],
+           csize);
+  }
+}
+
+}
+
+void sortCoordinates(const char* buffer, size_t numCoordinates, int csize,
+                     const vector<int>& dimensions,
+                     const vector<int>& permutation,
+                     vector<vector<int>>& coordinates, char* values) {
+  taco_iassert(coordinates.size() == permutation.size());
+  if (numCoordinates <= UINT32_MAX) {
+    sortAndScatter<uint32_t>(buffer, numCoordinates, csize, dimensions,
+                             permutation, coordinates, values);
+  } else {
+    sortAndScatter<uint64_t>(buffer, numCoordinates, csize, dimensions,
+                             permutation, coordinates, values);
+  }
+}
+
+void mergeCoordinates(const vector<vector<int>>& aCoordinates,
+                      const char* aValues,
+                      const vector<vector<int>>& bCoordinates,
+                      const char* bValues, int csize,
+                      vector<vector<int>>& coordinates, char* values) {
+  taco_iassert(aCoordinates.size() == bCoordinates.size());
+  const size_t order = aCoordinates.size();
+  taco_iassert(order > 0);
+  const size_t aSize = aCoordinates[0].size();
+  const size_t bSize = bCoordinates[0].size();
+
+  // Compares component a to component b, returning true if a must be placed
+  // before b. Ties go to a.
+  auto aFirst = [&](size_t a, size_t b) {
+    for (size_t level = 0; level < order; level++) {
+      const int aCoord = aCoordinates[level][a];
+      const int bCoord = bCoordinates[level][b];
+      if (aCoord != bCoord) {
+        return aCoord < bCoord;
+      }
+    }
+    return true;
+  };
+
+  coordinates.assign(order, vector<int>(aSize + bSize));
+  size_t a = 0, b = 0;
+  for (size_t i = 0; i < aSize + bSize; i++) {
+    if (b == bSize || (a < aSize && aFirst(a, b))) {
+      for (size_t level = 0; level < order; level++) {
+        coordinates[level][i] = aCoordinates[level][a];
+      }
+      memcpy(&values[i * csize], &aValues[a * csize], csize);
+      a++;
+    } else {
+      for (size_t level = 0; level < order; level++) {
+        coordinates[level][i] = bCoordinates[level][b];
+      }
+      memcpy(&values[i * csize], &bValues[b * csize], csize);
+      b++;
+    }
+  }
+}
+
+bool canSpliceCoordinates(const Format& format) {
+  if (format.getOrder() == 0) {
+    return false;
+  }
+  for (int i = 0; i < format.getOrder(); i++) {
+    const ModeFormat modeFormat = format.getModeFormats()[i];
+    if (modeFormat.getName() == Sparse.getName()) {
+      if (!modeFormat.isOrdered() || !modeFormat.isUnique() ||
+          format.getCoordinateTypePos(i) != Int32 ||
+          format.getCoordinateTypeIdx(i) != Int32) {
+        return false;
+      }
+    } else if (modeFormat.getName() != Dense.getName()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+namespace {
+
+/// Merges new components into packed dense and compressed levels, appending
+/// the merged levels and values to output arrays in storage order.
+template <typename T>
+class CoordinateSplicer {
+public:
+  CoordinateSplicer(TensorStorage storage,
+                    const vector<vector<int>>& coordinates, const char* values)
+      : coordinates(coordinates), values((const T*)values),
+        packedValues((const T*)storage.getValues().getData()),
+        fill(T()), order(storage.getOrder()), dimensions(order),
+        packedPos(order), packedCrd(order), pos(order), crd(order) {
+    const Index& index = storage.getIndex();
+    for (int i = 0; i < order; i++) {
+      const ModeIndex& modeIndex = index.getModeIndex(i);
+      if (storage.getFormat().getModeFormats()[i].getName() == Dense.getName()) {
+        dimensions[i] = (int)modeIndex.getIndexArray(0).get(0).getAsIndex();
+      } else {
+        packedPos[i] = (const int*)modeIndex.getIndexArray(0).getData();
+        packedCrd[i] = (const int*)modeIndex.getIndexArray(1).getData();
+        pos[i].push_back(0);
+      }
+    }
+    if (storage.getFillValue().defined()) {
+      fill = *(const T*)storage.getFillValue().getValPtr();
+    }
+  }
+
+  /// Splice the new components [begin,end), whose coordinates above `level`
+  /// are those of the packed position `packed` (or of a position that is not
+  /// packed if `packed` is negative).
+  void splice(int level, int64_t packed, size_t begin, size_t end) {
+    if (level == order) {
+      T value = (packed >= 0) ? packedValues[packed]
+                              : (begin < end) ? values[begin++] : fill;
+      for (size_t k = begin; k < end; k++) {
+        value = (T)(value + values[k]);
+      }
+      const char* valueBytes = (const char*)&value;
+      vals.insert(vals.end(), valueBytes, valueBytes + sizeof(T));
+      return;
+    }
+
+    const vector<int>& levelCoordinates = coordinates[level];
+    if (packedPos[level] == nullptr) {
+      const int64_t dimension = dimensions[level];
+      for (int64_t i = 0; i < dimension; i++) {
+        size_t childEnd = begin;
+        while (childEnd < end && levelCoordinates[childEnd] == i) {
+          childEnd++;
+        }
+        splice(level + 1, (packed >= 0) ? packed * dimension + i : -1,
+               begin, childEnd);
+        begin = childEnd;
+      }
+      return;
+    }
+
+    int64_t k = (packed >= 0) ? packedPos[level][packed] : 0;
+    const int64_t kEnd = (packed >= 0) ? packedPos[level][packed + 1] : 0;
+    while (k < kEnd || begin < end) {
+      const int packedCoord = (k < kEnd) ? packedCrd[level][k] : INT_MAX;
+      const int newCoord = (begin < end) ? levelCoordinates[begin] : INT_MAX;
+      const int coord = std::min(packedCoord, newCoord);
+      size_t childEnd = begin;
+      while (childEnd < end && levelCoordinates[childEnd] == coord) {
+        childEnd++;
+      }
+      crd[level].push_back(coord);
+      splice(level + 1, (packedCoord == coord) ? k++ : -1, begin, childEnd);
+      begin = childEnd;
+    }
+    pos[level].push_back((int)crd[level].size());
+  }
+
+  /// Replace the index and values of `storage` by the spliced levels.
+  size_t setStorage(TensorStorage& storage) {
+    const Index& index = storage.getIndex();
+    vector<ModeIndex> modeIndices;
+    for (int i = 0; i < order; i++) {
+      if (packedPos[i] == nullptr) {
+        modeIndices.push_back(index.getModeIndex(i));
+      } else {
+        modeIndices.push_back(ModeIndex({makeArray(pos[i]), makeArray(crd[i])}));
+      }
+    }
+    storage.setIndex(Index(storage.getFormat(), modeIndices));
+    const size_t numVals = vals.size() / sizeof(T);
+    Array array = makeArray(type<T>(), numVals);
+    memcpy(array.getData(), vals.data(), vals.size());
+    storage.setValues(array);
+    return numVals;
+  }
+
+private:
+  const vector<vector<int>>& coordinates;
+  const T* values;
+  const T* packedValues;
+  T fill;
+  int order;
+
+  vector<int> dimensions;
+  vector<const int*> packedPos;
+  vector<const int*> packedCrd;
+
+  vector<vector<int>> pos;
+  vector<vector<int>> crd;
+  vector<char> vals;
+};
+
+template <typename T>
+size_t spliceCoordinates(TensorStorage& storage,
+                         const vector<vector<int>>& coordinates,
+                         const char* values, size_t numCoordinates) {
+  CoordinateSplicer<T> splicer(storage, coordinates, values);
+  splicer.splice(0, 0, 0, numCoordinates);
+  return splicer.setStorage(storage);
+}
+
+}
+
+size_t spliceCoordinates(TensorStorage& storage,
+                         const vector<vector<int>>& coordinates,
+                         const char* values, size_t numCoordinates) {
+  taco_iassert(canSpliceCoordinates(storage.getFormat()));
+  taco_iassert((int)coordinates.size() == storage.getOrder());
+  switch (storage.getComponentType().getKind()) {
+    case Datatype::Bool:
+      return spliceCoordinates<bool>(storage, coordinates, values, numCoordinates);
+    case Datatype::UInt8:
+      return spliceCoordinates<uint8_t>(storage, coordinates, values, numCoordinates);
+    case Datatype::UInt16:
+      return spliceCoordinates<uint16_t>(storage, coordinates, values, numCoordinates);
+    case Datatype::UInt32:
+      return spliceCoordinates<uint32_t>(storage, coordinates, values, numCoordinates);
+    case Datatype::UInt64:
+      return spliceCoordinates<uint64_t>(storage, coordinates, values, numCoordinates);
+    case Datatype::Int8:
+      return spliceCoordinates<int8_t>(storage, coordinates, values, numCoordinates);
+    case Datatype::Int16:
+      return spliceCoordinates<int16_t>(storage, coordinates, values, numCoordinates);
+    case Datatype::Int32:
+      return spliceCoordinates<int32_t>(storage, coordinates, values, numCoordinates);
+    case Datatype::Int64:
+      return spliceCoordinates<int64_t>(storage, coordinates, values, numCoordinates);
+    case Datatype::Float32:
+      return spliceCoordinates<float>(storage, coordinates, values, numCoordinates);
+    case Datatype::Float64:
+      return spliceCoordinates<double>(storage, coordinates, values, numCoordinates);
+    case Datatype::Complex64:
+      return spliceCoordinates<std::complex<float>>(storage, coordinates, values, numCoordinates);
+    case Datatype::Complex128:
+      return spliceCoordinates<std::complex<double>>(storage, coordinates, values, numCoordinates);
+    default:
+      taco_ierror << "unsupported type";
+      return 0;
+  }
+}
+
 }
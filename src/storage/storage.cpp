@@ -52,6 +52,14 @@ struct TensorStorage::Content {
         modeTypes[i] = taco_mode_sparse;
       } else if (modeType.getName() == Singleton.getName()) {
         modeTypes[i] = taco_mode_sparse;
+      } else if (modeType.getName() == Hashed.getName()) {
+        modeTypes[i] = taco_mode_sparse;
+      } else if (modeType.getName() == Bitmap.getName()) {
+        modeTypes[i] = taco_mode_sparse;
+      } else if (modeType.getName() == Diagonal.getName()) {
+        modeTypes[i] = taco_mode_sparse;
+      } else if (modeType.getName() == Ell.getName()) {
+        modeTypes[i] = taco_mode_sparse;
       } else {
         taco_not_supported_yet;
       }
@@ -165,6 +173,42 @@ TensorStorage::operator struct taco_tensor_t*() const {
         tensorData->indices[i][1] = (uint8_t*)idx.getData();
       }
     }
+    // Hashed levels have two indices (width and idx)
+    else if (modeType.getName() == Hashed.getName()) {
+      if (modeIndex.numIndexArrays() > 0) {
+        const Array& width = modeIndex.getIndexArray(0);
+        const Array& idx = modeIndex.getIndexArray(1);
+        tensorData->indices[i][0] = (uint8_t*)width.getData();
+        tensorData->indices[i][1] = (uint8_t*)idx.getData();
+      }
+    }
+    // Bitmap levels have two indices (rank and bits)
+    else if (modeType.getName() == Bitmap.getName()) {
+      if (modeIndex.numIndexArrays() > 0) {
+        const Array& rank = modeIndex.getIndexArray(0);
+        const Array& bits = modeIndex.getIndexArray(1);
+        tensorData->indices[i][0] = (uint8_t*)rank.getData();
+        tensorData->indices[i][1] = (uint8_t*)bits.getData();
+      }
+    }
+    // Diagonal levels have two indices (number of diagonals and offsets)
+    else if (modeType.getName() == Diagonal.getName()) {
+      if (modeIndex.numIndexArrays() > 0) {
+        const Array& num = modeIndex.getIndexArray(0);
+        const Array& offsets = modeIndex.getIndexArray(1);
+        tensorData->indices[i][0] = (uint8_t*)num.getData();
+        tensorData->indices[i][1] = (uint8_t*)offsets.getData();
+      }
+    }
+    // Ell levels have two indices (row bounds and padded coordinates)
+    else if (modeType.getName() == Ell.getName()) {
+      if (modeIndex.numIndexArrays() > 0) {
+        const Array& pos = modeIndex.getIndexArray(0);
+        const Array& idx = modeIndex.getIndexArray(1);
+        tensorData->indices[i][0] = (uint8_t*)pos.getData();
+        tensorData->indices[i][1] = (uint8_t*)idx.getData();
+      }
+    }
     else {
       taco_not_supported_yet;
     }
@@ -0,0 +1,305 @@
+#include "taco/streaming.h"
+
+#include <fstream>
+#include <future>
+
+#include "taco/tensor.h"
+#include "taco/error.h"
+#include "taco/index_notation/index_notation.h"
+#include "taco/index_notation/kernel.h"
+#include "taco/index_notation/transformations.h"
+#include "taco/storage/storage.h"
+#include "taco/storage/index.h"
+#include "taco/storage/array.h"
+#include "taco/storage/file_io_taco.h"
+#include "taco/util/files.h"
+#include "taco/util/strings.h"
+
+using namespace std;
+
+namespace taco {
+
+static string manifestPath(const string& directory) {
+  return directory + "/manifest";
+}
+
+static string chunkPath(const string& directory, int chunk) {
+  return directory + "/chunk" + to_string(chunk) + ".taco";
+}
+
+// class ChunkedTensor
+ChunkedTensor::ChunkedTensor(string directory) : directory(directory) {
+  fstream manifest;
+  util::openStream(manifest, manifestPath(directory), fstream::in);
+  string magic;
+  size_t order, numChunks;
+  manifest >> magic >> order;
+  taco_uassert(manifest && magic == "taco-chunked")
+      << "Not a chunked tensor: " << directory;
+  dimensions.resize(order);
+  for (auto& dimension : dimensions) {
+    manifest >> dimension;
+  }
+  manifest >> numChunks;
+  chunkBegins.resize(numChunks + 1);
+  for (auto& begin : chunkBegins) {
+    manifest >> begin;
+  }
+  taco_uassert(manifest && numChunks > 0)
+      << "Corrupt chunked tensor manifest: " << directory;
+
+  TensorBase first = readTACO(chunkPath(directory, 0));
+  format = first.getFormat();
+  componentType = first.getComponentType();
+}
+
+const vector<int>& ChunkedTensor::getDimensions() const {
+  return dimensions;
+}
+
+int ChunkedTensor::getOrder() const {
+  return (int)dimensions.size();
+}
+
+const Format& ChunkedTensor::getFormat() const {
+  return format;
+}
+
+Datatype ChunkedTensor::getComponentType() const {
+  return componentType;
+}
+
+int ChunkedTensor::getNumChunks() const {
+  return (int)chunkBegins.size() - 1;
+}
+
+int ChunkedTensor::getChunkBegin(int chunk) const {
+  taco_uassert(chunk >= 0 && chunk < getNumChunks()) << "Invalid chunk";
+  return chunkBegins[chunk];
+}
+
+int ChunkedTensor::getChunkEnd(int chunk) const {
+  taco_uassert(chunk >= 0 && chunk < getNumChunks()) << "Invalid chunk";
+  return chunkBegins[chunk + 1];
+}
+
+/// Touch every page of an array so that it is read in from disk.
+static void prefetch(const Array& array) {
+  const size_t pageSize = 4096;
+  const char* data = (const char*)array.getData();
+  const size_t numBytes = array.getSize() * array.getType().getNumBytes();
+  volatile char sink = 0;
+  for (size_t i = 0; i < numBytes; i += pageSize) {
+    sink ^= data[i];
+  }
+  (void)sink;
+}
+
+TensorBase ChunkedTensor::readChunk(int chunk) const {
+  taco_uassert(chunk >= 0 && chunk < getNumChunks()) << "Invalid chunk";
+  TensorBase tensor = readTACO(chunkPath(directory, chunk));
+  const TensorStorage& storage = tensor.getStorage();
+  const Index& index = storage.getIndex();
+  for (int i = 0; i < index.numModeIndices(); i++) {
+    const ModeIndex& modeIndex = index.getModeIndex(i);
+    for (int j = 0; j < modeIndex.numIndexArrays(); j++) {
+      prefetch(modeIndex.getIndexArray(j));
+    }
+  }
+  prefetch(storage.getValues());
+  return tensor;
+}
+
+template <typename T>
+static void writeChunksTyped(const string& directory, const TensorBase& tensor,
+                             const vector<int>& chunkBegins) {
+  const int numChunks = (int)chunkBegins.size() - 1;
+  const Literal fill = TensorStorage(tensor.getStorage()).getFillValue();
+  vector<int> chunkDimensions = tensor.getDimensions();
+  auto newChunk = [&](int chunk) {
+    chunkDimensions[0] = chunkBegins[chunk + 1] - chunkBegins[chunk];
+    return TensorBase(tensor.getComponentType(), chunkDimensions,
+                      tensor.getFormat(), fill);
+  };
+  auto flush = [&](TensorBase& chunkTensor, int chunk) {
+    chunkTensor.pack();
+    writeTACO(chunkPath(directory, chunk), chunkTensor);
+  };
+
+  // Components are iterated row by row since rows are stored outermost
+  int chunk = 0;
+  TensorBase chunkTensor = newChunk(chunk);
+  for (auto& component : iterate<T>(tensor)) {
+    vector<int> coordinate = component.first.toVector();
+    while (coordinate[0] >= chunkBegins[chunk + 1]) {
+      flush(chunkTensor, chunk++);
+      chunkTensor = newChunk(chunk);
+    }
+    coordinate[0] -= chunkBegins[chunk];
+    chunkTensor.insert(coordinate, component.second);
+  }
+  flush(chunkTensor, chunk);
+  while (++chunk < numChunks) {
+    chunkTensor = newChunk(chunk);
+    flush(chunkTensor, chunk);
+  }
+}
+
+ChunkedTensor writeChunked(string directory, const TensorBase& tensor,
+                           int rowsPerChunk) {
+  taco_uassert(tensor.getOrder() > 0) << "Cannot chunk a scalar";
+  taco_uassert(rowsPerChunk > 0) << "Chunks must hold at least one row";
+  taco_uassert(tensor.getFormat().getModeOrdering()[0] == 0)
+      << "Chunked tensors must store their rows outermost";
+
+  // A tensor without rows is written as one empty chunk, so that every
+  // chunked tensor has a chunk to take its format from
+  const int numRows = tensor.getDimensions()[0];
+  vector<int> chunkBegins = {0};
+  for (int begin = rowsPerChunk; begin < numRows; begin += rowsPerChunk) {
+    chunkBegins.push_back(begin);
+  }
+  chunkBegins.push_back(numRows);
+
+  switch (tensor.getComponentType().getKind()) {
+    case Datatype::Bool: writeChunksTyped<bool>(directory, tensor, chunkBegins); break;
+    case Datatype::UInt8: writeChunksTyped<uint8_t>(directory, tensor, chunkBegins); break;
+    case Datatype::UInt16: writeChunksTyped<uint16_t>(directory, tensor, chunkBegins); break;
+    case Datatype::UInt32: writeChunksTyped<uint32_t>(directory, tensor, chunkBegins); break;
+    case Datatype::UInt64: writeChunksTyped<uint64_t>(directory, tensor, chunkBegins); break;
+    case Datatype::Int8: writeChunksTyped<int8_t>(directory, tensor, chunkBegins); break;
+    case Datatype::Int16: writeChunksTyped<int16_t>(directory, tensor, chunkBegins); break;
+    case Datatype::Int32: writeChunksTyped<int32_t>(directory, tensor, chunkBegins); break;
+    case Datatype::Int64: writeChunksTyped<int64_t>(directory, tensor, chunkBegins); break;
+    case Datatype::Float32: writeChunksTyped<float>(directory, tensor, chunkBegins); break;
+    case Datatype::Float64: writeChunksTyped<double>(directory, tensor, chunkBegins); break;
+    case Datatype::Complex64: writeChunksTyped<std::complex<float>>(directory, tensor, chunkBegins); break;
+    case Datatype::Complex128: writeChunksTyped<std::complex<double>>(directory, tensor, chunkBegins); break;
+    default:
+      taco_not_supported_yet;
+  }
+
+  fstream manifest;
+  util::openStream(manifest, manifestPath(directory), fstream::out);
+  manifest << "taco-chunked" << endl;
+  manifest << tensor.getOrder() << " " << util::join(tensor.getDimensions(), " ")
+           << endl;
+  manifest << chunkBegins.size() - 1 << " " << util::join(chunkBegins, " ")
+           << endl;
+  manifest.close();
+  return ChunkedTensor(directory);
+}
+
+/// Returns dense tensor storage over the rows [begin, end) of `storage`, which
+/// must be dense with the default mode ordering. The view aliases the values
+/// of `storage`.
+static TensorStorage rowView(TensorStorage storage, int begin, int end) {
+  vector<int> dimensions = storage.getDimensions();
+  size_t rowSize = 1;
+  for (size_t i = 1; i < dimensions.size(); i++) {
+    rowSize *= dimensions[i];
+  }
+  dimensions[0] = end - begin;
+
+  TensorStorage view(storage.getComponentType(), dimensions,
+                     storage.getFormat(), storage.getFillValue());
+  vector<ModeIndex> modeIndices;
+  for (int dimension : dimensions) {
+    modeIndices.push_back(ModeIndex({makeArray({dimension})}));
+  }
+  view.setIndex(Index(storage.getFormat(), modeIndices));
+  const Datatype type = storage.getComponentType();
+  char* values = (char*)storage.getValues().getData();
+  view.setValues(Array(type, values + begin * rowSize * type.getNumBytes(),
+                       (end - begin) * rowSize, Array::UserOwns));
+  return view;
+}
+
+void multiplyChunked(TensorBase& result, const ChunkedTensor& A,
+                     const TensorBase& B) {
+  const Datatype type = A.getComponentType();
+  taco_uassert(A.getOrder() >= 2) << "The chunked operand must have order >= 2";
+  taco_uassert(B.getOrder() >= 1) << "The second operand must not be a scalar";
+  taco_uassert(B.getDimensions()[0] == A.getDimensions().back())
+      << "The last mode of A must match the first mode of B";
+  taco_uassert(B.getComponentType() == type &&
+               result.getComponentType() == type)
+      << "The operands and result must have the same component type";
+
+  vector<int> resultDimensions(A.getDimensions().begin(),
+                               A.getDimensions().end() - 1);
+  resultDimensions.insert(resultDimensions.end(), B.getDimensions().begin() + 1,
+                          B.getDimensions().end());
+  taco_uassert(result.getDimensions() == resultDimensions)
+      << "The result dimensions must be " << util::join(resultDimensions, "x");
+  taco_uassert(isDense(result.getFormat()) &&
+               result.getFormat().getModeOrdering() ==
+               Format(vector<ModeFormatPack>(result.getOrder(), Dense))
+                   .getModeOrdering())
+      << "The result must be dense with the default mode ordering";
+
+  // Build and compile the kernel once. The row dimension of the chunk and
+  // result view variables is unknown, so the kernel works for any chunk.
+  vector<IndexVar> aVars(A.getOrder());
+  vector<IndexVar> bVars = {aVars.back()};
+  for (int i = 1; i < B.getOrder(); i++) {
+    bVars.push_back(IndexVar());
+  }
+  vector<IndexVar> resultVars(aVars.begin(), aVars.end() - 1);
+  resultVars.insert(resultVars.end(), bVars.begin() + 1, bVars.end());
+
+  auto rowChunkShape = [](const vector<int>& dimensions) {
+    vector<Dimension> shape = {Dimension()};
+    for (size_t i = 1; i < dimensions.size(); i++) {
+      shape.push_back(Dimension(dimensions[i]));
+    }
+    return Shape(shape);
+  };
+  TensorVar chunkVar(Type(type, rowChunkShape(A.getDimensions())),
+                     A.getFormat());
+  TensorVar viewVar(Type(type, rowChunkShape(resultDimensions)),
+                    result.getFormat());
+  TensorVar operandVar = B.getTensorVar();
+  IndexStmt stmt = makeConcreteNotation(makeReductionNotation(
+      Assignment(viewVar(resultVars), chunkVar(aVars) * operandVar(bVars))));
+  stmt = reorderLoopsTopologically(stmt);
+  stmt = insertTemporaries(stmt);
+  Kernel kernel = compile(stmt);
+
+  TensorBase operand = B;
+  operand.pack();
+
+  // Allocate the (zeroed) result
+  TensorStorage storage = result.getStorage();
+  vector<ModeIndex> modeIndices;
+  size_t size = 1;
+  for (int dimension : resultDimensions) {
+    modeIndices.push_back(ModeIndex({makeArray({dimension})}));
+    size *= dimension;
+  }
+  storage.setIndex(Index(result.getFormat(), modeIndices));
+  Array values = makeArray(type, size);
+  values.zero();
+  storage.setValues(values);
+  result.setStorage(storage);
+
+  // Compute chunk by chunk, loading the next chunk while computing this one
+  auto load = [&A](int chunk) {return A.readChunk(chunk);};
+  future<TensorBase> next = async(launch::async, load, 0);
+  for (int chunk = 0; chunk < A.getNumChunks(); chunk++) {
+    TensorBase chunkTensor = next.get();
+    if (chunk + 1 < A.getNumChunks()) {
+      next = async(launch::async, load, chunk + 1);
+    }
+
+    vector<TensorStorage> arguments = {rowView(storage, A.getChunkBegin(chunk),
+                                               A.getChunkEnd(chunk))};
+    for (auto& argument : getArguments(stmt)) {
+      arguments.push_back((argument == chunkVar) ? chunkTensor.getStorage()
+                                                 : operand.getStorage());
+    }
+    taco_uassert(kernel.compute(arguments)) << "Error computing chunk " << chunk;
+  }
+}
+
+}
@@ -1,5 +1,6 @@
 #include "taco/tensor.h"
 
+#include <algorithm>
 #include <set>
 #include <cstring>
 #include <fstream>
@@ -9,6 +10,10 @@
 #include <vector>
 #include <utility>
 #include <mutex>
+#include <atomic>
+#include <array>
+#include <unordered_map>
+#include <shared_mutex>
 
 #include "taco/cuda.h"
 #include "taco/format.h"
@@ -25,17 +30,22 @@
 #include "taco/ir/ir.h"
 #include "taco/ir/ir_printer.h"
 #include "taco/lower/lower.h"
+#include "taco/lower/mode_format_bitmap.h"
+#include "taco/lower/mode_format_ell.h"
 #include "taco/storage/storage.h"
 #include "taco/storage/index.h"
 #include "taco/storage/array.h"
+#include "taco/storage/convert.h"
 #include "taco/storage/pack.h"
 #include "taco/storage/file_io_tns.h"
 #include "taco/storage/file_io_mtx.h"
 #include "taco/storage/file_io_rb.h"
+#include "taco/storage/file_io_taco.h"
 #include "taco/storage/typed_vector.h"
 #include "taco/util/collections.h"
 #include "taco/util/strings.h"
 #include "taco/util/timers.h"
+#include "taco/util/thread_pool.h"
 #include "taco/util/name_generator.h"
 
 #include "codegen/codegen_c.h"
@@ -99,6 +109,16 @@ static Format initFormat(Format format) {
       } else if (modeType.getName() == Singleton.getName()) {
         arrayTypes.push_back(Int32);
         arrayTypes.push_back(Int32);
+      } else if (modeType.getName() == Hashed.getName()) {
+        arrayTypes.push_back(Int32);
+        arrayTypes.push_back(Int32);
+      } else if (modeType.getName() == Bitmap.getName()) {
+        arrayTypes.push_back(Int32);
+        arrayTypes.push_back(UInt64);
+      } else if (modeType.getName() == Diagonal.getName() ||
+                 modeType.getName() == Ell.getName()) {
+        arrayTypes.push_back(Int32);
+        arrayTypes.push_back(Int32);
       } else {
         taco_not_supported_yet;
       }
@@ -106,9 +126,47 @@ static Format initFormat(Format format) {
     }
     format.setLevelArrayTypes(levelArrayTypes);
   }
+  for (int i = 0; i < format.getOrder() - 1; ++i) {
+    taco_uassert(format.getModeFormats()[i].getName() != Bitmap.getName())
+        << "Bitmap levels must be the last level of a format";
+  }
+  for (int i = 0; i < format.getOrder(); ++i) {
+    const std::string name = format.getModeFormats()[i].getName();
+    taco_uassert((name != Diagonal.getName() && name != Ell.getName()) ||
+                 (format.getOrder() == 2 && i == 1 &&
+                  format.getModeFormats()[0].getName() == Dense.getName()))
+        << "Diagonal and ell levels must be the second level of a matrix "
+        << "format whose first level is dense";
+  }
   return format;
 }
 
+/// Bitmap, diagonal and ell levels cannot be assembled, so tensors are packed
+/// into a format where they are compressed levels instead, and converted by
+/// `unpackTensorData`.
+static Format getPackFormat(const Format& format) {
+  std::vector<ModeFormatPack> modeFormatPacks;
+  bool hasStaged = false;
+  for (const ModeFormatPack& modeFormatPack : format.getModeFormatPacks()) {
+    std::vector<ModeFormat> modeFormats;
+    for (const ModeFormat& modeFormat : modeFormatPack.getModeFormats()) {
+      if (modeFormat.getName() == Bitmap.getName() ||
+          modeFormat.getName() == Diagonal.getName() ||
+          modeFormat.getName() == Ell.getName()) {
+        modeFormats.push_back(Compressed);
+        hasStaged = true;
+      } else {
+        modeFormats.push_back(modeFormat);
+      }
+    }
+    modeFormatPacks.push_back(ModeFormatPack(modeFormats));
+  }
+  if (!hasStaged) {
+    return format;
+  }
+  return initFormat(Format(modeFormatPacks, format.getModeOrdering()));
+}
+
 TensorBase::TensorBase(string name, Datatype ctype, vector<int> dimensions,
                        Format format, Literal fill) {
 
@@ -172,6 +230,72 @@ void TensorBase::reserve(size_t numCoordinates) {
   content->coordinateBuffer->resize(newSize);
 }
 
+void TensorBase::insertComponents(Datatype ctype,
+                                  std::vector<char>&& components) {
+  taco_uassert(ctype == getComponentType()) <<
+    "Cannot insert values of type '" << ctype << "' " <<
+    "into a tensor with component type " << getComponentType();
+  taco_uassert(components.size() % content->coordinateSize == 0) <<
+      "Component buffer size is not a multiple of the component size";
+  syncDependentTensors();
+  if (content->coordinateBufferUsed == 0) {
+    *content->coordinateBuffer = std::move(components);
+    content->coordinateBufferUsed = content->coordinateBuffer->size();
+  } else {
+    const size_t newSize = content->coordinateBufferUsed + components.size();
+    if (content->coordinateBuffer->size() < newSize) {
+      content->coordinateBuffer->resize(newSize);
+    }
+    memcpy(&content->coordinateBuffer->data()[content->coordinateBufferUsed],
+           components.data(), components.size());
+    content->coordinateBufferUsed = newSize;
+  }
+  setNeedsPack(true);
+}
+
+template <typename T>
+static void copyComponents(const TensorBase& source, TensorBase& target) {
+  for (auto& component : iterate<T>(source)) {
+    target.insert(component.first.toVector(), component.second);
+  }
+}
+
+TensorBase TensorBase::convert(const Format& format) {
+  return convert(util::uniqueName('A'), format);
+}
+
+TensorBase TensorBase::convert(std::string name, const Format& format) {
+  syncValues();
+  TensorStorage storage = getStorage();
+  TensorBase result(name, getComponentType(), getDimensions(), format,
+                    storage.getFillValue());
+  if (isConvertible(getFormat(), result.getFormat())) {
+    result.setStorage(taco::convert(storage, result.getFormat()));
+    result.unsetNeverPacked();
+    return result;
+  }
+
+  switch (getComponentType().getKind()) {
+    case Datatype::Bool: copyComponents<bool>(*this, result); break;
+    case Datatype::UInt8: copyComponents<uint8_t>(*this, result); break;
+    case Datatype::UInt16: copyComponents<uint16_t>(*this, result); break;
+    case Datatype::UInt32: copyComponents<uint32_t>(*this, result); break;
+    case Datatype::UInt64: copyComponents<uint64_t>(*this, result); break;
+    case Datatype::Int8: copyComponents<int8_t>(*this, result); break;
+    case Datatype::Int16: copyComponents<int16_t>(*this, result); break;
+    case Datatype::Int32: copyComponents<int32_t>(*this, result); break;
+    case Datatype::Int64: copyComponents<int64_t>(*this, result); break;
+    case Datatype::Float32: copyComponents<float>(*this, result); break;
+    case Datatype::Float64: copyComponents<double>(*this, result); break;
+    case Datatype::Complex64: copyComponents<std::complex<float>>(*this, result); break;
+    case Datatype::Complex128: copyComponents<std::complex<double>>(*this, result); break;
+    default:
+      taco_not_supported_yet;
+  }
+  result.pack();
+  return result;
+}
+
 int TensorBase::getDimension(int mode) const {
   taco_uassert(mode < getOrder()) << "Invalid mode";
   return content->dimensions[mode];
@@ -249,15 +373,27 @@ void TensorBase::setAssembleWhileCompute(bool assembleWhileCompute) {
   content->assembleWhileCompute = assembleWhileCompute;
 }
 
-static size_t numIntegersToCompare = 0;
-static int lexicographicalCmp(const void* a, const void* b) {
-  for (size_t i = 0; i < numIntegersToCompare; i++) {
-    int diff = ((int*)a)[i] - ((int*)b)[i];
-    if (diff != 0) {
-      return diff;
+/// Copy the index values in `values` into an index array.
+static Array makeIndexArray(const TypedIndexVector& values) {
+  Array array = makeArray(values.getType(), values.size());
+  memcpy(array.getData(), values.data(),
+         values.size() * values.getType().getNumBytes());
+  return array;
+}
+
+/// Returns an array of `size` values that all hold the fill value of `storage`.
+static Array makeFillArray(TensorStorage storage, size_t size) {
+  const size_t csize = storage.getComponentType().getNumBytes();
+  Array vals = makeArray(storage.getComponentType(), size);
+  Literal fill = storage.getFillValue();
+  for (size_t p = 0; p < size; p++) {
+    if (fill.defined()) {
+      memcpy((char*)vals.getData() + p * csize, fill.getValPtr(), csize);
+    } else {
+      memset((char*)vals.getData() + p * csize, 0, csize);
     }
   }
-  return 0;
+  return vals;
 }
 
 static size_t unpackTensorData(const taco_tensor_t& tensorData,
@@ -266,6 +402,7 @@ static size_t unpackTensorData(const taco_tensor_t& tensorData,
   auto format = storage.getFormat();
 
   vector<ModeIndex> modeIndices;
+  Array scatteredVals;
   size_t numVals = 1;
   for (int i = 0; i < tensor.getOrder(); i++) {
     ModeFormat modeType = format.getModeFormats()[i];
@@ -274,23 +411,197 @@ static size_t unpackTensorData(const taco_tensor_t& tensorData,
       modeIndices.push_back(ModeIndex({size}));
       numVals *= ((int*)tensorData.indices[i][0])[0];
     } else if (modeType.getName() == Sparse.getName()) {
-      auto size = ((int*)tensorData.indices[i][0])[numVals];
-      Array pos = Array(type<int>(), tensorData.indices[i][0], numVals+1, Array::UserOwns);
-      Array idx = Array(type<int>(), tensorData.indices[i][1], size, Array::UserOwns);
+      Array pos = Array(format.getCoordinateTypePos(i), tensorData.indices[i][0],
+                        numVals+1, Array::UserOwns);
+      auto size = pos.get(numVals).getAsIndex();
+      Array idx = Array(format.getCoordinateTypeIdx(i), tensorData.indices[i][1],
+                        size, Array::UserOwns);
       modeIndices.push_back(ModeIndex({pos, idx}));
       numVals = size;
     } else if (modeType.getName() == Singleton.getName()) {
-      Array idx = Array(type<int>(), tensorData.indices[i][1], numVals, Array::UserOwns);
-      modeIndices.push_back(ModeIndex({makeArray(type<int>(), 0), idx}));
+      Array idx = Array(format.getCoordinateTypeIdx(i), tensorData.indices[i][1],
+                        numVals, Array::UserOwns);
+      modeIndices.push_back(ModeIndex({makeArray(format.getCoordinateTypePos(i), 0),
+                                       idx}));
+    } else if (modeType.getName() == Hashed.getName()) {
+      int width = ((int*)tensorData.indices[i][0])[0];
+      Array widthArray = makeArray({width});
+      Array idx = Array(format.getCoordinateTypeIdx(i), tensorData.indices[i][1],
+                        numVals * width, Array::UserOwns);
+      modeIndices.push_back(ModeIndex({widthArray, idx}));
+      numVals *= width;
+    } else if (modeType.getName() == Bitmap.getName()) {
+      // The pack kernel assembled the bitmap level as a compressed level (see
+      // getPackFormat), so set the bits of its coordinates and rank the words
+      const Datatype crdType = getPackFormat(format).getCoordinateTypeIdx(i);
+      Array pos = Array(getPackFormat(format).getCoordinateTypePos(i),
+                        tensorData.indices[i][0], numVals+1, Array::UserOwns);
+      const size_t size = pos.get(numVals).getAsIndex();
+      Array crd = Array(crdType, tensorData.indices[i][1], size,
+                        Array::UserOwns);
+      const int dimension = tensor.getDimension(format.getModeOrdering()[i]);
+      const size_t numWords = (dimension + BitmapModeFormat::WORD_BITS - 1) /
+                              BitmapModeFormat::WORD_BITS;
+      Array bits = makeArray(UInt64, numVals * numWords);
+      uint64_t* bitsData = (uint64_t*)bits.getData();
+      memset(bitsData, 0, numVals * numWords * sizeof(uint64_t));
+      for (size_t p = 0; p < numVals; p++) {
+        for (size_t k = pos.get(p).getAsIndex(); k < pos.get(p+1).getAsIndex(); k++) {
+          const size_t coord = crd.get(k).getAsIndex();
+          bitsData[p * numWords + coord / BitmapModeFormat::WORD_BITS] |=
+              (uint64_t)1 << (coord % BitmapModeFormat::WORD_BITS);
+        }
+      }
+      // Position 0 is reserved for the fill value
+      TypedIndexVector ranks(format.getCoordinateTypePos(i));
+      size_t count = 1;
+      for (size_t w = 0; w < numVals * numWords; w++) {
+        ranks.push_back((int)count);
+        count += __builtin_popcountll(bitsData[w]);
+      }
+      ranks.push_back((int)count);
+      modeIndices.push_back(ModeIndex({makeIndexArray(ranks), bits}));
+      numVals = count;
+    } else if (modeType.getName() == Diagonal.getName()) {
+      // The pack kernel assembled the diagonal level as a compressed level (see
+      // getPackFormat), so collect the diagonals of its coordinates and scatter
+      // the values of every row to the positions of their diagonals
+      const Format packFormat = getPackFormat(format);
+      Array pos = Array(packFormat.getCoordinateTypePos(i),
+                        tensorData.indices[i][0], numVals+1, Array::UserOwns);
+      const size_t size = pos.get(numVals).getAsIndex();
+      Array crd = Array(packFormat.getCoordinateTypeIdx(i),
+                        tensorData.indices[i][1], size, Array::UserOwns);
+      vector<int> offsets;
+      for (size_t p = 0; p < numVals; p++) {
+        for (size_t k = pos.get(p).getAsIndex(); k < pos.get(p+1).getAsIndex(); k++) {
+          offsets.push_back((int)crd.get(k).getAsIndex() - (int)p);
+        }
+      }
+      std::sort(offsets.begin(), offsets.end());
+      offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+      const size_t numDiagonals = offsets.size();
+
+      const size_t csize = tensor.getComponentType().getNumBytes();
+      scatteredVals = makeFillArray(storage, numVals * numDiagonals);
+      for (size_t p = 0; p < numVals; p++) {
+        for (size_t k = pos.get(p).getAsIndex(); k < pos.get(p+1).getAsIndex(); k++) {
+          const int offset = (int)crd.get(k).getAsIndex() - (int)p;
+          const size_t d = std::lower_bound(offsets.begin(), offsets.end(),
+                                            offset) - offsets.begin();
+          memcpy((char*)scatteredVals.getData() + (p * numDiagonals + d) * csize,
+                 (char*)tensorData.vals + k * csize, csize);
+        }
+      }
+
+      // The offsets end with a sentinel that is larger than any offset
+      TypedIndexVector offsetsVector(format.getCoordinateTypeIdx(i));
+      offsetsVector.push_back_vector(offsets);
+      offsetsVector.push_back(INT_MAX);
+      modeIndices.push_back(ModeIndex({makeArray({(int)numDiagonals}),
+                                       makeIndexArray(offsetsVector)}));
+      numVals *= numDiagonals;
+    } else if (modeType.getName() == Ell.getName()) {
+      // The pack kernel assembled the ell level as a compressed level (see
+      // getPackFormat), so sort the rows of every window by length, pad the
+      // slices to their longest row, and scatter the rows column-major
+      const Format packFormat = getPackFormat(format);
+      Array pos = Array(packFormat.getCoordinateTypePos(i),
+                        tensorData.indices[i][0], numVals+1, Array::UserOwns);
+      Array crd = Array(packFormat.getCoordinateTypeIdx(i),
+                        tensorData.indices[i][1],
+                        pos.get(numVals).getAsIndex(), Array::UserOwns);
+      const size_t sliceHeight = EllModeFormat::getSliceHeight(modeType);
+      const size_t sortWindow = EllModeFormat::getSortWindow(modeType);
+      vector<size_t> lengths(numVals);
+      for (size_t r = 0; r < numVals; r++) {
+        lengths[r] = pos.get(r+1).getAsIndex() - pos.get(r).getAsIndex();
+      }
+      vector<size_t> rows(numVals);
+      for (size_t r = 0; r < numVals; r++) {
+        rows[r] = r;
+      }
+      for (size_t w = 0; w < numVals && sortWindow > 1; w += sortWindow) {
+        std::stable_sort(rows.begin() + w,
+                         rows.begin() + std::min(w + sortWindow, numVals),
+                         [&](size_t a, size_t b) {
+                           return lengths[a] > lengths[b];
+                         });
+      }
+
+      // Slices start after the padded rows of the slices before them
+      vector<size_t> begins(numVals);
+      size_t size = 0;
+      for (size_t s = 0; s < numVals; s += sliceHeight) {
+        size_t width = 0;
+        for (size_t t = s; t < std::min(s + sliceHeight, numVals); t++) {
+          begins[rows[t]] = size + (t - s);
+          width = std::max(width, lengths[rows[t]]);
+        }
+        size += width * sliceHeight;
+      }
+
+      const size_t csize = tensor.getComponentType().getNumBytes();
+      TypedIndexVector ellPos(format.getCoordinateTypePos(i));
+      TypedIndexVector ellCrd(format.getCoordinateTypeIdx(i), size);
+      scatteredVals = makeFillArray(storage, size);
+      for (size_t p = 0; p < size; p++) {
+        ellCrd.set(p, -1);
+      }
+      ellPos.push_back((int)sliceHeight);
+      for (size_t r = 0; r < numVals; r++) {
+        ellPos.push_back((int)begins[r]);
+        ellPos.push_back((int)(begins[r] + lengths[r] * sliceHeight));
+        for (size_t k = 0; k < lengths[r]; k++) {
+          const size_t src = pos.get(r).getAsIndex() + k;
+          const size_t dst = begins[r] + k * sliceHeight;
+          ellCrd.set(dst, (int)crd.get(src).getAsIndex());
+          memcpy((char*)scatteredVals.getData() + dst * csize,
+                 (char*)tensorData.vals + src * csize, csize);
+        }
+      }
+      ellPos.push_back((int)size);
+      modeIndices.push_back(ModeIndex({makeIndexArray(ellPos),
+                                       makeIndexArray(ellCrd)}));
+      numVals = size;
     } else {
       taco_not_supported_yet;
     }
   }
   storage.setIndex(Index(format, modeIndices));
+  if (format.getOrder() > 0 &&
+      format.getModeFormats().back().getName() == Bitmap.getName()) {
+    const size_t csize = tensor.getComponentType().getNumBytes();
+    Array vals = makeArray(tensor.getComponentType(), numVals);
+    Literal fill = storage.getFillValue();
+    if (fill.defined()) {
+      memcpy(vals.getData(), fill.getValPtr(), csize);
+    } else {
+      memset(vals.getData(), 0, csize);
+    }
+    memcpy((char*)vals.getData() + csize, tensorData.vals, (numVals-1) * csize);
+    storage.setValues(vals);
+    return numVals;
+  }
+  if (format.getOrder() > 0 &&
+      (format.getModeFormats().back().getName() == Diagonal.getName() ||
+       format.getModeFormats().back().getName() == Ell.getName())) {
+    storage.setValues(scatteredVals);
+    return numVals;
+  }
   storage.setValues(Array(tensor.getComponentType(), tensorData.vals, numVals));
   return numVals;
 }
 
+/// Raise the error reported by a generated kernel, if any. Kernels fail with
+/// error code 1 when the table of a hashed result level overflows.
+static void checkKernelResult(int result) {
+  taco_uassert(result != 1) << "A hash table of a hashed level is full. Use a "
+      "hashed mode format with more slots than there are coordinates below "
+      "any parent position";
+  taco_uassert(result == 0) << "Kernel failed with error code " << result;
+}
+
 /// Pack coordinates into a data structure given by the tensor format.
 void TensorBase::pack() {
   if (!needsPack()) {
@@ -298,55 +609,55 @@ void TensorBase::pack() {
   }
   setNeedsPack(false);
 
+  // Components are spliced directly into packed dense and compressed levels
+  const bool splice = !neverPacked() && canSpliceCoordinates(getFormat());
+  std::vector<std::vector<int>> packedCoordinates;
+  std::vector<char> packedValues;
   if (neverPacked()) {
     unsetNeverPacked();
-  } else {
-    // Reinsert packed components into temporary buffer and repack them along
-    // with unpacked components. This is needed to implement increment
-    // semantics.
-    // TODO: Change to using code that adds packed components (stored in packed
-    //       data structure) with unpacked components (stored in temporary
-    //       buffer). We can already generate such code, but currently
-    //       compiling it is too expensive.
+  } else if (!splice) {
+    // Extract the packed components so that they can be merged with the
+    // unpacked components (stored in temporary buffer), which implements
+    // increment semantics without re-sorting the packed components.
     switch (getComponentType().getKind()) {
       case Datatype::Bool:
-        reinsertPackedComponents<bool>();
+        extractPackedComponents<bool>(packedCoordinates, packedValues);
         break;
       case Datatype::UInt8:
-        reinsertPackedComponents<uint8_t>();
+        extractPackedComponents<uint8_t>(packedCoordinates, packedValues);
         break;
       case Datatype::UInt16:
-        reinsertPackedComponents<uint16_t>();
+        extractPackedComponents<uint16_t>(packedCoordinates, packedValues);
         break;
       case Datatype::UInt32:
-        reinsertPackedComponents<uint32_t>();
+        extractPackedComponents<uint32_t>(packedCoordinates, packedValues);
         break;
       case Datatype::UInt64:
-        reinsertPackedComponents<uint64_t>();
+        extractPackedComponents<uint64_t>(packedCoordinates, packedValues);
         break;
       case Datatype::Int8:
-        reinsertPackedComponents<int8_t>();
+        extractPackedComponents<int8_t>(packedCoordinates, packedValues);
         break;
       case Datatype::Int16:
-        reinsertPackedComponents<int16_t>();
+        extractPackedComponents<int16_t>(packedCoordinates, packedValues);
         break;
       case Datatype::Int32:
-        reinsertPackedComponents<int32_t>();
+        extractPackedComponents<int32_t>(packedCoordinates, packedValues);
         break;
       case Datatype::Int64:
-        reinsertPackedComponents<int64_t>();
+        extractPackedComponents<int64_t>(packedCoordinates, packedValues);
         break;
       case Datatype::Float32:
-        reinsertPackedComponents<float>();
+        extractPackedComponents<float>(packedCoordinates, packedValues);
         break;
       case Datatype::Float64:
-        reinsertPackedComponents<double>();
+        extractPackedComponents<double>(packedCoordinates, packedValues);
         break;
       case Datatype::Complex64:
-        reinsertPackedComponents<std::complex<float>>();
+        extractPackedComponents<std::complex<float>>(packedCoordinates, packedValues);
         break;
       case Datatype::Complex128:
-        reinsertPackedComponents<std::complex<double>>();
+        extractPackedComponents<std::complex<double>>(packedCoordinates, packedValues);
         break;
       default:
         taco_ierror << "unsupported type";
@@ -384,7 +695,7 @@ void TensorBase::pack() {
     bufferStorage->vals = (uint8_t*)content->coordinateBuffer->data();
 
     std::vector<void*> arguments = {content->storage, bufferStorage};
-    helperFuncs->callFuncPacked("pack", arguments.data());
+    checkKernelResult(helperFuncs->callFuncPacked("pack", arguments.data()));
     content->valuesSize = unpackTensorData(*((taco_tensor_t*)arguments[0]), *this);
 
     deinit_taco_tensor_t(bufferStorage);
@@ -392,61 +703,47 @@ void TensorBase::pack() {
     return;
   }
 
-  // Permute the coordinates according to the storage mode ordering.
-  // This is a workaround since the current pack code only packs tensors in the
-  // ordering of the modes.
+  // Permute the coordinates according to the storage mode ordering and sort
+  // them. This is a workaround since the current pack code only packs sorted
+  // tensors in the ordering of the modes.
   taco_iassert(getFormat().getOrder() == order);
   std::vector<int> permutation = getFormat().getModeOrdering();
-  std::vector<int> permutedDimensions(order);
-  for (int i = 0; i < order; ++i) {
-    permutedDimensions[i] = dimensions[permutation[i]];
-  }
-
-  const size_t coordSize = content->coordinateSize;
-  char* coordinatesPtr = content->coordinateBuffer->data();
-  vector<int> permuteBuffer(order);
-  for (size_t i = 0; i < numCoordinates; ++i) {
-    int* coordinate = (int*)coordinatesPtr;
-    for (int j = 0; j < order; j++) {
-      permuteBuffer[j] = coordinate[permutation[j]];
-    }
-    for (int j = 0; j < order; j++) {
-      coordinate[j] = permuteBuffer[j];
-    }
-    coordinatesPtr += content->coordinateSize;
-  }
-  coordinatesPtr = content->coordinateBuffer->data();
-
-  // The pack code expects the coordinates to be sorted
-  numIntegersToCompare = order;
-  qsort(coordinatesPtr, numCoordinates, coordSize, lexicographicalCmp);
-
-
-  // Move coords into separate arrays
   std::vector<std::vector<int>> coordinates(order);
-  for (int i = 0; i < order; ++i) {
-    coordinates[i] = std::vector<int>(numCoordinates);
-  }
   char* values = (char*) malloc(numCoordinates * csize);
-  for (size_t i = 0; i < numCoordinates; ++i) {
-    int* coordLoc = (int*)&coordinatesPtr[i * coordSize];
-    for (int d = 0; d < order; ++d) {
-      coordinates[d][i] = *coordLoc;
-      coordLoc++;
-    }
-    memcpy(&values[i * csize], coordLoc, csize);
-  }
-
+  sortCoordinates(content->coordinateBuffer->data(), numCoordinates, csize,
+                  dimensions, permutation, coordinates, values);
 
   content->coordinateBuffer->clear();
   content->coordinateBufferUsed = 0;
 
+  if (splice) {
+    content->valuesSize = spliceCoordinates(content->storage, coordinates,
+                                            values, numCoordinates);
+    free(values);
+    return;
+  }
+
+  // Merge the sorted unpacked components into the (already sorted) packed
+  // components, so that the pack kernel sees a single sorted buffer.
+  size_t numComponents = numCoordinates;
+  if (!packedValues.empty()) {
+    const size_t numPacked = packedValues.size() / csize;
+    numComponents = numPacked + numCoordinates;
+    std::vector<std::vector<int>> mergedCoordinates;
+    char* mergedValues = (char*) malloc(numComponents * csize);
+    mergeCoordinates(packedCoordinates, packedValues.data(), coordinates,
+                     values, csize, mergedCoordinates, mergedValues);
+    free(values);
+    values = mergedValues;
+    coordinates = std::move(mergedCoordinates);
+  }
+
   void* fillPtr = getStorage().getFillValue().defined()? getStorage().getFillValue().getValPtr() : nullptr;
   std::vector<taco_mode_t> bufferModeTypes(order, taco_mode_sparse);
   taco_tensor_t* bufferStorage = init_taco_tensor_t(order, csize,
       (int32_t*)dimensions.data(), (int32_t*)permutation.data(),
       (taco_mode_t*)bufferModeTypes.data(), fillPtr);
-  std::vector<int> pos = {0, (int)numCoordinates};
+  std::vector<int> pos = {0, (int)numComponents};
   bufferStorage->indices[0][0] = (uint8_t*)pos.data();
   for (int i = 0; i < order; ++i) {
     bufferStorage->indices[i][1] = (uint8_t*)coordinates[i].data();
@@ -455,11 +752,11 @@ void TensorBase::pack() {
 
   // Pack nonzero components into required format
   std::vector<void*> arguments = {content->storage, bufferStorage};
-  helperFuncs->callFuncPacked("pack", arguments.data());
-  content->valuesSize = unpackTensorData(*((taco_tensor_t*)arguments[0]), *this);
-
+  const int result = helperFuncs->callFuncPacked("pack", arguments.data());
   free(values);
   deinit_taco_tensor_t(bufferStorage);
+  checkKernelResult(result);
+  content->valuesSize = unpackTensorData(*((taco_tensor_t*)arguments[0]), *this);
 }
 
 void TensorBase::setStorage(TensorStorage storage) {
@@ -577,35 +874,174 @@ const Access TensorBase::operator()() const {
   return this->operator()(std::vector<IndexVar>());
 }
 
-TensorBase::KernelsCache TensorBase::computeKernels;
-std::mutex TensorBase::computeKernelsMutex;
+/// Compiled compute kernels, keyed on the structural hash of the concretized
+/// statement they were compiled from so that only statements in the same
+/// bucket need to be checked for isomorphism. The table is split into shards
+/// that each have a reader-writer lock, so concurrent lookups do not contend.
+/// Recency is tracked with a logical clock that lookups bump atomically under
+/// the shared lock. The number of kernels in all shards is counted, and while
+/// it exceeds the capacity the least recently used kernel of all shards is
+/// evicted, locking one shard at a time.
+class TensorBase::KernelsCache {
+public:
+  std::shared_ptr<Module> get(const IndexStmt& stmt) {
+    const size_t hash = structuralHash(stmt);
+    Shard& shard = shards[hash % NumShards];
+    std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+    const auto range = shard.entries.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (isomorphic(stmt, it->second.stmt)) {
+        it->second.lastUse = ++clock;
+        ++hits;
+        return it->second.kernel;
+      }
+    }
+    ++misses;
+    return nullptr;
+  }
+
+  void insert(const IndexStmt& stmt, const std::shared_ptr<Module>& kernel) {
+    const size_t hash = structuralHash(stmt);
+    Shard& shard = shards[hash % NumShards];
+    std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+    const auto range = shard.entries.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      // Another thread compiled the same kernel concurrently.
+      if (isomorphic(stmt, it->second.stmt)) {
+        return;
+      }
+    }
 
-std::shared_ptr<Module> TensorBase::getComputeKernel(const IndexStmt stmt) {
-  computeKernelsMutex.lock();
-  const auto computeKernelsReverse =
-      util::ReverseConstIterable<TensorBase::KernelsCache>(computeKernels);
-  for (const auto& computeKernel : computeKernelsReverse) {
-    if (isomorphic(stmt, computeKernel.first)) {
-      const auto kernelModule = computeKernel.second;
-      computeKernelsMutex.unlock();
-      return kernelModule;
+    shard.entries.emplace(std::piecewise_construct, std::forward_as_tuple(hash),
+                          std::forward_as_tuple(stmt, kernel, ++clock));
+    ++size;
+    lock.unlock();
+    evictToCapacity();
+  }
+
+  KernelCacheStats getStats() {
+    KernelCacheStats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.evictions = evictions;
+    for (Shard& shard : shards) {
+      std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+      stats.size += shard.entries.size();
+    }
+    return stats;
+  }
+
+  void setCapacity(size_t capacity) {
+    this->capacity = capacity;
+    evictToCapacity();
+  }
+
+  void clear() {
+    for (Shard& shard : shards) {
+      std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+      size -= shard.entries.size();
+      shard.entries.clear();
+    }
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+  }
+
+private:
+  struct Entry {
+    Entry(const IndexStmt& stmt, const std::shared_ptr<Module>& kernel,
+          uint64_t lastUse) : stmt(stmt), kernel(kernel), lastUse(lastUse) {}
+
+    IndexStmt stmt;
+    std::shared_ptr<Module> kernel;
+    std::atomic<uint64_t> lastUse;
+  };
+
+  struct Shard {
+    std::shared_timed_mutex mutex;
+    std::unordered_multimap<size_t, Entry> entries;
+  };
+
+  static const size_t NumShards = 16;
+  std::array<Shard, NumShards> shards;
+
+  /// Evict least recently used kernels until the cache fits in its capacity.
+  void evictToCapacity() {
+    while (capacity > 0 && size > capacity) {
+      // Find the shard that holds the least recently used kernel
+      Shard* victim = nullptr;
+      uint64_t victimLastUse = 0;
+      for (Shard& shard : shards) {
+        std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+        for (const auto& entry : shard.entries) {
+          if (!victim || entry.second.lastUse < victimLastUse) {
+            victim = &shard;
+            victimLastUse = entry.second.lastUse;
+          }
+        }
+      }
+      if (!victim) {
+        return;
+      }
+
+      // Other threads may have used or evicted kernels of the shard since,
+      // so evict whatever kernel of it is least recently used now
+      std::unique_lock<std::shared_timed_mutex> lock(victim->mutex);
+      if (victim->entries.empty() || size <= capacity) {
+        continue;
+      }
+      auto lru = victim->entries.begin();
+      for (auto it = victim->entries.begin(); it != victim->entries.end(); ++it) {
+        if (it->second.lastUse < lru->second.lastUse) {
+          lru = it;
+        }
+      }
+      victim->entries.erase(lru);
+      --size;
+      ++evictions;
     }
   }
-  computeKernelsMutex.unlock();
-  return nullptr;
+
+  std::atomic<uint64_t> clock{0};
+  std::atomic<size_t> size{0};
+  std::atomic<size_t> capacity{0};
+  std::atomic<size_t> hits{0};
+  std::atomic<size_t> misses{0};
+  std::atomic<size_t> evictions{0};
+};
+
+TensorBase::KernelsCache TensorBase::computeKernels;
+
+std::shared_ptr<Module> TensorBase::getComputeKernel(const IndexStmt stmt) {
+  return computeKernels.get(stmt);
 }
 
 void TensorBase::cacheComputeKernel(const IndexStmt stmt,
                                     const std::shared_ptr<Module> kernel) {
-  computeKernelsMutex.lock();
-  computeKernels.emplace_back(stmt, kernel);
-  computeKernelsMutex.unlock();
+  computeKernels.insert(stmt, kernel);
 }
 
-void TensorBase::compile() {
+KernelCacheStats TensorBase::getComputeKernelCacheStats() {
+  return computeKernels.getStats();
+}
+
+void TensorBase::setComputeKernelCacheCapacity(size_t capacity) {
+  computeKernels.setCapacity(capacity);
+}
+
+void TensorBase::clearComputeKernelCache() {
+  computeKernels.clear();
+}
+
+IndexStmt TensorBase::getScheduledAssignment() {
   Assignment assignment = getAssignment();
   taco_uassert(assignment.defined())
       << error::compile_without_expr;
+  for (const ModeFormat& modeFormat : getFormat().getModeFormats()) {
+    taco_uassert(modeFormat.hasAppend() || modeFormat.hasInsert())
+        << "Results cannot be assembled into " << modeFormat.getName()
+        << " levels";
+  }
 
   struct CollisionFinder : public IndexNotationVisitor {
     using IndexNotationVisitor::visit;
@@ -638,15 +1074,56 @@ void TensorBase::compile() {
   stmt = reorderLoopsTopologically(stmt);
   stmt = insertTemporaries(stmt);
   stmt = parallelizeOuterLoop(stmt);
-  compile(stmt, content->assembleWhileCompute);
+  return stmt;
+}
+
+void TensorBase::compile() {
+  compile(getScheduledAssignment(), content->assembleWhileCompute);
 }
 
 void TensorBase::compile(taco::IndexStmt stmt, bool assembleWhileCompute) {
+  waitForCompile();
   if (!needsCompile()) {
     return;
   }
   setNeedsCompile(false);
+  compileKernel(content, stmt, assembleWhileCompute);
+}
+
+std::shared_future<void> TensorBase::compileAsync() {
+  return compileAsync(getScheduledAssignment(), content->assembleWhileCompute);
+}
+
+std::shared_future<void> TensorBase::compileAsync(IndexStmt stmt,
+                                                  bool assembleWhileCompute) {
+  waitForCompile();
+  if (!needsCompile()) {
+    std::promise<void> compiled;
+    compiled.set_value();
+    return compiled.get_future().share();
+  }
+  setNeedsCompile(false);
+
+  // The task holds on to the content so that the tensor may be destroyed
+  // while it is being compiled.
+  std::shared_ptr<Content> content = this->content;
+  content->compileFuture = util::getCompilePool().submit(
+      [content, stmt, assembleWhileCompute]() {
+        compileKernel(content, stmt, assembleWhileCompute);
+      }).share();
+  return content->compileFuture;
+}
 
+void TensorBase::waitForCompile() const {
+  if (content->compileFuture.valid()) {
+    std::shared_future<void> compileFuture = content->compileFuture;
+    content->compileFuture = std::shared_future<void>();
+    compileFuture.get();
+  }
+}
+
+void TensorBase::compileKernel(std::shared_ptr<Content> content,
+                               IndexStmt stmt, bool assembleWhileCompute) {
   IndexStmt concretizedAssign = stmt;
   IndexStmt stmtToCompile = stmt.concretize();
   stmtToCompile = scalarPromote(stmtToCompile);
@@ -692,11 +1169,16 @@ void TensorBase::syncValues() {
   }
 }
 
+// Kernels of different tensors may run concurrently (e.g. from Python threads
+// without the GIL), and they add and remove themselves as dependents of their
+// operands, so the dependents are only accessed with their mutex held.
 void TensorBase::addDependentTensor(TensorBase& tensor) {
+  std::lock_guard<std::mutex> lock(content->dependentTensorsMutex);
   content->dependentTensors.push_back(tensor.content);
 }
 
 void TensorBase::removeDependentTensor(TensorBase& tensor) {
+  std::lock_guard<std::mutex> lock(content->dependentTensorsMutex);
   int size = content->dependentTensors.size();
   if (size == 0) {
     return;
@@ -720,6 +1202,7 @@ void TensorBase::removeDependentTensor(TensorBase& tensor) {
 }
 
 vector<TensorBase> TensorBase::getDependentTensors() {
+  std::lock_guard<std::mutex> lock(content->dependentTensorsMutex);
   vector<TensorBase> dependents;
   for(std::weak_ptr<Content> dependentContent : content->dependentTensors) {
     TensorBase current;
@@ -730,11 +1213,20 @@ vector<TensorBase> TensorBase::getDependentTensors() {
 }
 
 void TensorBase::syncDependentTensors() {
-  vector<TensorBase> dependents = getDependentTensors();
-  for (TensorBase dependent : dependents) {
-    dependent.syncValues();
+  // The dependents are taken before they are synced, since syncing them
+  // removes them from their operands
+  std::vector<std::weak_ptr<Content>> dependents;
+  {
+    std::lock_guard<std::mutex> lock(content->dependentTensorsMutex);
+    dependents.swap(content->dependentTensors);
+  }
+  for (std::weak_ptr<Content> dependentContent : dependents) {
+    TensorBase dependent;
+    dependent.content = dependentContent.lock();
+    if (dependent.content) {
+      dependent.syncValues();
+    }
   }
-  content->dependentTensors.clear();
 }
 
 static inline map<TensorVar, TensorBase> getTensors(const IndexExpr& expr) {
@@ -807,6 +1299,7 @@ vector<void*> packArguments(const TensorBase& tensor) {
 
 void TensorBase::assemble() {
   taco_uassert(!needsCompile()) << error::assemble_without_compile;
+  waitForCompile();
   if (!needsAssemble()) {
     return;
   }
@@ -817,7 +1310,8 @@ void TensorBase::assemble() {
   }
 
   auto arguments = packArguments(*this);
-  content->module->callFuncPacked("assemble", arguments.data());
+  checkKernelResult(content->module->callFuncPacked("assemble",
+                                                   arguments.data()));
 
   if (!content->assembleWhileCompute) {
     setNeedsAssemble(false);
@@ -828,6 +1322,7 @@ void TensorBase::assemble() {
 
 void TensorBase::compute() {
   taco_uassert(!needsCompile()) << error::compute_without_compile;
+  waitForCompile();
   if (!needsCompute()) {
     return;
   }
@@ -840,7 +1335,8 @@ void TensorBase::compute() {
   }
 
   auto arguments = packArguments(*this);
-  this->content->module->callFuncPacked("compute", arguments.data());
+  checkKernelResult(this->content->module->callFuncPacked("compute",
+                                                         arguments.data()));
 
   if (content->assembleWhileCompute) {
     setNeedsAssemble(false);
@@ -889,22 +1385,26 @@ Assignment TensorBase::getAssignment() const {
 }
 
 void TensorBase::printComputeIR(ostream& os, bool color, bool simplify) const {
+  waitForCompile();
   std::shared_ptr<ir::CodeGen> codegen = ir::CodeGen::init_default(os, ir::CodeGen::ImplementationGen);
   codegen->compile(content->computeFunc.as<Function>(), false);
 }
 
 void TensorBase::printAssembleIR(ostream& os, bool color, bool simplify) const {
+  waitForCompile();
   IRPrinter printer(os, color, simplify);
   printer.print(content->assembleFunc.as<Function>()->body);
 }
 
 string TensorBase::getSource() const {
+  waitForCompile();
   return content->module->getSource();
 }
 
 void TensorBase::compileSource(std::string source) {
   taco_iassert(getAssignment().getRhs().defined())
       << error::compile_without_expr;
+  waitForCompile();
 
   IndexStmt stmt = makeConcreteNotation(makeReductionNotation(getAssignment()));
   stmt = reorderLoopsTopologically(stmt);
@@ -962,13 +1462,14 @@ TensorBase::getHelperFunctions(const Format& format, Datatype ctype,
     const Format bufferFormat = COO(format.getOrder(), false, true, false,
                                     format.getModeOrdering());
     TensorVar bufferTensor(Type(ctype, Shape(dims)), bufferFormat);
-    TensorVar packedTensor(Type(ctype, Shape(dims)), format);
+    TensorVar packedTensor(Type(ctype, Shape(dims)), getPackFormat(format));
+    TensorVar iteratedTensor(Type(ctype, Shape(dims)), format);
 
     // Define packing and iterator routines in index notation.
     // TODO: Use `generatePackCOOStmt` function to generate pack routine.
     std::vector<IndexVar> indexVars(format.getOrder());
     IndexStmt packStmt = (packedTensor(indexVars) = bufferTensor(indexVars));
-    IndexStmt iterateStmt = Yield(indexVars, packedTensor(indexVars));
+    IndexStmt iterateStmt = Yield(indexVars, iteratedTensor(indexVars));
     for (int i = format.getOrder() - 1; i >= 0; --i) {
       int mode = format.getModeOrdering()[i];
       packStmt = forall(indexVars[mode], packStmt);
@@ -1269,6 +1770,9 @@ TensorBase dispatchRead(T& file, FileType filetype, U format, bool pack) {
     case FileType::rb:
       tensor = readRB(file, format, pack);
       break;
+    case FileType::taco:
+      tensor = readTACO(file, format, pack);
+      break;
   }
   return tensor;
 }
@@ -1290,6 +1794,9 @@ TensorBase dispatchRead(std::string filename, U format, bool pack) {
   else if (extension == "rb") {
     tensor = dispatchRead(filename, FileType::rb, format, pack);
   }
+  else if (extension == "taco") {
+    tensor = dispatchRead(filename, FileType::taco, format, pack);
+  }
   else {
     taco_uerror << "File extension not recognized: " << filename << std::endl;
   }
@@ -1341,6 +1848,9 @@ void dispatchWrite(T& file, const TensorBase& tensor, FileType filetype) {
     case FileType::rb:
       writeRB(file, tensor);
       break;
+    case FileType::taco:
+      writeTACO(file, tensor);
+      break;
   }
 }
 
@@ -1361,6 +1871,9 @@ void write(string filename, const TensorBase& tensor) {
   else if (extension == "rb") {
     dispatchWrite(filename, tensor, FileType::rb);
   }
+  else if (extension == "taco") {
+    dispatchWrite(filename, tensor, FileType::taco);
+  }
   else {
     taco_uerror << "File extension not recognized: " << filename << std::endl;
   }
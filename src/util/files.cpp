@@ -5,6 +5,10 @@
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -24,4 +28,34 @@ void openStream(std::fstream& stream, std::string path, fstream::openmode mode)
   taco_uassert(stream.is_open()) << "Error opening file: " << path;
 }
 
+MappedFile::MappedFile(std::string path, bool copyOnWrite)
+    : bytes(nullptr), numBytes(0) {
+  int fd = open(sanitizePath(path).c_str(), O_RDONLY);
+  taco_uassert(fd != -1) << "Error opening file: " << path;
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    taco_uerror << "Error reading file: " << path;
+  }
+  numBytes = info.st_size;
+  if (numBytes > 0) {
+    int protection = copyOnWrite ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* mapping = mmap(nullptr, numBytes, protection, MAP_PRIVATE, fd, 0);
+    close(fd);
+    taco_uassert(mapping != MAP_FAILED) << "Error mapping file: " << path;
+    if (!copyOnWrite) {
+      madvise(mapping, numBytes, MADV_SEQUENTIAL);
+    }
+    bytes = (char*)mapping;
+  } else {
+    close(fd);
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (bytes != nullptr) {
+    munmap(bytes, numBytes);
+  }
+}
+
 }}
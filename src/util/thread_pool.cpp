@@ -0,0 +1,57 @@
+#include "taco/util/thread_pool.h"
+
+#include <algorithm>
+#include <string>
+
+#include "taco/util/env.h"
+
+using namespace std;
+
+namespace taco {
+namespace util {
+
+ThreadPool::ThreadPool(size_t numThreads) : stopping(false) {
+  numThreads = std::max(numThreads, (size_t)1);
+  for (size_t i = 0; i < numThreads; i++) {
+    workers.emplace_back([this]() { work(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  taskAvailable.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::getNumThreads() const {
+  return workers.size();
+}
+
+void ThreadPool::work() {
+  while (true) {
+    function<void()> task;
+    {
+      unique_lock<std::mutex> lock(mutex);
+      taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+      if (tasks.empty()) {
+        return;
+      }
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+  }
+}
+
+ThreadPool& getCompilePool() {
+  static ThreadPool pool(stoul(getFromEnv("TACO_COMPILE_THREADS",
+      to_string(std::max(thread::hardware_concurrency(), 1u)))));
+  return pool;
+}
+
+}}
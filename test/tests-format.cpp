@@ -1,11 +1,13 @@
 #include "test.h"
 #include "test_tensors.h"
 
+#include <thread>
 #include <tuple>
 
 #include "taco/tensor.h"
 #include "taco/format.h"
 #include "taco/index_notation/index_notation.h"
+#include "taco/lower/mode_format_hashed.h"
 #include "taco/storage/storage.h"
 #include "taco/util/strings.h"
 
@@ -72,3 +74,427 @@ TEST(format, dense) {
   A.pack();
   ASSERT_COMPONENTS_EQUALS({{{3}}, {{3}}}, {0,2,0, 0,0,0, 3,0,4}, A);
 }
+
+TEST(format, indexTypes) {
+  Format wide = CSR;
+  wide.setLevelArrayTypes({{Int32}, {Int64, Int16}});
+  Format narrow = Format({Sparse, Sparse});
+  narrow.setLevelArrayTypes({{Int64, Int16}, {Int64, Int16}});
+
+  Tensor<double> A("A", {40, 30}, wide);
+  Tensor<double> B("B", {40, 30}, narrow);
+  Tensor<double> Aref("Aref", {40, 30}, CSR);
+  Tensor<double> Bref("Bref", {40, 30}, CSR);
+  for (int n = 0; n < 200; n++) {
+    A.insert({(n * 7) % 40, (n * 11) % 30}, (double)n);
+    Aref.insert({(n * 7) % 40, (n * 11) % 30}, (double)n);
+    B.insert({(n * 3) % 40, (n * 13) % 30}, (double)(n % 5));
+    Bref.insert({(n * 3) % 40, (n * 13) % 30}, (double)(n % 5));
+  }
+  A.pack();
+  B.pack();
+  Aref.pack();
+  Bref.pack();
+  ASSERT_EQ(Int64, A.getStorage().getIndex().getModeIndex(1).getIndexArray(0)
+                                  .getType());
+  ASSERT_EQ(Int16, A.getStorage().getIndex().getModeIndex(1).getIndexArray(1)
+                                  .getType());
+
+  IndexVar i, j;
+  Tensor<double> C("C", {40, 30}, wide);
+  C(i,j) = A(i,j) + B(i,j);
+  C.evaluate();
+  Tensor<double> expected("expected", {40, 30}, CSR);
+  expected(i,j) = Aref(i,j) + Bref(i,j);
+  expected.evaluate();
+  ASSERT_TENSOR_EQ(expected, C);
+  ASSERT_EQ(Int64, C.getStorage().getIndex().getModeIndex(1).getIndexArray(0)
+                                  .getType());
+
+  Tensor<double> windowed("windowed", {20, 10}, wide);
+  windowed(i,j) = A(i(10,30),j(5,15)) * B(i(10,30),j(5,15));
+  windowed.evaluate();
+  Tensor<double> windowedExpected("windowedExpected", {20, 10}, CSR);
+  windowedExpected(i,j) = Aref(i(10,30),j(5,15)) * Bref(i(10,30),j(5,15));
+  windowedExpected.evaluate();
+  ASSERT_TENSOR_EQ(windowedExpected, windowed);
+
+  // Index arrays may be of unsigned and 8-bit types
+  Format unsignedFormat = Format({Sparse, Sparse});
+  unsignedFormat.setLevelArrayTypes({{UInt8, Int8}, {UInt16, UInt8}});
+  Tensor<double> U("U", {40, 30}, unsignedFormat);
+  for (auto& value : iterate<double>(Bref)) {
+    U.insert(value.first.toVector(), value.second);
+  }
+  U.pack();
+  ASSERT_EQ(UInt8, U.getStorage().getIndex().getModeIndex(1).getIndexArray(1)
+                                  .getType());
+  Tensor<double> D("D", {40, 30}, unsignedFormat);
+  D(i,j) = A(i,j) * U(i,j);
+  D.evaluate();
+  Tensor<double> DExpected("DExpected", {40, 30}, CSR);
+  DExpected(i,j) = Aref(i,j) * Bref(i,j);
+  DExpected.evaluate();
+  ASSERT_TENSOR_EQ(DExpected, D);
+
+  Format invalid = CSR;
+  ASSERT_THROW(invalid.setLevelArrayTypes({{Int32}, {Int32, Float64}}),
+               taco::TacoException);
+  ASSERT_THROW(invalid.setLevelArrayTypes({{Int32}, {Int32, Int128}}),
+               taco::TacoException);
+}
+
+TEST(format, hashed) {
+  ModeFormat hashed32(std::make_shared<HashedModeFormat>(true, false, 32));
+  Format DH({Dense, hashed32});
+
+  Tensor<double> A("A", {12, 40}, CSR);
+  Tensor<double> B("B", {40, 30}, CSR);
+  Tensor<double> H("H", {12, 40}, DH);
+  Tensor<double> Href("Href", {12, 40}, Format({Dense, Dense}));
+  Tensor<double> x("x", {40}, Format({Dense}));
+  for (int n = 0; n < 60; n++) {
+    A.insert({(n * 5) % 12, (n * 7) % 40}, (double)n);
+    B.insert({(n * 3) % 40, (n * 11) % 30}, (double)(n % 7) + 1.0);
+    H.insert({(n * 7) % 12, (n * 9) % 40}, (double)n + 1.0);
+    Href.insert({(n * 7) % 12, (n * 9) % 40}, (double)n + 1.0);
+  }
+  for (int j = 0; j < 40; j++) {
+    x.insert({j}, (double)(j % 4) - 1.5);
+  }
+  A.pack();
+  B.pack();
+  H.pack();
+  Href.pack();
+  x.pack();
+  ASSERT_EQ(12u * 32u, H.getStorage().getIndex().getModeIndex(1)
+                                   .getIndexArray(1).getSize());
+
+  // Tables are no wider than the dimension of their mode requires
+  Tensor<double> narrow("narrow", {12, 20}, Format({Dense, Hashed}));
+  narrow.insert({0, 3}, 1.0);
+  narrow.pack();
+  ASSERT_EQ(12u * 32u, narrow.getStorage().getIndex().getModeIndex(1)
+                                        .getIndexArray(1).getSize());
+
+  // Tables that overflow are reported
+  ModeFormat hashed4(std::make_shared<HashedModeFormat>(true, false, 4));
+  Tensor<double> full("full", {12, 40}, Format({Dense, hashed4}));
+  for (int j = 0; j < 5; j++) {
+    full.insert({0, j}, 1.0);
+  }
+  ASSERT_THROW(full.pack(), taco::TacoException);
+
+  // Calls that run concurrently report only their own overflows
+  std::vector<std::thread> threads;
+  std::vector<int> failed(8, -1);
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&, t]() {
+      Tensor<double> table("table", {12, 40}, Format({Dense, hashed4}));
+      for (int j = 0; j < 4 + t % 2; j++) {
+        table.insert({t, j}, 1.0);
+      }
+      try {
+        table.pack();
+        failed[t] = 0;
+      } catch (const taco::TacoException&) {
+        failed[t] = 1;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < 8; t++) {
+    ASSERT_EQ(t % 2, failed[t]);
+  }
+
+  // Iterate over the slots of a hashed operand and locate into it
+  IndexVar i, j, k;
+  Tensor<double> y("y", {12}, Format({Dense}));
+  y(i) = H(i,j) * x(j);
+  y.evaluate();
+  Tensor<double> yExpected("yExpected", {12}, Format({Dense}));
+  yExpected(i) = Href(i,j) * x(j);
+  yExpected.evaluate();
+  ASSERT_TENSOR_EQ(yExpected, y);
+
+  Tensor<double> z("z", {12}, Format({Dense}));
+  z(i) = A(i,j) * H(i,j);
+  z.evaluate();
+  Tensor<double> zExpected("zExpected", {12}, Format({Dense}));
+  zExpected(i) = A(i,j) * Href(i,j);
+  zExpected.evaluate();
+  ASSERT_TENSOR_EQ(zExpected, z);
+
+  // Locate into a hashed level with narrow coordinates
+  Format DH16 = DH;
+  DH16.setLevelArrayTypes({{Int32}, {Int32, Int16}});
+  Format DHU16 = DH;
+  ASSERT_THROW(DHU16.setLevelArrayTypes({{Int32}, {Int32, UInt16}}),
+               taco::TacoException);
+  Tensor<double> H16("H16", {12, 40}, DH16);
+  for (int n = 0; n < 60; n++) {
+    H16.insert({(n * 7) % 12, (n * 9) % 40}, (double)n + 1.0);
+  }
+  H16.pack();
+  Tensor<double> z16("z16", {12}, Format({Dense}));
+  z16(i) = A(i,j) * H16(i,j);
+  z16.evaluate();
+  ASSERT_TENSOR_EQ(zExpected, z16);
+
+  // Accumulate the rows of a sparse matrix product in hash tables
+  Tensor<double> C("C", {12, 30}, DH);
+  C(i,k) = A(i,j) * B(j,k);
+  C.evaluate();
+  Tensor<double> Cdense("Cdense", {12, 30}, Format({Dense, Dense}));
+  Cdense(i,k) = C(i,k);
+  Cdense.evaluate();
+  Tensor<double> CExpected("CExpected", {12, 30}, Format({Dense, Dense}));
+  CExpected(i,k) = A(i,j) * B(j,k);
+  CExpected.evaluate();
+  ASSERT_TENSOR_EQ(CExpected, Cdense);
+}
+
+TEST(format, bitmap) {
+  Format DB({Dense, Bitmap});
+
+  Tensor<double> A("A", {12, 150}, CSR);
+  Tensor<double> B("B", {12, 150}, DB);
+  Tensor<double> C("C", {12, 150}, DB);
+  Tensor<double> Bref("Bref", {12, 150}, CSR);
+  Tensor<double> Cref("Cref", {12, 150}, CSR);
+  Tensor<double> x("x", {150}, Format({Dense}));
+  for (int n = 0; n < 400; n++) {
+    A.insert({(n * 5) % 12, (n * 7) % 150}, (double)n);
+    B.insert({(n * 7) % 12, (n * 13) % 150}, (double)n + 1.0);
+    Bref.insert({(n * 7) % 12, (n * 13) % 150}, (double)n + 1.0);
+    C.insert({(n * 11) % 12, (n * 3) % 150}, (double)(n % 5) - 2.0);
+    Cref.insert({(n * 11) % 12, (n * 3) % 150}, (double)(n % 5) - 2.0);
+  }
+  for (int j = 0; j < 150; j++) {
+    x.insert({j}, (double)(j % 4) - 1.5);
+  }
+  A.pack();
+  B.pack();
+  C.pack();
+  Bref.pack();
+  Cref.pack();
+  x.pack();
+  ASSERT_TENSOR_EQ(Bref, B);
+  ASSERT_EQ(12u * 3u, B.getStorage().getIndex().getModeIndex(1)
+                                  .getIndexArray(1).getSize());
+
+  // Skip the words of a bitmap operand
+  IndexVar i, j;
+  Tensor<double> y("y", {12}, Format({Dense}));
+  y(i) = B(i,j) * x(j);
+  y.evaluate();
+  Tensor<double> yExpected("yExpected", {12}, Format({Dense}));
+  yExpected(i) = Bref(i,j) * x(j);
+  yExpected.evaluate();
+  ASSERT_TENSOR_EQ(yExpected, y);
+
+  // Intersect and union bitmaps word by word
+  Tensor<double> z("z", {12}, Format({Dense}));
+  z(i) = B(i,j) * C(i,j);
+  z.evaluate();
+  Tensor<double> zExpected("zExpected", {12}, Format({Dense}));
+  zExpected(i) = Bref(i,j) * Cref(i,j);
+  zExpected.evaluate();
+  ASSERT_TENSOR_EQ(zExpected, z);
+
+  Tensor<double> w("w", {12}, Format({Dense}));
+  w(i) = B(i,j) + C(i,j) * x(j);
+  w.evaluate();
+  Tensor<double> wExpected("wExpected", {12}, Format({Dense}));
+  wExpected(i) = Bref(i,j) + Cref(i,j) * x(j);
+  wExpected.evaluate();
+  ASSERT_TENSOR_EQ(wExpected, w);
+
+  // Locate into a bitmap from a compressed level and from a dimension
+  Tensor<double> D("D", {12, 150}, CSR);
+  D(i,j) = A(i,j) * B(i,j);
+  D.evaluate();
+  Tensor<double> DExpected("DExpected", {12, 150}, CSR);
+  DExpected(i,j) = A(i,j) * Bref(i,j);
+  DExpected.evaluate();
+  ASSERT_TENSOR_EQ(DExpected, D);
+
+  Tensor<double> E("E", {12, 150}, Format({Dense, Dense}));
+  E(i,j) = B(i,j) + A(i,j);
+  E.evaluate();
+  Tensor<double> EExpected("EExpected", {12, 150}, Format({Dense, Dense}));
+  EExpected(i,j) = Bref(i,j) + A(i,j);
+  EExpected.evaluate();
+  ASSERT_TENSOR_EQ(EExpected, E);
+
+  Tensor<double> F("F", {12, 150}, DB);
+  ASSERT_THROW(F(i,j) = A(i,j); F.evaluate(), taco::TacoException);
+}
+
+TEST(format, blocked) {
+  Tensor<double> A("A", {10, 14}, CSR);
+  Tensor<double> x("x", {14}, Format({Dense}));
+  for (int n = 0; n < 40; n++) {
+    A.insert({(n * 3) % 10, (n * 5) % 14}, (double)n + 1.0);
+  }
+  for (int j = 0; j < 14; j++) {
+    x.insert({j}, (double)(j % 3) - 1.0);
+  }
+  A.pack();
+  x.pack();
+
+  // The dimensions are rounded up to whole 3x3 tiles
+  Tensor<double> Ab = A.block({3, 3}, BCSR);
+  Tensor<double> xb = x.block({3}, Format({Dense, Dense}));
+  ASSERT_EQ(std::vector<int>({4, 5, 3, 3}), Ab.getDimensions());
+  for (auto& value : A) {
+    int i = value.first[0];
+    int j = value.first[1];
+    ASSERT_EQ(value.second, Ab.at({i / 3, j / 3, i % 3, j % 3}));
+  }
+
+  // Tile loops have constant trip counts
+  IndexVar i, j, ii, jj;
+  Tensor<double> yb("yb", {4, 3}, Format({Dense, Dense}));
+  yb(i,ii) = Ab(i,j,ii,jj) * xb(j,jj);
+  yb.compile();
+  ASSERT_NE(std::string::npos, yb.getSource().find(" < 3; "));
+  yb.assemble();
+  yb.compute();
+
+  Tensor<double> y("y", {10}, Format({Dense}));
+  y(i) = A(i,j) * x(j);
+  y.evaluate();
+  Tensor<double> yExpected = y.block({3}, Format({Dense, Dense}));
+  ASSERT_TENSOR_EQ(yExpected, yb);
+
+  ASSERT_EQ(Format({Sparse, Sparse, Sparse, Dense, Dense, Dense}), BCSF(3));
+}
+
+TEST(format, diagonal) {
+  Tensor<double> A("A", {9, 11}, DIA);
+  Tensor<double> Aref("Aref", {9, 11}, CSR);
+  Tensor<double> B("B", {9, 11}, CSR);
+  Tensor<double> x("x", {11}, Format({Dense}));
+  for (int i = 0; i < 9; i++) {
+    for (int offset : {-2, 0, 3}) {
+      const int j = i + offset;
+      if (j >= 0 && j < 11 && (offset != 3 || i % 2 == 0)) {
+        A.insert({i, j}, (double)(i + 2 * j) + 1.0);
+        Aref.insert({i, j}, (double)(i + 2 * j) + 1.0);
+      }
+    }
+  }
+  for (int n = 0; n < 30; n++) {
+    B.insert({(n * 5) % 9, (n * 7) % 11}, (double)n - 10.0);
+  }
+  for (int j = 0; j < 11; j++) {
+    x.insert({j}, (double)(j % 3) + 0.5);
+  }
+  A.pack();
+  Aref.pack();
+  B.pack();
+  x.pack();
+  ASSERT_TENSOR_EQ(Aref, A);
+  ASSERT_EQ(3u, A.getStorage().getIndex().getModeIndex(1)
+                              .getIndexArray(0).get(0).getAsIndex());
+  ASSERT_EQ(9u * 3u, A.getStorage().getValues().getSize());
+
+  IndexVar i, j;
+  Tensor<double> y("y", {9}, Format({Dense}));
+  y(i) = A(i,j) * x(j);
+  y.evaluate();
+  Tensor<double> yExpected("yExpected", {9}, Format({Dense}));
+  yExpected(i) = Aref(i,j) * x(j);
+  yExpected.evaluate();
+  ASSERT_TENSOR_EQ(yExpected, y);
+
+  // Coiterate the diagonals with a compressed level
+  Tensor<double> C("C", {9, 11}, CSR);
+  C(i,j) = A(i,j) * B(i,j);
+  C.evaluate();
+  Tensor<double> CExpected("CExpected", {9, 11}, CSR);
+  CExpected(i,j) = Aref(i,j) * B(i,j);
+  CExpected.evaluate();
+  ASSERT_TENSOR_EQ(CExpected, C);
+
+  Tensor<double> D("D", {9, 11}, Format({Dense, Dense}));
+  D(i,j) = A(i,j) + B(i,j);
+  D.evaluate();
+  Tensor<double> DExpected("DExpected", {9, 11}, Format({Dense, Dense}));
+  DExpected(i,j) = Aref(i,j) + B(i,j);
+  DExpected.evaluate();
+  ASSERT_TENSOR_EQ(DExpected, D);
+
+  ASSERT_THROW(Tensor<double>("E", {9, 11}, Format({Sparse, Diagonal})),
+               taco::TacoException);
+}
+
+TEST(format, ell) {
+  Tensor<double> A("A", {13, 17}, SELL(4, 8));
+  Tensor<double> Aref("Aref", {13, 17}, CSR);
+  Tensor<double> B("B", {13, 17}, CSR);
+  Tensor<double> x("x", {17}, Format({Dense}));
+  for (int n = 0; n < 60; n++) {
+    const int i = (n * n) % 13;
+    const int j = (n * 7) % 17;
+    A.insert({i, j}, (double)n + 1.0);
+    Aref.insert({i, j}, (double)n + 1.0);
+    B.insert({(n * 5) % 13, (n * 3) % 17}, (double)n - 20.0);
+  }
+  for (int j = 0; j < 17; j++) {
+    x.insert({j}, (double)(j % 5) - 1.5);
+  }
+  A.pack();
+  Aref.pack();
+  B.pack();
+  x.pack();
+  ASSERT_TENSOR_EQ(Aref, A);
+
+  // Rows are stepped through with a stride of the slice height, and the padded
+  // slices are column-major
+  const Array& pos = A.getStorage().getIndex().getModeIndex(1).getIndexArray(0);
+  ASSERT_EQ(4u, pos.get(0).getAsIndex());
+  ASSERT_EQ(2u * 13u + 2u, pos.getSize());
+  ASSERT_EQ(0u, pos.get(2 * 13 + 1).getAsIndex() % 4);
+
+  IndexVar i, j;
+  Tensor<double> y("y", {13}, Format({Dense}));
+  y(i) = A(i,j) * x(j);
+  y.evaluate();
+  Tensor<double> yExpected("yExpected", {13}, Format({Dense}));
+  yExpected(i) = Aref(i,j) * x(j);
+  yExpected.evaluate();
+  ASSERT_TENSOR_EQ(yExpected, y);
+  // The rows are lowered a slice at a time, with the lanes innermost
+  ASSERT_NE(std::string::npos, y.getSource().find("_lanes; "));
+
+  Tensor<double> a("a");
+  a = A(i,j) * x(j);
+  a.evaluate();
+  Tensor<double> aExpected("aExpected");
+  aExpected = Aref(i,j) * x(j);
+  aExpected.evaluate();
+  ASSERT_TENSOR_EQ(aExpected, a);
+
+  // Coiterate the strided rows with a compressed level
+  Tensor<double> C("C", {13, 17}, CSR);
+  C(i,j) = A(i,j) * B(i,j);
+  C.evaluate();
+  Tensor<double> CExpected("CExpected", {13, 17}, CSR);
+  CExpected(i,j) = Aref(i,j) * B(i,j);
+  CExpected.evaluate();
+  ASSERT_TENSOR_EQ(CExpected, C);
+
+  Tensor<double> D("D", {13, 17}, CSR);
+  D(i,j) = A(i,j) + B(i,j);
+  D.evaluate();
+  Tensor<double> DExpected("DExpected", {13, 17}, CSR);
+  DExpected(i,j) = Aref(i,j) + B(i,j);
+  DExpected.evaluate();
+  ASSERT_TENSOR_EQ(DExpected, D);
+
+  ASSERT_THROW(SELL(4, 6), taco::TacoException);
+}
@@ -1,6 +1,10 @@
 #include "test.h"
 
+#include <fstream>
+#include <map>
+
 #include "taco/tensor.h"
+#include "taco/util/env.h"
 
 using namespace taco;
 
@@ -127,3 +131,111 @@ TEST(io, mtxsymmetric) {
 
   ASSERT_TRUE(equals(expected, tensor));
 }
+
+TEST(io, mtxbounds) {
+  // Coordinates beyond the dimensions in the size line are rejected
+  const std::string filename = util::getTmpdir() + "bounds.mtx";
+  {
+    std::ofstream file(filename);
+    file << "%%MatrixMarket matrix coordinate real general" << std::endl;
+    file << "3 3 2" << std::endl;
+    file << "1 1 1.0" << std::endl;
+    file << "2 4 2.0" << std::endl;
+  }
+  ASSERT_THROW(read(filename, Sparse), taco::TacoException);
+  remove(filename.c_str());
+}
+
+TEST(io, tnslarge) {
+  // Write a tns file that is large enough to be parsed in several chunks,
+  // with comments, blank lines and values in a variety of notations, and
+  // check that it is read back exactly.
+  const std::string filename = util::getTmpdir() + "large.tns";
+  const vector<string> values = {"1", "-2.5", "0.1", "3e-5", "-1.25E+3",
+                                 "123456789012345678901234", "7.", ".75"};
+  map<vector<int>,double> expected;
+  {
+    std::ofstream file(filename);
+    file << "# generated" << std::endl;
+    for (int n = 0; n < 100000; n++) {
+      vector<int> coord = {(n * 7919) % 1000 + 1, (n * 31) % 97 + 1, n % 13 + 1};
+      const string& value = values[n % values.size()];
+      file << coord[0] << " " << coord[1] << "\t" << coord[2] << "  " << value;
+      file << ((n % 1000 == 0) ? "\r\n\n" : "\n");
+      expected[{coord[0]-1, coord[1]-1, coord[2]-1}] += strtod(value.c_str(),
+                                                               nullptr);
+    }
+  }
+
+  Tensor<double> tensor = read(filename, Sparse);
+  ASSERT_EQ(vector<int>({1000, 97, 13}), tensor.getDimensions());
+  size_t numComponents = 0;
+  for (auto& value : tensor) {
+    ASSERT_DOUBLE_EQ(expected.at(value.first.toVector()), value.second);
+    numComponents++;
+  }
+  ASSERT_EQ(expected.size(), numComponents);
+  remove(filename.c_str());
+}
+
+TEST(io, taco) {
+  // Write a tensor in the binary format and check that it loads into the
+  // stored format directly and can be repacked into a different format.
+  Tensor<double> tensor({40, 30, 20}, Format({Sparse, Sparse, Sparse}, {2, 0, 1}));
+  map<vector<int>,double> expected;
+  for (int n = 0; n < 200; n++) {
+    vector<int> coord = {(n * 7) % 40, (n * 11) % 30, (n * 13) % 20};
+    tensor.insert(coord, (double)n);
+    expected[coord] += (double)n;
+  }
+  tensor.pack();
+
+  const std::string filename = util::getTmpdir() + "tensor.taco";
+  write(filename, tensor);
+  Tensor<double> loaded = read(filename, tensor.getFormat());
+  ASSERT_EQ(tensor.getFormat(), loaded.getFormat());
+  ASSERT_TRUE(equals(tensor, loaded));
+
+  Tensor<double> repacked = read(filename, Sparse);
+  ASSERT_EQ(Format({Sparse, Sparse, Sparse}), repacked.getFormat());
+  size_t numComponents = 0;
+  for (auto& value : repacked) {
+    ASSERT_EQ(expected.at(value.first.toVector()), value.second);
+    numComponents++;
+  }
+  ASSERT_EQ(expected.size(), numComponents);
+
+  // Overwrite the file that the loaded tensor maps
+  write(filename, repacked);
+  ASSERT_TRUE(equals(tensor, loaded));
+
+  // Components inserted into a loaded tensor are added to the loaded ones
+  loaded.insert({1, 2, 3}, 1.0);
+  expected[{1, 2, 3}] += 1.0;
+  loaded.pack();
+  numComponents = 0;
+  for (auto& value : loaded) {
+    ASSERT_EQ(expected.at(value.first.toVector()), value.second);
+    numComponents++;
+  }
+  ASSERT_EQ(expected.size(), numComponents);
+  remove(filename.c_str());
+}
+
+TEST(io, taco_corrupt) {
+  // Files whose index arrays point past each other or past the dimensions are
+  // rejected instead of being handed to kernels.
+  const std::string filename = util::getTmpdir() + "corrupt.taco";
+  const vector<double> vals = {1.0, 2.0, 3.0};
+  const vector<vector<int>> rowptrs = {{0, 2, 1, 3}, {0, 1, 2, 4}, {0, 1, 2, 3}};
+  const vector<vector<int>> colidxs = {{0, 1, 2},    {0, 1, 2},    {0, 1, 3}};
+  for (size_t i = 0; i < rowptrs.size(); i++) {
+    write(filename, makeCSR("A", {3, 3}, rowptrs[i], colidxs[i], vals));
+    ASSERT_THROW(read(filename, CSR), taco::TacoException);
+  }
+
+  write(filename, makeCSR("A", {3, 3}, rowptrs.back(), {0, 1, 2}, vals));
+  Tensor<double> loaded = read(filename, CSR);
+  ASSERT_EQ(3.0, (double)loaded(2, 2));
+  remove(filename.c_str());
+}
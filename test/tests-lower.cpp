@@ -303,6 +303,28 @@ TEST_P(lower, compile) {
       else
         verifyResults(results, arguments, varsFormatted, expected);
     }
+
+    {
+      SCOPED_TRACE("Batched Assembly and Compute\n");
+      vector<vector<TensorStorage>> batch;
+      for (int b = 0; b < 4; b++) {
+        vector<TensorStorage> batchArguments = arguments;
+        for (size_t i = 0; i < results.size(); i++) {
+          Format format = varsFormatted.at(results[i]).getFormat();
+          batchArguments[i] = testCase.getResult(results[i], format);
+        }
+        batch.push_back(batchArguments);
+      }
+      ASSERT_TRUE(kernel.assembleBatch(batch));
+      ASSERT_TRUE(kernel.computeBatch(batch));
+      ASSERT_TRUE(kernel.evaluateBatch(batch));
+      for (auto& batchArguments : batch) {
+        if (results[0].getType().getDataType().isInt())
+          verifyResultsInt(results, batchArguments, varsFormatted, expected);
+        else
+          verifyResults(results, batchArguments, varsFormatted, expected);
+      }
+    }
   }
 }
 
@@ -661,6 +661,64 @@ INSTANTIATE_TEST_CASE_P(spgemm, spgemm,
                                std::make_tuple(CSR, CSC, false),
                                std::make_tuple(DCSR, DCSC, false)));
 
+TEST(scheduling_eval, spgemmCPU_parallelAssembly) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+
+  int NUM_I = 100;
+  int NUM_J = 100;
+  int NUM_K = 100;
+  float SPARSITY = .03;
+  Tensor<double> A("A", {NUM_I, NUM_J}, CSR);
+  Tensor<double> B("B", {NUM_J, NUM_K}, CSR);
+  Tensor<double> C("C", {NUM_I, NUM_K}, CSR);
+
+  srand(75883);
+  for (int i = 0; i < NUM_I; i++) {
+    for (int j = 0; j < NUM_J; j++) {
+      float rand_float = (float)rand()/(float)(RAND_MAX);
+      if (rand_float < SPARSITY) {
+        A.insert({i, j}, (double) ((int) (rand_float*3/SPARSITY)));
+      }
+    }
+  }
+
+  for (int j = 0; j < NUM_J; j++) {
+    for (int k = 0; k < NUM_K; k++) {
+      float rand_float = (float)rand()/(float)(RAND_MAX);
+      if (rand_float < SPARSITY) {
+        B.insert({j, k}, (double) ((int) (rand_float*3/SPARSITY)));
+      }
+    }
+  }
+
+  A.pack();
+  B.pack();
+
+  C(i, k) = A(i, j) * B(j, k);
+  IndexStmt stmt = C.getAssignment().concretize();
+  stmt = scheduleSpGEMMCPU(stmt, true);
+
+  // The row counts are stored in parallel and prefix summed in parallel, 
+  // rather than accumulated into the pos array one row at a time.
+  C.compile(stmt);
+  std::string source = C.getSource();
+  ASSERT_NE(source.find("C2_pos[i] = C2_nnz[i];"), std::string::npos);
+  ASSERT_NE(source.find("C2_pos[C1_dimension] = "
+                        "taco_prefixSum_int32_t(C2_pos, C1_dimension);"),
+            std::string::npos);
+  C.assemble();
+  C.compute();
+
+  Tensor<double> expected("expected", {NUM_I, NUM_K}, {Dense, Dense});
+  expected(i, k) = A(i, j) * B(j, k);
+  expected.compile();
+  expected.assemble();
+  expected.compute();
+  ASSERT_TENSOR_EQ(expected, C);
+}
+
 TEST(scheduling_eval, spmataddCPU) {
   if (should_use_CUDA_codegen()) {
     return;
@@ -535,6 +535,149 @@ TEST(scheduling, parallelizeTemporaryReduction) {
 //  codegen->compile(compute, true);
 }
 
+TEST(scheduling, parallelizeBalanced) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+
+  // One row holds most of the nonzeros, and some rows are empty
+  const int n = 100;
+  Tensor<double> x("x", {n}, Format({Dense}));
+  for (int j = 0; j < n; j++) {
+    x.insert({j}, (double) j);
+  }
+  x.pack();
+
+  IndexVar i("i"), j("j");
+  for (const Format& format : {CSR, DCSR}) {
+    Tensor<double> A("A", {n, n}, format);
+    for (int j = 0; j < n; j++) {
+      A.insert({7, j}, 1.0 + j);
+    }
+    for (int i = 0; i < n; i += 3) {
+      A.insert({i, (i * 11) % n}, 2.0);
+    }
+    A.pack();
+
+    Tensor<double> y("y", {n}, Format({Dense}));
+    y(i) = A(i, j) * x(j);
+    IndexStmt stmt = y.getAssignment().concretize()
+        .parallelize(i, ParallelUnit::CPUThreadBalanced,
+                     OutputRaceStrategy::NoRaces);
+    y.compile(stmt);
+    y.assemble();
+    y.compute();
+    ASSERT_NE(std::string::npos, y.getSource().find("taco_binarySearchAfter"));
+    // Rows such as row 7 can be split between threads
+    ASSERT_NE(std::string::npos, y.getSource().find("_carries"));
+
+    Tensor<double> expected("expected", {n}, Format({Dense}));
+    expected(i) = A(i, j) * x(j);
+    expected.evaluate();
+    ASSERT_TENSOR_EQ(expected, y);
+  }
+}
+
+TEST(scheduling, parallelizeBalancedThreads) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+
+  // Build the kernels with OpenMP and run them on 4 threads. Rows 7 and 50
+  // hold more nonzeros than a thread's share, so they are split between
+  // threads and computed partly into the carries.
+  const int n = 100;
+  const int numThreads = taco_get_num_threads();
+  taco_set_num_threads(4);
+  setenv("OMP_NUM_THREADS", "4", 1);
+  setenv("TACO_CFLAGS", "-O3 -ffast-math -std=c99 -fopenmp", 1);
+  setenv("CACHE_KERNELS", "0", 1);
+
+  Tensor<double> x("x", {n}, Format({Dense}));
+  for (int j = 0; j < n; j++) {
+    x.insert({j}, (double) j);
+  }
+  x.pack();
+
+  IndexVar i("i"), j("j");
+  for (const Format& format : {CSR, DCSR}) {
+    Tensor<double> A("A", {n, n}, format);
+    for (int j = 0; j < n; j++) {
+      A.insert({7, j}, 1.0 + j);
+      A.insert({50, j}, 2.0 * j);
+    }
+    for (int i = 0; i < n; i += 3) {
+      A.insert({i, (i * 11) % n}, 2.0);
+    }
+    A.pack();
+
+    Tensor<double> y("y", {n}, Format({Dense}));
+    y(i) = A(i, j) * x(j);
+    IndexStmt stmt = y.getAssignment().concretize()
+        .parallelize(i, ParallelUnit::CPUThreadBalanced,
+                     OutputRaceStrategy::NoRaces);
+    y.compile(stmt);
+    y.assemble();
+    y.compute();
+    ASSERT_NE(std::string::npos, y.getSource().find("_carries"));
+
+    Tensor<double> expected("expected", {n}, Format({Dense}));
+    expected(i) = A(i, j) * x(j);
+    expected.evaluate();
+    ASSERT_TENSOR_EQ(expected, y);
+  }
+
+  unsetenv("CACHE_KERNELS");
+  unsetenv("TACO_CFLAGS");
+  unsetenv("OMP_NUM_THREADS");
+  taco_set_num_threads(numThreads);
+}
+
+TEST(scheduling, parallelizePrivatize) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+
+  const int n = 100;
+  Tensor<double> A("A", {n, n}, CSR);
+  Tensor<double> x("x", {n}, Format({Dense}));
+  for (int i = 0; i < n; i++) {
+    A.insert({i, (i * 7) % n}, 1.0 + i);
+    A.insert({i, (i * 11 + 3) % n}, 2.0);
+    x.insert({i}, (double) i);
+  }
+  A.pack();
+  x.pack();
+
+  // Every row of A is added into the rows of y that its columns index, so the
+  // threads race on y
+  IndexVar i("i"), j("j");
+  Tensor<double> y("y", {n}, Format({Dense}));
+  y(j) = A(i, j) * x(i);
+  IndexStmt stmt = y.getAssignment().concretize().reorder({i, j})
+      .parallelize(i, ParallelUnit::CPUThread, OutputRaceStrategy::Privatize);
+  y.compile(stmt);
+  ASSERT_NE(std::string::npos, y.getSource().find("taco_arenaBuffer"));
+
+  Tensor<double> expected("expected", {n}, Format({Dense}));
+  expected(j) = A(i, j) * x(i);
+  expected.evaluate();
+
+  // The private copies must be left zeroed for the next call
+  for (int call = 0; call < 2; call++) {
+    y.assemble();
+    y.compute();
+    ASSERT_TENSOR_EQ(expected, y);
+  }
+
+  Tensor<double> z("z", {n}, Format({Sparse}));
+  z(j) = A(i, j) * x(i);
+  IndexStmt sparseStmt = z.getAssignment().concretize().reorder({i, j});
+  ASSERT_THROW(sparseStmt.parallelize(i, ParallelUnit::CPUThread,
+                                      OutputRaceStrategy::Privatize),
+               taco::TacoException);
+}
+
 TEST(scheduling, multilevel_tiling) {
   Tensor<double> A("A", {8}, Format({Sparse}));
   Tensor<double> B("B", {8}, Format({Sparse}));
@@ -1102,6 +1245,10 @@ TEST(scheduling, mergeby) {
     return stmt.mergeby(j, MergeStrategy::TwoFinger);
   });
 
+  test([&](IndexStmt stmt) {
+    return stmt.mergeby(j, MergeStrategy::SimdGallop);
+  });
+
   // Merging a dimension with a dense iterator with Gallop should be no-op.
   test([&](IndexStmt stmt) {
     return stmt.mergeby(i, MergeStrategy::Gallop);
@@ -1125,6 +1272,86 @@ TEST(scheduling, mergeby) {
   });
 }
 
+TEST(scheduling, mergeby_simd_gallop) {
+  // Intersect vectors whose coordinates are far apart and close together, so
+  // that the iterators gallop over many blocks, within the last block, and
+  // over the tail of the vectors that is shorter than a block.
+  const int dim = 1000;
+  Tensor<double> a("a", {dim}, Format({Sparse}));
+  Tensor<double> b("b", {dim}, Format({Sparse}));
+  for (int i = 0; i < dim; i++) {
+    if (i % 3 == 0 || i > 990) {
+      a.insert({i}, (double)i);
+    }
+    if (i % 97 == 0 || (i > 500 && i < 520) || i == dim - 1) {
+      b.insert({i}, 2.0);
+    }
+  }
+  a.pack();
+  b.pack();
+
+  IndexVar i("i");
+  Tensor<double> y("y", {dim}, Format({Dense}));
+  y(i) = a(i) * b(i);
+  IndexStmt stmt = y.getAssignment().concretize();
+  y.compile(stmt.mergeby(i, MergeStrategy::SimdGallop));
+  y.assemble();
+  y.compute();
+  ASSERT_NE(std::string::npos, y.getSource().find("taco_simdGallop("));
+
+  Tensor<double> expected("expected", {dim}, Format({Dense}));
+  expected(i) = a(i) * b(i);
+  expected.evaluate();
+  ASSERT_TRUE(equals(expected, y));
+}
+
+TEST(scheduling, mergeby_simd_intersect) {
+  // Intersect vectors with index arrays of each width, so that blocks of the
+  // coordinates are compared against each other both with the default flags
+  // and, if the machine has it, with AVX2.
+  const int dim = 250;
+  std::vector<std::string> flags = {"-O3 -ffast-math -std=c99"};
+  if (__builtin_cpu_supports("avx2")) {
+    flags.push_back("-O3 -ffast-math -std=c99 -mavx2");
+  }
+  setenv("CACHE_KERNELS", "0", 1);
+  for (auto& cflags : flags) {
+    setenv("TACO_CFLAGS", cflags.c_str(), 1);
+    for (Datatype type : {UInt8, Int16, Int32, UInt32, Int64}) {
+      Format format({Sparse});
+      format.setLevelArrayTypes({{Int32, type}});
+      Tensor<double> a("a", {dim}, format);
+      Tensor<double> b("b", {dim}, format);
+      for (int i = 0; i < dim; i++) {
+        if (i % 3 == 0 || (i > 100 && i < 140)) {
+          a.insert({i}, (double)i);
+        }
+        if (i % 7 == 0 || (i > 120 && i < 160) || i > 240) {
+          b.insert({i}, 2.0);
+        }
+      }
+      a.pack();
+      b.pack();
+
+      IndexVar i("i");
+      Tensor<double> y("y", {dim}, Format({Dense}));
+      y(i) = a(i) * b(i);
+      IndexStmt stmt = y.getAssignment().concretize();
+      y.compile(stmt.mergeby(i, MergeStrategy::SimdGallop));
+      y.assemble();
+      y.compute();
+      ASSERT_NE(std::string::npos, y.getSource().find("taco_simdIntersect_"));
+
+      Tensor<double> expected("expected", {dim}, Format({Dense}));
+      expected(i) = a(i) * b(i);
+      expected.evaluate();
+      ASSERT_TRUE(equals(expected, y)) << type << " " << cflags;
+    }
+  }
+  unsetenv("TACO_CFLAGS");
+  unsetenv("CACHE_KERNELS");
+}
+
 TEST(scheduling, mergeby_gallop_error) {
   Tensor<double> x("x", {8}, Format({Sparse}));
   Tensor<double> y("y", {8}, Format({Dense}));
@@ -0,0 +1,105 @@
+#include "test.h"
+#include "taco/tensor.h"
+#include "taco/streaming.h"
+#include "taco/util/env.h"
+
+#include <fstream>
+#include <sys/stat.h>
+
+using namespace taco;
+
+static std::string makeChunkDirectory(std::string name) {
+  std::string directory = util::getTmpdir() + name;
+  mkdir(directory.c_str(), 0700);
+  return directory;
+}
+
+// spmv streams a CSR matrix in chunks that do not divide its rows evenly and
+// that include an empty chunk, and compares with the in-memory product.
+TEST(streaming, spmv) {
+  Tensor<double> A("A", {50, 40}, CSR);
+  Tensor<double> x("x", {40}, Format({Dense}));
+  for (int n = 0; n < 300; n++) {
+    int i = (n * 7) % 50;
+    if (i < 16 || i >= 24) {
+      A.insert({i, (n * 13) % 40}, (double)n);
+    }
+  }
+  for (int j = 0; j < 40; j++) {
+    x.insert({j}, (double)(j + 1));
+  }
+  A.pack();
+  x.pack();
+
+  ChunkedTensor chunked = writeChunked(makeChunkDirectory("spmv"), A, 8);
+  ASSERT_EQ(7, chunked.getNumChunks());
+  ASSERT_EQ(48, chunked.getChunkBegin(6));
+  ASSERT_EQ(50, chunked.getChunkEnd(6));
+
+  Tensor<double> y("y", {50}, Format({Dense}));
+  multiplyChunked(y, chunked, x);
+
+  IndexVar i, j;
+  Tensor<double> expected("expected", {50}, Format({Dense}));
+  expected(i) = A(i,j) * x(j);
+  expected.evaluate();
+  ASSERT_TENSOR_EQ(expected, y);
+}
+
+// spmm streams a CSR matrix times a dense matrix.
+TEST(streaming, spmm) {
+  Tensor<double> A("A", {30, 20}, CSR);
+  Tensor<double> B("B", {20, 6}, Format({Dense, Dense}));
+  for (int n = 0; n < 150; n++) {
+    A.insert({(n * 7) % 30, (n * 11) % 20}, (double)(n % 9) - 4.0);
+  }
+  for (int j = 0; j < 20; j++) {
+    for (int k = 0; k < 6; k++) {
+      B.insert({j, k}, (double)(j * 6 + k));
+    }
+  }
+  A.pack();
+  B.pack();
+
+  ChunkedTensor chunked = writeChunked(makeChunkDirectory("spmm"), A, 7);
+  Tensor<double> C("C", {30, 6}, Format({Dense, Dense}));
+  multiplyChunked(C, chunked, B);
+
+  IndexVar i, j, k;
+  Tensor<double> expected("expected", {30, 6}, Format({Dense, Dense}));
+  expected(i,k) = A(i,j) * B(j,k);
+  expected.evaluate();
+  ASSERT_TENSOR_EQ(expected, C);
+}
+
+// Matrices without components are written as empty chunks. A matrix without
+// rows is written as a single empty chunk, whose manifest can be read back.
+TEST(streaming, empty) {
+  Tensor<double> A("A", {20, 10}, CSR);
+  Tensor<double> x("x", {10}, Format({Dense}));
+  A.pack();
+  x.pack();
+
+  const std::string directory = makeChunkDirectory("empty");
+  ChunkedTensor chunked = writeChunked(directory, A, 8);
+  ASSERT_EQ(3, chunked.getNumChunks());
+  Tensor<double> y("y", {20}, Format({Dense}));
+  multiplyChunked(y, chunked, x);
+  for (auto& value : iterate<double>(y)) {
+    ASSERT_EQ(0.0, value.second);
+  }
+
+  // Tensors cannot have dimensions of size 0 when assertions are enabled, so
+  // write the manifest that writeChunked writes for them.
+  {
+    std::ofstream manifest(directory + "/manifest");
+    manifest << "taco-chunked" << std::endl;
+    manifest << "2 0 10" << std::endl;
+    manifest << "1 0 0" << std::endl;
+  }
+  ChunkedTensor noRows(directory);
+  ASSERT_EQ(1, noRows.getNumChunks());
+  ASSERT_EQ(0, noRows.getChunkBegin(0));
+  ASSERT_EQ(0, noRows.getChunkEnd(0));
+  ASSERT_EQ(CSR, noRows.getFormat());
+}
@@ -1,10 +1,16 @@
 #include "test.h"
 #include "taco/component.h"
 #include "taco/tensor.h"
+#include "taco/lower/lower.h"
+#include "taco/util/env.h"
 #include "test_tensors.h"
 
+#include <algorithm>
+#include <dirent.h>
+#include <fstream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 #include "taco/util/collections.h"
 
@@ -107,6 +113,71 @@ TEST(tensor, non_zero_fill) {
   testFill<double>(std::numeric_limits<double>::infinity());
 }
 
+TEST(tensor, pack_unsorted) {
+  // Insert components out of order and with duplicates into a tensor with a
+  // permuted mode ordering and check that pack sorts and merges them.
+  Tensor<double> a({50, 7, 300}, Format({Sparse, Dense, Sparse}, {2, 0, 1}));
+  map<vector<int>,double> expected;
+  for (int n = 0; n < 2000; n++) {
+    vector<int> coord = {(n * 37) % 50, (n * 11) % 7, (n * 101) % 300};
+    a.insert(coord, (double)n);
+    expected[coord] += (double)n;
+  }
+  a.pack();
+
+  size_t numComponents = 0;
+  vector<int> previous;
+  for (auto& value : iterate<double>(a)) {
+    vector<int> coord = value.first.toVector();
+    vector<int> stored = {coord[2], coord[0], coord[1]};
+    ASSERT_TRUE(previous.empty() || previous < stored);
+    ASSERT_EQ(expected.at(coord), value.second);
+    previous = stored;
+    numComponents++;
+  }
+  ASSERT_EQ(expected.size(), numComponents);
+}
+
+TEST(tensor, pack_incremental) {
+  // Insert components into an already packed tensor, some of which overlap
+  // packed components, and check that repacking merges and sums them. The
+  // dense and compressed formats are spliced and COO is merged and repacked.
+  vector<Format> formats = {Format({Sparse, Sparse}, {1, 0}),
+                            Format({Dense, Sparse}),
+                            Format({Sparse, Dense}),
+                            COO(2)};
+  for (auto& format : formats) {
+    SCOPED_TRACE(util::toString(format));
+    Tensor<double> a({40, 30}, format);
+    map<vector<int>,double> expected;
+    for (int round = 0; round < 3; round++) {
+      for (int n = 0; n < 500; n++) {
+        vector<int> coord = {(n * 13 + round) % 40, (n * 7) % 30};
+        a.insert(coord, (double)(n + round));
+        expected[coord] += (double)(n + round);
+      }
+      a.pack();
+    }
+
+    size_t numComponents = 0;
+    vector<int> previous;
+    for (auto& value : iterate<double>(a)) {
+      vector<int> coord = value.first.toVector();
+      vector<int> stored = {coord[format.getModeOrdering()[0]],
+                            coord[format.getModeOrdering()[1]]};
+      ASSERT_TRUE(previous.empty() || previous < stored);
+      previous = stored;
+      if (expected.count(coord)) {
+        ASSERT_EQ(expected.at(coord), value.second);
+        numComponents++;
+      } else {
+        ASSERT_EQ(0.0, value.second);
+      }
+    }
+    ASSERT_EQ(expected.size(), numComponents);
+  }
+}
+
 TEST(tensor, transpose) {
   TensorData<double> testData = TensorData<double>({5, 3, 2}, {
     {{0,0,0}, 0.0},
@@ -139,6 +210,60 @@ TEST(tensor, transpose) {
   ASSERT_TRUE(equals(tensor.transpose({0,1,2}), tensor));
 }
 
+TEST(tensor, convert) {
+  Tensor<double> A("A", {7, 9}, CSR);
+  for (int n = 0; n < 30; n++) {
+    A.insert({(n * 3) % 7, (n * n) % 9}, (double)n + 1.0);
+  }
+  A.pack();
+  for (const Format& format : {CSC, DCSR, DCSC, Format({Dense, Dense}),
+                               Format({Dense, Dense}, {1,0}), COO(2),
+                               COO(2, true, true, false, {1,0}),
+                               Format({Sparse, Dense})}) {
+    TensorBase converted = A.convert(format);
+    ASSERT_EQ(format, converted.getFormat());
+
+    // The conversion packs the same storage as inserting the components
+    Tensor<double> expected("expected", {7, 9}, format);
+    for (auto& component : A) {
+      expected.insert(component.first.toVector(), component.second);
+    }
+    expected.pack();
+    ASSERT_TRUE(equals(expected, converted));
+    ASSERT_EQ(expected.getStorage().getValues().getSize(),
+              converted.getStorage().getValues().getSize());
+    ASSERT_TRUE(equals(converted.convert(CSR), A));
+  }
+
+  // Columns of a CSC conversion are compressed from the column histogram
+  TensorBase B = A.convert(CSC);
+  Tensor<double> Bexpected = A.transpose({0,1}, CSC);
+  const Array& pos = B.getStorage().getIndex().getModeIndex(1).getIndexArray(0);
+  const Array& posExpected =
+      Bexpected.getStorage().getIndex().getModeIndex(1).getIndexArray(0);
+  ASSERT_EQ(posExpected.getSize(), pos.getSize());
+  for (size_t p = 0; p < pos.getSize(); p++) {
+    ASSERT_EQ(posExpected.get(p).getAsIndex(), pos.get(p).getAsIndex());
+  }
+
+  Tensor<double> C("C", {4, 5, 6}, Format({Sparse, Sparse, Sparse}));
+  for (int n = 0; n < 40; n++) {
+    C.insert({n % 4, (n * 7) % 5, (n * 5) % 6}, (double)n);
+  }
+  C.pack();
+  for (const Format& format : {Format({Sparse, Sparse, Sparse}, {2,0,1}),
+                               Format({Dense, Sparse, Dense}, {1,2,0}),
+                               COO(3)}) {
+    TensorBase converted = C.convert(format);
+    ASSERT_EQ(format, converted.getFormat());
+    ASSERT_TRUE(equals(C, converted.convert(C.getFormat())));
+  }
+
+  // Formats without a direct conversion are repacked (hashed levels are
+  // iterated out of order, so they are compared in CSR)
+  ASSERT_TRUE(equals(A, A.convert(Format({Dense, Hashed})).convert(CSR)));
+}
+
 TEST(tensor, operator_parens_insertion) {
   Tensor<double> a({5,5}, Sparse);
   a(1,2) = 42.0;
@@ -519,3 +644,246 @@ TEST(tensor, cache) {
   // ability to answer a request for the first query.
   c(i, j) = a(i, j); c.evaluate();
 }
+
+TEST(tensor, cache_stats) {
+  TensorBase::clearComputeKernelCache();
+  IndexVar i("i");
+  Tensor<double> a("a", {3}, {Dense});
+  Tensor<double> b("b", {3}, {Dense});
+  Tensor<double> c("c", {3}, {Dense});
+  Tensor<double> d("d", {3}, {Dense});
+  b(i) = a(i) * 2.0; b.evaluate();
+  // Isomorphic to the first statement, so it should reuse the kernel.
+  d(i) = c(i) * 2.0; d.evaluate();
+
+  KernelCacheStats stats = TensorBase::getComputeKernelCacheStats();
+  ASSERT_EQ(1u, stats.hits);
+  ASSERT_EQ(1u, stats.misses);
+  ASSERT_EQ(1u, stats.size);
+
+  TensorBase::setComputeKernelCacheCapacity(1);
+  for (int n = 0; n < 32; n++) {
+    b(i) = a(i) * (double)n + 3.0; b.evaluate();
+  }
+  stats = TensorBase::getComputeKernelCacheStats();
+  TensorBase::setComputeKernelCacheCapacity(0);
+  ASSERT_GT(stats.evictions, 0u);
+  ASSERT_LE(stats.size, 1u);
+}
+
+TEST(tensor, compile_async) {
+  IndexVar i("i");
+  Tensor<double> a("a", {3}, {Dense});
+  a.insert({0}, 1.0);
+  a.insert({1}, 2.0);
+  a.insert({2}, 3.0);
+  a.pack();
+
+  // Compile several distinct kernels concurrently.
+  std::vector<Tensor<double>> results;
+  for (int n = 0; n < 4; n++) {
+    Tensor<double> result({3}, {Dense});
+    result(i) = a(i) * (double)n + 0.5;
+    result.compileAsync();
+    results.push_back(result);
+  }
+  for (int n = 0; n < 4; n++) {
+    results[n].assemble();
+    results[n].compute();
+    ASSERT_EQ(2.0 * n + 0.5, results[n].at({1}));
+  }
+
+  Tensor<double> b({3}, {Dense});
+  b(i) = a(i) + a(i);
+  b.compileAsync().get();
+  ASSERT_FALSE(b.needsCompile());
+  b.evaluate();
+  ASSERT_EQ(6.0, b.at({2}));
+}
+
+TEST(tensor, concurrent_compute) {
+  IndexVar i("i");
+  Tensor<double> a("a", {3}, {Dense});
+  a.insert({0}, 1.0);
+  a.insert({1}, 2.0);
+  a.insert({2}, 3.0);
+  a.pack();
+
+  // Computing results of the same operand concurrently removes them from the
+  // operand's dependents concurrently.
+  std::vector<Tensor<double>> results;
+  for (int n = 0; n < 8; n++) {
+    Tensor<double> result({3}, {Dense});
+    result(i) = a(i) * (double)n;
+    result.compile();
+    result.assemble();
+    results.push_back(result);
+  }
+  std::vector<std::thread> threads;
+  for (int n = 0; n < 8; n++) {
+    threads.emplace_back([&results, n]() { results[n].compute(); });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (int n = 0; n < 8; n++) {
+    ASSERT_EQ(3.0 * n, results[n].at({2}));
+  }
+  ASSERT_TRUE(a.getDependentTensors().empty());
+}
+
+TEST(tensor, persistent_cache) {
+  const std::string cachedir = util::getTmpdir() + "kernel_cache/";
+  setenv("TACO_CACHE_DIR", cachedir.c_str(), 1);
+
+  IndexVar i("i");
+  TensorVar a("a", Type(Float64, {3}), Format({Dense}));
+  TensorVar b("b", Type(Float64, {3}), Format({Dense}));
+  IndexStmt stmt = makeConcreteNotation(b(i) = a(i));
+  ir::Stmt compute = lower(stmt, "compute", false, true);
+
+  // The first module populates the cache and the second one loads the
+  // library it published instead of invoking the compiler.
+  ir::Module first;
+  first.addFunction(compute);
+  const std::string firstPath = first.compile();
+  ir::Module second;
+  second.addFunction(compute);
+  const std::string secondPath = second.compile();
+
+  // A library whose recorded source differs from the module's, as if their
+  // keys collided, is not loaded
+  const std::string keyPath =
+      secondPath.substr(0, secondPath.size() - 3) + ".key";
+  std::ofstream(keyPath, std::ios::binary) << "another kernel";
+  ir::Module third;
+  third.addFunction(compute);
+  const std::string thirdPath = third.compile();
+  unsetenv("TACO_CACHE_DIR");
+
+  ASSERT_NE(0u, firstPath.find(cachedir));
+  ASSERT_EQ(0u, secondPath.find(cachedir));
+  ASSERT_NE(nullptr, second.getFuncPtr("compute"));
+  ASSERT_NE(0u, thirdPath.find(cachedir));
+  ASSERT_NE(nullptr, third.getFuncPtr("compute"));
+}
+
+TEST(tensor, arena_release) {
+  // A kernel that privatizes its result in the workspace arenas is called
+  // from several threads, whose arenas are freed as they exit. The arenas and
+  // their keys are then released, as before unloading the code, after which
+  // calls create them again.
+  const int n = 50;
+  const int numThreads = 4;
+  Tensor<double> A("A", {n, n}, CSR);
+  Tensor<double> x("x", {n}, Format({Dense}));
+  for (int i = 0; i < n; i++) {
+    A.insert({i, (i * 7) % n}, 1.0 + i);
+    A.insert({i, (i * 11 + 3) % n}, 2.0);
+    x.insert({i}, (double) i);
+  }
+  A.pack();
+  x.pack();
+
+  IndexVar i("i"), j("j");
+  Tensor<double> expected("expected", {n}, Format({Dense}));
+  expected(j) = A(i, j) * x(i);
+  expected.evaluate();
+
+  std::vector<Tensor<double>> ys;
+  IndexStmt stmt;
+  for (int t = 0; t < numThreads; t++) {
+    Tensor<double> y("y", {n}, Format({Dense}));
+    y(j) = A(i, j) * x(i);
+    stmt = y.getAssignment().concretize().reorder({i, j})
+        .parallelize(i, ParallelUnit::CPUThread, OutputRaceStrategy::Privatize);
+    y.compile(stmt);
+    y.assemble();
+    y.compute();
+    ys.push_back(y);
+  }
+  ASSERT_EQ(2u, getArguments(stmt).size());
+  ASSERT_EQ(A.getTensorVar(), getArguments(stmt)[0]);
+
+  ir::Module module;
+  module.addFunction(lower(stmt, "compute", false, true));
+  module.compile();
+  ASSERT_NE(std::string::npos, module.getSource().find("taco_arenaBuffer"));
+  void (*release)(void);
+  void (*retain)(void);
+  *reinterpret_cast<void**>(&release) = module.getFuncPtr("taco_arenaRelease");
+  *reinterpret_cast<void**>(&retain) = module.getFuncPtr("taco_arenaRetain");
+  ASSERT_NE(nullptr, (void*)release);
+  ASSERT_NE(nullptr, (void*)retain);
+
+  // Compute into y with the module's kernel, overwriting the results first
+  auto call = [&](Tensor<double> y) {
+    double* vals = (double*)y.getStorage().getValues().getData();
+    std::fill(vals, vals + n, -1.0);
+    std::vector<void*> args = {y.getStorage(), A.getStorage(), x.getStorage()};
+    return module.callFuncPacked("compute", args.data());
+  };
+  auto callFromThreads = [&]() {
+    std::vector<int> results(numThreads, -1);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+      threads.emplace_back([&, t]() {
+        results[t] = call(ys[t]);
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (int t = 0; t < numThreads; t++) {
+      ASSERT_EQ(0, results[t]);
+      ASSERT_TENSOR_EQ(expected, ys[t]);
+    }
+  };
+
+  callFromThreads();
+  // The calling thread's arena is still in use when it is released
+  ASSERT_EQ(0, call(ys[0]));
+  release();
+  callFromThreads();
+  ASSERT_EQ(0, call(ys[0]));
+  ASSERT_TENSOR_EQ(expected, ys[0]);
+  retain();
+}
+
+TEST(tensor, tcc_backend) {
+  IndexVar i("i");
+  TensorVar a("a", Type(Float64, {3}), Format({Dense}));
+  TensorVar b("b", Type(Float64, {3}), Format({Dense}));
+  IndexStmt stmt = makeConcreteNotation(b(i) = a(i));
+
+  Target target = getTargetFromEnvironment();
+  target.backend = Target::TCC;
+  ir::Module module(target);
+  module.addFunction(lower(stmt, "compute", false, true));
+
+  auto countFiles = []() {
+    size_t count = 0;
+    DIR* dir = opendir(util::getTmpdir().c_str());
+    while (dir && readdir(dir)) {
+      count++;
+    }
+    if (dir) {
+      closedir(dir);
+    }
+    return count;
+  };
+  size_t filesBefore = countFiles();
+  string library = module.compile();
+#ifdef TACO_TCC
+  // Nothing is written to disk when the kernel is compiled in-process.
+  ASSERT_EQ("", library);
+  ASSERT_EQ(filesBefore, countFiles());
+#else
+  // Builds without libtcc fall back to the system compiler, which writes
+  // out the source, header and library.
+  ASSERT_NE("", library);
+  ASSERT_EQ(filesBefore + 3, countFiles());
+#endif
+  ASSERT_NE(nullptr, module.getFuncPtr("compute"));
+  ASSERT_NE(nullptr, module.getFuncPtr("_shim_compute"));
+}
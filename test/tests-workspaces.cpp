@@ -606,3 +606,138 @@ TEST(workspaces, tile_dotProduct_3) {
   expected.compute();
   ASSERT_TENSOR_EQ(expected, A);
 }
+
+TEST(workspaces, arena) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+
+  int N = 32;
+  Tensor<double> A("A", {N, N}, CSR);
+  Tensor<double> B("B", {N, N}, CSR);
+  Tensor<double> C("C", {N, N}, CSR);
+  for (int i = 0; i < N; i++) {
+    B.insert({i, (i * 7) % N}, (double) i);
+    B.insert({i, (i * 5 + 1) % N}, 2.0);
+    C.insert({i, (i * 3) % N}, 3.0);
+    C.insert({i, (i * 11 + 2) % N}, (double) i);
+  }
+  B.pack();
+  C.pack();
+
+  IndexVar i("i"), j("j"), k("k");
+  IndexExpr precomputedExpr = B(i, j) * C(j, k);
+  A(i, k) = precomputedExpr;
+
+  TensorVar w("w", Type(Float64, {(size_t)N}), taco::dense);
+  IndexStmt stmt = A.getAssignment().concretize().reorder({i, j, k})
+      .precompute(precomputedExpr, k, k, w);
+  A.compile(stmt);
+
+  // The workspace and its guards are kept in the arena of the generated code
+  // rather than allocated and freed by every call
+  std::string source = A.getSource();
+  ASSERT_NE(std::string::npos, source.find("taco_arenaBuffer"));
+  ASSERT_NE(std::string::npos, source.find("taco_arenaZeroedBuffer"));
+  ASSERT_EQ(std::string::npos, source.find("free(w"));
+
+  Tensor<double> expected("expected", {N, N}, CSR);
+  expected(i, k) = B(i, j) * C(j, k);
+  expected.evaluate();
+  for (int call = 0; call < 2; call++) {
+    A.assemble();
+    A.compute();
+    ASSERT_TENSOR_EQ(expected, A);
+  }
+}
+
+TEST(workspaces, bitGuards) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+
+  for (int N : {200, 5000}) {
+    Tensor<double> A("A", {N, N}, CSR);
+    Tensor<double> B("B", {N, N}, CSR);
+    Tensor<double> C("C", {N, N}, CSR);
+    for (int i = 0; i < N; i++) {
+      B.insert({i, (i * 7) % N}, (double) i);
+      B.insert({i, (i * 5 + 1) % N}, 2.0);
+      C.insert({i, (i * 3) % N}, 3.0);
+      C.insert({i, (i * 11 + 2) % N}, (double) i);
+    }
+    B.pack();
+    C.pack();
+
+    IndexVar i("i"), j("j"), k("k");
+    IndexExpr precomputedExpr = B(i, j) * C(j, k);
+    A(i, k) = precomputedExpr;
+
+    TensorVar w("w", Type(Float64, {(size_t)N}), taco::dense);
+    IndexStmt stmt = A.getAssignment().concretize().reorder({i, j, k})
+        .precompute(precomputedExpr, k, k, w);
+    A.compile(stmt);
+
+    std::string source = A.getSource();
+    ASSERT_NE(std::string::npos, source.find("uint64_t* restrict w_already_set"));
+    ASSERT_NE(std::string::npos, source.find("TACO_BIT(k)"));
+
+    Tensor<double> expected("expected", {N, N}, CSR);
+    expected(i, k) = B(i, j) * C(j, k);
+    expected.evaluate();
+    for (int call = 0; call < 2; call++) {
+      A.assemble();
+      A.compute();
+      ASSERT_TENSOR_EQ(expected, A);
+    }
+  }
+}
+
+TEST(workspaces, sortIndexLists) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+
+  // The rows of the result are short, dense for the dimension, and long and
+  // sparse, so their index lists are insertion sorted, rewritten from the
+  // guard bits, and radix sorted
+  for (auto sizes : std::vector<std::pair<int,int>>{{200, 2}, {2000, 8},
+                                                    {100000, 8}}) {
+    int N = sizes.first;
+    int perRow = sizes.second;
+    int K = std::min(N, 512);
+    Tensor<double> A("A", {N, N}, CSR);
+    Tensor<double> B("B", {N, N}, CSR);
+    Tensor<double> C("C", {N, N}, CSR);
+    for (int i = 0; i < 64; i++) {
+      for (int t = 0; t < perRow; t++) {
+        B.insert({i, (i * perRow + t) % K}, (double) (i + t));
+      }
+    }
+    for (int j = 0; j < K; j++) {
+      for (int t = 0; t < perRow; t++) {
+        C.insert({j, (int)(((long long)j * 977 + t * 12347) % N)}, 2.0);
+      }
+    }
+    B.pack();
+    C.pack();
+
+    IndexVar i("i"), j("j"), k("k");
+    IndexExpr precomputedExpr = B(i, j) * C(j, k);
+    A(i, k) = precomputedExpr;
+
+    TensorVar w("w", Type(Float64, {(size_t)N}), taco::dense);
+    IndexStmt stmt = A.getAssignment().concretize().reorder({i, j, k})
+        .precompute(precomputedExpr, k, k, w);
+    A.compile(stmt);
+    ASSERT_NE(std::string::npos,
+              A.getSource().find("taco_sortIndices_int32_t(w_index_list"));
+
+    Tensor<double> expected("expected", {N, N}, CSR);
+    expected(i, k) = B(i, j) * C(j, k);
+    expected.evaluate();
+    A.assemble();
+    A.compute();
+    ASSERT_TENSOR_EQ(expected, A);
+  }
+}
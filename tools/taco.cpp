@@ -81,7 +81,7 @@ static void printFlag(string flag, string text) {
   cout << endl;
 }
 
-static const string fileFormats = "(.tns .ttx .mtx .rb)";
+static const string fileFormats = "(.tns .ttx .mtx .rb .taco)";
 
 static void printUsageInfo() {
   cout << "Usage: taco <index expression> [options]" << endl;
@@ -103,11 +103,13 @@ static void printUsageInfo() {
             "Specify the format of a tensor in the expression. Formats are "
             "specified per dimension using d (dense), s (sparse), "
             "u (sparse, not unique), q (singleton), c (singleton, not unique), "
-            "or p (singleton, padded). All formats default to dense. "
+            "p (singleton, padded), or e (sliced ELLPACK, below a dense mode; "
+            "optionally followed by a slice height and a sort window, e.g. "
+            "e8/64). All formats default to dense. "
             "The ordering of modes can also be optionally specified as a "
             "comma-delimited list of modes in the order they should be stored. "
             "Examples: A:ds (i.e., CSR), B:ds:1,0 (i.e., CSC), c:d (i.e., "
-            "dense vector), D:sss (i.e., CSF).");
+            "dense vector), D:sss (i.e., CSF), E:de8 (i.e., SELL-8-1).");
   cout << endl;
   printFlag("t=<tensor>:<data type>",
             "Specify the data type of a tensor (defaults to double)."
@@ -262,9 +264,10 @@ static void printSchedulingHelp() {
               "an output race strategy `strat`. Since the other transformations "
               "expect serial code, parallelize must come last in a series of "
               "transformations.  Possible parallel hardware units are: "
-              "NotParallel, GPUBlock, GPUWarp, GPUThread, CPUThread, CPUVector. "
+              "NotParallel, GPUBlock, GPUWarp, GPUThread, CPUThread, CPUThreadBalanced, CPUVector. "
               "Possible output race strategies are: "
-              "IgnoreRaces, NoRaces, Atomics, Temporary, ParallelReduction.");
+              "IgnoreRaces, NoRaces, Atomics, Temporary, ParallelReduction, "
+              "Privatize.");
 }
 
 static void printVersionInfo() {
@@ -279,6 +282,8 @@ static void printVersionInfo() {
     cout << "Built with Python support." << endl;
   if(TACO_FEATURE_CUDA)
     cout << "Built with CUDA support." << endl;
+  if(TACO_FEATURE_TCC)
+    cout << "Built with libtcc support." << endl;
   cout << endl;
   cout << "Built on: " << TACO_BUILD_DATE << endl;
   cout << "CMake build type: " << TACO_BUILD_TYPE << endl;
@@ -506,6 +511,8 @@ static bool setSchedulingCommands(vector<vector<string>> scheduleCommands, parse
         strategy = MergeStrategy::TwoFinger;
       } else if (strat == "Gallop") {
         strategy = MergeStrategy::Gallop;
+      } else if (strat == "SimdGallop") {
+        strategy = MergeStrategy::SimdGallop;
       } else {
         taco_uerror << "Merge strategy not defined.";
         goto end;
@@ -569,6 +576,8 @@ static bool setSchedulingCommands(vector<vector<string>> scheduleCommands, parse
         isGPU = true;
       } else if (unit == "CPUThread") {
         parallel_unit = ParallelUnit::CPUThread;
+      } else if (unit == "CPUThreadBalanced") {
+        parallel_unit = ParallelUnit::CPUThreadBalanced;
       } else if (unit == "CPUVector") {
         parallel_unit = ParallelUnit::CPUVector;
       } else {
@@ -587,6 +596,8 @@ static bool setSchedulingCommands(vector<vector<string>> scheduleCommands, parse
         output_race_strategy = OutputRaceStrategy::Temporary;
       } else if (strategy == "ParallelReduction") {
         output_race_strategy = OutputRaceStrategy::ParallelReduction;
+      } else if (strategy == "Privatize") {
+        output_race_strategy = OutputRaceStrategy::Privatize;
       } else {
         taco_uerror << "Race strategy not defined.";
         goto end;
@@ -770,11 +781,41 @@ int main(int argc, char* argv[]) {
           case 'p':
             modeTypes.push_back(ModeFormat::Singleton(ModeFormat::PADDED));
             break;
+          case 'e': {
+            // Optional slice height and sort window, e.g. e8 or e8/64
+            int sliceHeight = 8;
+            int sortWindow = 1;
+            size_t end = formatString.find_first_not_of("0123456789", i + 1);
+            end = (end == string::npos) ? formatString.size() : end;
+            if (end > (size_t)i + 1) {
+              sliceHeight = std::stoi(formatString.substr(i + 1, end - i - 1));
+              i = (int)end - 1;
+            }
+            if (end < formatString.size() && formatString[end] == '/') {
+              size_t windowEnd = formatString.find_first_not_of("0123456789",
+                                                                end + 1);
+              windowEnd = (windowEnd == string::npos) ? formatString.size()
+                                                      : windowEnd;
+              if (windowEnd == end + 1) {
+                return reportError("Incorrect format descriptor", 3);
+              }
+              sortWindow = std::stoi(formatString.substr(end + 1,
+                                                         windowEnd - end - 1));
+              i = (int)windowEnd - 1;
+            }
+            if (sliceHeight <= 0 ||
+                (sortWindow != 1 &&
+                 (sortWindow <= 0 || sortWindow % sliceHeight != 0))) {
+              return reportError("Incorrect format descriptor", 3);
+            }
+            modeTypes.push_back(SELL(sliceHeight, sortWindow).getModeFormats()[1]);
+            break;
+          }
           default:
             return reportError("Incorrect format descriptor", 3);
             break;
         }
-        modeOrdering.push_back(i);
+        modeOrdering.push_back((int)modeOrdering.size());
       }
       if (descriptor.size() > 2) {
         std::vector<std::string> modes = util::split(descriptor[2], ",");
@@ -1285,6 +1326,16 @@ int main(int argc, char* argv[]) {
       continue;
     }
 
+    // Tensors with levels that cannot be assembled into (e.g. ell levels) can
+    // only be packed by the library
+    bool isAssemblable = true;
+    for (const ModeFormat& modeFormat : tensor.getFormat().getModeFormats()) {
+      isAssemblable &= (modeFormat.hasAppend() || modeFormat.hasInsert());
+    }
+    if (!isAssemblable) {
+      continue;
+    }
+
     generatedPack.insert(tensor);
 
     std::string tensorName = tensor.getName();